@@ -0,0 +1,424 @@
+/*
+  ==============================================================================
+
+    GrainBenchmark.cpp
+    Created: 21 Oct 2026 2:18:05pm
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#include <juce_core/juce_core.h>
+#include "TapeEngine.h"
+
+#include <chrono>
+#include <iostream>
+
+//==============================================================================
+// Every allocation made on the benchmark thread while a block is being timed
+// gets counted here - the engine should never allocate while it renders.
+namespace
+{
+    std::atomic<juce::int64> numAllocations { 0 };
+    std::atomic<juce::int64> numBytesAllocated { 0 };
+    thread_local bool isCountingAllocations = false;
+}
+
+void* operator new (std::size_t size)
+{
+    if (isCountingAllocations)
+    {
+        ++numAllocations;
+        numBytesAllocated += (juce::int64) size;
+    }
+
+    if (auto* block = std::malloc (size == 0 ? 1 : size))
+        return block;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size)                 { return operator new (size); }
+void operator delete (void* block) noexcept             { std::free (block); }
+void operator delete[] (void* block) noexcept           { std::free (block); }
+void operator delete (void* block, std::size_t) noexcept    { std::free (block); }
+void operator delete[] (void* block, std::size_t) noexcept  { std::free (block); }
+
+//==============================================================================
+namespace
+{
+    /** One point of a sweep. Everything that isn't being swept stays at these defaults. */
+    struct BenchmarkConfig
+    {
+        int numVoices = 16;
+        int blockSize = 512;
+        double sampleRate = 48000.0;
+        double pitchRatio = 1.0;
+        double duration = 0.15;
+        int fluxMode = 0;           // 0 is off, 1 - 5 are the five flux modes
+        double tapeSeconds = 30.0;
+        bool coldCache = false;
+    };
+
+    struct BenchmarkResult
+    {
+        double nsPerSample = 0;
+        double nsPerVoiceSample = 0;
+        double averageLoad = 0;         // of the real-time budget, 1.0 is a full core
+        double worstBlockLoad = 0;
+        double voicesPerCore = 0;       // at the budget given on the command line
+        juce::int64 numAllocations = 0;
+        juce::int64 numBytesAllocated = 0;
+        int numBlocks = 0;
+    };
+
+    struct Options
+    {
+        double secondsPerRun = 2.0;
+        double budget = 0.5;
+        juce::String suite;
+        juce::File outputFile;
+    };
+
+    //==============================================================================
+    GrainTape::Ptr createNoiseTape (double seconds, double sampleRate)
+    {
+        auto length = (int) (seconds * sampleRate);
+        auto data = std::make_unique<juce::AudioBuffer<float>> (2, length + GrainTape::padding);
+
+        juce::Random random (1234);
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            auto* samples = data->getWritePointer (channel);
+            for (int i = 0; i < data->getNumSamples(); ++i)
+                samples[i] = random.nextFloat() * 2.0f - 1.0f;
+        }
+
+        GrainTape::Ptr tape = new GrainTape ("Noise", std::move (data), length, sampleRate);
+        tape->analyse (nullptr);
+        return tape;
+    }
+
+    /** Walks through a buffer bigger than any last level cache, so the next block starts cold. */
+    void evictCaches()
+    {
+        static std::vector<char> scratch ((size_t) 64 * 1024 * 1024);
+
+        for (size_t i = 0; i < scratch.size(); i += 64)
+            ++scratch[i];
+    }
+
+    GrainParameters createParameters (const BenchmarkConfig& config)
+    {
+        GrainParameters params;
+
+        // position mode plays every key at the same pitch, so the ratio stays the same for any number of voices
+        params.playMode = 0.0f;
+        params.transpose = juce::roundToInt (12.0 * std::log2 (config.pitchRatio));
+        params.duration = config.duration;
+
+        params.fluxModeOn = config.fluxMode > 0;
+        if (params.fluxModeOn)
+            params.fluxModes[(size_t) (config.fluxMode - 1)] = true;
+
+        return params;
+    }
+
+    /** Every voice gets its own channel and note, so none of them steals from another. */
+    void addNoteOns (juce::MidiBuffer& midi, int numVoices)
+    {
+        for (int voice = 0; voice < numVoices; ++voice)
+            midi.addEvent (juce::MidiMessage::noteOn (1 + (voice / 128) % 16, voice % 128, 0.8f), 0);
+    }
+
+    int getNumTimedBlocks (const BenchmarkConfig& config, const Options& options)
+    {
+        auto numBlocks = juce::jmax (8, (int) (options.secondsPerRun * config.sampleRate / config.blockSize));
+
+        // evicting the caches takes much longer than the block itself
+        return config.coldCache ? juce::jmin (numBlocks, 256) : numBlocks;
+    }
+
+    //==============================================================================
+    template <typename RenderFunction>
+    BenchmarkResult measure (const BenchmarkConfig& config, const Options& options, int numActiveVoices, RenderFunction&& render)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        BenchmarkResult result;
+        result.numBlocks = getNumTimedBlocks (config, options);
+
+        // warm up with a quarter of a second - the grains are all running by then
+        auto numWarmUpBlocks = juce::jmax (1, (int) (0.25 * config.sampleRate / config.blockSize));
+        for (int i = 0; i < numWarmUpBlocks; ++i)
+            render();
+
+        const double blockBudgetNs = 1.0e9 * config.blockSize / config.sampleRate;
+        double totalNs = 0;
+
+        numAllocations = 0;
+        numBytesAllocated = 0;
+
+        for (int i = 0; i < result.numBlocks; ++i)
+        {
+            if (config.coldCache)
+                evictCaches();
+
+            isCountingAllocations = true;
+            auto start = Clock::now();
+
+            render();
+
+            auto end = Clock::now();
+            isCountingAllocations = false;
+
+            auto blockNs = (double) std::chrono::duration_cast<std::chrono::nanoseconds> (end - start).count();
+            totalNs += blockNs;
+            result.worstBlockLoad = juce::jmax (result.worstBlockLoad, blockNs / blockBudgetNs);
+        }
+
+        auto numSamples = (double) result.numBlocks * config.blockSize;
+        result.nsPerSample = totalNs / numSamples;
+        result.nsPerVoiceSample = result.nsPerSample / juce::jmax (1, numActiveVoices);
+        result.averageLoad = result.nsPerSample * config.sampleRate / 1.0e9;
+        result.voicesPerCore = options.budget * 1.0e9 / config.sampleRate / result.nsPerVoiceSample;
+        result.numAllocations = numAllocations.load();
+        result.numBytesAllocated = numBytesAllocated.load();
+
+        return result;
+    }
+
+    /** The whole engine, the way the plugin's processBlock drives it. */
+    BenchmarkResult benchmarkEngine (const BenchmarkConfig& config, const Options& options)
+    {
+        TapeEngine engine (config.numVoices);
+        engine.setAdaptiveQuality (false);     // measures the full quality cost, however slow it is
+        engine.prepare (config.sampleRate, config.blockSize);
+        engine.setTape (0, createNoiseTape (config.tapeSeconds, config.sampleRate));
+
+        juce::AudioBuffer<float> buffer (2, config.blockSize);
+        auto params = createParameters (config);
+        TransportInfo transport;
+
+        juce::MidiBuffer midi;
+        addNoteOns (midi, config.numVoices);
+        engine.process (buffer, nullptr, midi, params, transport);
+
+        juce::MidiBuffer noMidi;
+        auto result = measure (config, options, config.numVoices, [&]
+        {
+            engine.process (buffer, nullptr, noMidi, params, transport);
+        });
+
+        engine.release();
+        return result;
+    }
+
+    /** A single GrainVoice::renderNextBlock call, without the synthesiser around it. */
+    BenchmarkResult benchmarkVoice (const BenchmarkConfig& config, const Options& options)
+    {
+        TapeEngine engine (1);
+        engine.prepare (config.sampleRate, config.blockSize);
+        engine.setTape (0, createNoiseTape (config.tapeSeconds, config.sampleRate));
+
+        juce::AudioBuffer<float> buffer (2, config.blockSize);
+        auto params = createParameters (config);
+        TransportInfo transport;
+
+        // one block through the engine sets the sound's parameters and starts the note
+        juce::MidiBuffer midi;
+        addNoteOns (midi, 1);
+        engine.process (buffer, nullptr, midi, params, transport);
+
+        auto* voice = engine.getSynthesiser().getVoice (0);
+        auto result = measure (config, options, 1, [&]
+        {
+            voice->renderNextBlock (buffer, 0, config.blockSize);
+        });
+
+        engine.release();
+        return result;
+    }
+
+    //==============================================================================
+    juce::var toVar (const BenchmarkConfig& config, const BenchmarkResult& result)
+    {
+        auto* object = new juce::DynamicObject();
+
+        object->setProperty ("voices", config.numVoices);
+        object->setProperty ("blockSize", config.blockSize);
+        object->setProperty ("sampleRate", config.sampleRate);
+        object->setProperty ("pitchRatio", config.pitchRatio);
+        object->setProperty ("duration", config.duration);
+        object->setProperty ("fluxMode", config.fluxMode);
+        object->setProperty ("tapeSeconds", config.tapeSeconds);
+        object->setProperty ("cache", config.coldCache ? "cold" : "warm");
+
+        object->setProperty ("nsPerSample", result.nsPerSample);
+        object->setProperty ("nsPerVoiceSample", result.nsPerVoiceSample);
+        object->setProperty ("averageLoad", result.averageLoad);
+        object->setProperty ("worstBlockLoad", result.worstBlockLoad);
+        object->setProperty ("voicesPerCore", result.voicesPerCore);
+        object->setProperty ("allocations", result.numAllocations);
+        object->setProperty ("bytesAllocated", result.numBytesAllocated);
+        object->setProperty ("blocks", result.numBlocks);
+
+        return juce::var (object);
+    }
+
+    struct Sweep
+    {
+        const char* name;
+        bool singleVoice;
+        std::vector<BenchmarkConfig> configs;
+    };
+
+    /** Each sweep changes one thing away from the defaults in BenchmarkConfig. */
+    std::vector<Sweep> createSweeps()
+    {
+        std::vector<Sweep> sweeps;
+
+        auto addSweep = [&] (const char* name, bool singleVoice, std::function<void (std::vector<BenchmarkConfig>&)> fill)
+        {
+            Sweep sweep { name, singleVoice, {} };
+            fill (sweep.configs);
+            sweeps.push_back (std::move (sweep));
+        };
+
+        addSweep ("voices", false, [] (std::vector<BenchmarkConfig>& configs)
+        {
+            for (int voices = 1; voices <= 256; voices *= 2)
+                { BenchmarkConfig c; c.numVoices = voices; configs.push_back (c); }
+        });
+
+        addSweep ("blockSize", false, [] (std::vector<BenchmarkConfig>& configs)
+        {
+            for (int blockSize = 16; blockSize <= 4096; blockSize *= 2)
+                { BenchmarkConfig c; c.blockSize = blockSize; configs.push_back (c); }
+        });
+
+        addSweep ("sampleRate", false, [] (std::vector<BenchmarkConfig>& configs)
+        {
+            for (auto sampleRate : { 44100.0, 48000.0, 96000.0, 192000.0 })
+                { BenchmarkConfig c; c.sampleRate = sampleRate; configs.push_back (c); }
+        });
+
+        addSweep ("pitchRatio", false, [] (std::vector<BenchmarkConfig>& configs)
+        {
+            for (auto ratio : { 0.25, 0.5, 1.0, 2.0, 4.0 })
+                { BenchmarkConfig c; c.pitchRatio = ratio; configs.push_back (c); }
+        });
+
+        addSweep ("duration", false, [] (std::vector<BenchmarkConfig>& configs)
+        {
+            for (auto duration : { 0.001, 0.01, 0.05, 0.15, 0.5, 1.0 })
+                { BenchmarkConfig c; c.duration = duration; configs.push_back (c); }
+        });
+
+        addSweep ("fluxMode", false, [] (std::vector<BenchmarkConfig>& configs)
+        {
+            for (int mode = 0; mode <= 5; ++mode)
+                { BenchmarkConfig c; c.fluxMode = mode; configs.push_back (c); }
+        });
+
+        addSweep ("tapeLength", false, [] (std::vector<BenchmarkConfig>& configs)
+        {
+            for (auto seconds : { 1.0, 10.0, 30.0, 180.0 })
+                { BenchmarkConfig c; c.tapeSeconds = seconds; configs.push_back (c); }
+        });
+
+        addSweep ("cache", false, [] (std::vector<BenchmarkConfig>& configs)
+        {
+            for (int voices : { 1, 16, 256 })
+                for (bool cold : { false, true })
+                    { BenchmarkConfig c; c.numVoices = voices; c.coldCache = cold; configs.push_back (c); }
+        });
+
+        addSweep ("voiceRender", true, [] (std::vector<BenchmarkConfig>& configs)
+        {
+            for (int blockSize = 16; blockSize <= 4096; blockSize *= 4)
+                for (auto ratio : { 0.5, 1.0, 2.0 })
+                    for (bool cold : { false, true })
+                        { BenchmarkConfig c; c.numVoices = 1; c.blockSize = blockSize; c.pitchRatio = ratio; c.coldCache = cold; configs.push_back (c); }
+        });
+
+        return sweeps;
+    }
+
+    bool parseOptions (const juce::StringArray& args, Options& options)
+    {
+        for (int i = 0; i < args.size(); ++i)
+        {
+            if (args[i] == "--quick")
+                options.secondsPerRun = 0.25;
+            else if (args[i] == "--seconds" && i + 1 < args.size())
+                options.secondsPerRun = juce::jmax (0.01, args[++i].getDoubleValue());
+            else if (args[i] == "--budget" && i + 1 < args.size())
+                options.budget = juce::jlimit (0.01, 1.0, args[++i].getDoubleValue());
+            else if (args[i] == "--suite" && i + 1 < args.size())
+                options.suite = args[++i];
+            else if (args[i] == "--output" && i + 1 < args.size())
+                options.outputFile = juce::File::getCurrentWorkingDirectory().getChildFile (args[++i]);
+            else
+                return false;
+        }
+
+        return true;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add (argv[i]);
+
+    Options options;
+    if (! parseOptions (args, options))
+    {
+        std::cerr << "usage: TapePerformerBenchmark [--quick] [--seconds <audio seconds per run>] [--budget <0-1>]" << std::endl
+                  << "                              [--suite <name>] [--output <file.json>]" << std::endl;
+        return 1;
+    }
+
+    juce::Array<juce::var> suites;
+
+    for (auto& sweep : createSweeps())
+    {
+        if (options.suite.isNotEmpty() && options.suite != sweep.name)
+            continue;
+
+        std::cerr << "running " << sweep.name << "..." << std::endl;
+
+        juce::Array<juce::var> results;
+        for (auto& config : sweep.configs)
+        {
+            auto result = sweep.singleVoice ? benchmarkVoice (config, options)
+                                            : benchmarkEngine (config, options);
+            results.add (toVar (config, result));
+        }
+
+        auto* suite = new juce::DynamicObject();
+        suite->setProperty ("name", sweep.name);
+        suite->setProperty ("target", sweep.singleVoice ? "GrainVoice::renderNextBlock" : "TapeEngine::process");
+        suite->setProperty ("results", results);
+        suites.add (juce::var (suite));
+    }
+
+    auto* report = new juce::DynamicObject();
+    report->setProperty ("cpu", juce::SystemStats::getCpuModel());
+    report->setProperty ("numCpus", juce::SystemStats::getNumCpus());
+    report->setProperty ("os", juce::SystemStats::getOperatingSystemName());
+    report->setProperty ("budget", options.budget);
+    report->setProperty ("secondsPerRun", options.secondsPerRun);
+    report->setProperty ("suites", suites);
+
+    auto json = juce::JSON::toString (juce::var (report));
+
+    if (options.outputFile != juce::File())
+        return options.outputFile.replaceWithText (json) ? 0 : 1;
+
+    std::cout << json << std::endl;
+    return 0;
+}
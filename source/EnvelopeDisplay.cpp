@@ -10,27 +10,34 @@
 
 #include <JuceHeader.h>
 #include "EnvelopeDisplay.h"
+#include "TraceZones.h"
 
 //==============================================================================
-EnvelopeDisplay::EnvelopeDisplay() : envCurve()
+EnvelopeDisplay::EnvelopeDisplay(juce::AudioProcessorValueTreeState& state) : apvts(state), envCurve()
 {
 
     envCurve.setFrequency(2, 44100);
-    startTimer(40);
+
+    // only redrawn when the shape changes, see parameterChanged()
+    envShapeValue = *apvts.getRawParameterValue("envShape");
+    envCurve.createWavetableEnv(envShapeValue);
+    apvts.addParameterListener("envShape", this);
+    startTimerHz (30);
 
 }
 
 EnvelopeDisplay::~EnvelopeDisplay()
 {
+    apvts.removeParameterListener("envShape", this);
+    stopTimer();
 }
 
 void EnvelopeDisplay::paint (juce::Graphics& g)
 {
+    TP_TRACE_ZONE ("EnvelopeDisplay::paint");
 
     g.fillAll (juce::Colours::grey.darker(0.2f));   // clear the background
     
-    auto bounds = getLocalBounds().toFloat();
-
     g.setColour (juce::Colours::black);
     g.drawRect (getLocalBounds(), 2);   // draw an outline around the component
 
@@ -38,8 +45,7 @@ void EnvelopeDisplay::paint (juce::Graphics& g)
 
     //g.drawRoundedRectangle(bounds, 4, 2.0f);
 
-    auto waveDrawArea = bounds.reduced(2);
-    drawWaveform(g, waveDrawArea);
+    g.fillPath(envelopePath);
 
 }
 
@@ -47,21 +53,41 @@ void EnvelopeDisplay::resized()
 {
     // This method is where you should set the bounds of any child
     // components that your component contains..
+    updatePath();
+}
+
+void EnvelopeDisplay::timerCallback()
+{
+    if (! shapeChanged.exchange (false))
+        return;
 
+    envCurve.createWavetableEnv(envShapeValue);
+    updatePath();
+    repaint();
 }
 
 
-void EnvelopeDisplay::drawWaveform(juce::Graphics& g, const juce::Rectangle<float>& waveDrawArea)
+void EnvelopeDisplay::updatePath()
 {
-    envCurve.createWavetableEnv();
-    
-    auto wavetable = envCurve.getWavetable();
+    // one point per pixel is all the detail the display can show
+    auto waveDrawArea = getLocalBounds().toFloat().reduced(2);
+    auto& wavetable = envCurve.getWavetable();
     auto* samples = wavetable.getReadPointer(0);
-    
-    for (int i = 0; i < wavetable.getNumSamples(); i++){
-        g.drawVerticalLine((int)(waveDrawArea.getX() + (waveDrawArea.getWidth() / 2048.0f) * i),
-                           (waveDrawArea.getHeight() + 4) - samples[i] * waveDrawArea.getHeight(),
-                           waveDrawArea.getHeight());
+    auto numPoints = juce::jmax(2, (int) waveDrawArea.getWidth());
+    auto lastIndex = wavetable.getNumSamples() - 1;
+
+    envelopePath.clear();
+    envelopePath.startNewSubPath(waveDrawArea.getBottomLeft());
+
+    for (int i = 0; i < numPoints; i++)
+    {
+        auto proportion = (float) i / (float) (numPoints - 1);
+        auto sample = samples[juce::roundToInt(proportion * (float) lastIndex)];
+
+        envelopePath.lineTo(waveDrawArea.getX() + proportion * waveDrawArea.getWidth(),
+                            waveDrawArea.getBottom() - sample * waveDrawArea.getHeight());
     }
 
+    envelopePath.lineTo(waveDrawArea.getBottomRight());
+    envelopePath.closeSubPath();
 }
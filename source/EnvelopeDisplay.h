@@ -17,10 +17,11 @@
 /*
 */
 class EnvelopeDisplay  : public juce::Component,
+                         private juce::AudioProcessorValueTreeState::Listener,
                          private juce::Timer
 {
 public:
-    EnvelopeDisplay();
+    EnvelopeDisplay(juce::AudioProcessorValueTreeState& state);
     ~EnvelopeDisplay() override;
 
     void paint (juce::Graphics&) override;
@@ -29,19 +30,23 @@ public:
     
 
 private:
-    void timerCallback() override
+    // can be called from the audio thread, so it only flags the change - the timer rebuilds the table
+    // and path on the message thread, posting a message from here wouldn't be realtime-safe
+    void parameterChanged (const juce::String& /*parameterID*/, float newValue) override
     {
-        if(envShapeValue != WavetableEnvelope::envelopeShape)
-        {
-            repaint();
-            envShapeValue = WavetableEnvelope::envelopeShape;
-        }
+        envShapeValue = newValue;
+        shapeChanged = true;
     }
-    void drawWaveform(juce::Graphics& g, const juce::Rectangle<float>& waveDisplayArea);
 
-    float envShapeValue = 1.0f;
+    void timerCallback() override;
+    void updatePath();
+
+    juce::AudioProcessorValueTreeState& apvts;
+    std::atomic<float> envShapeValue { 0.0f };
+    std::atomic<bool> shapeChanged { false };
     
     WavetableEnvelope envCurve;
+    juce::Path envelopePath;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EnvelopeDisplay)
 };
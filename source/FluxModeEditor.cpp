@@ -10,6 +10,7 @@
 
 #include <JuceHeader.h>
 #include "FluxModeEditor.h"
+#include "TraceZones.h"
 
 //==============================================================================
 FluxModeEditor::FluxModeEditor(TapePerformerAudioProcessor& p) : audioProcessor(p)
@@ -24,11 +25,13 @@ FluxModeEditor::FluxModeEditor(TapePerformerAudioProcessor& p) : audioProcessor(
     secondFluxButtonAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.apvts, "secondFluxMode", secondFluxModeButton);
     thirdFluxButtonAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.apvts, "thirdFluxMode", thirdFluxModeButton);
     fourthFluxButtonAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.apvts, "fourthFluxMode", fourthFluxModeButton);
+    fifthFluxButtonAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.apvts, "fifthFluxMode", fifthFluxModeButton);
 
     setTextButton(firstFluxModeButton, "Forward");
     setTextButton(secondFluxModeButton, "Backward");
     setTextButton(thirdFluxModeButton, "Zig-Zag");
     setTextButton(fourthFluxModeButton, "Random");
+    setTextButton(fifthFluxModeButton, "Similar");
 
     addAndMakeVisible(rangeLabel);
     rangeLabel.setText ("Range", juce::dontSendNotification);
@@ -54,6 +57,7 @@ FluxModeEditor::~FluxModeEditor()
 
 void FluxModeEditor::paint (juce::Graphics& g)
 {
+    TP_TRACE_ZONE ("FluxModeEditor::paint");
     auto bounds = getLocalBounds().toFloat().reduced(6);
     g.setColour(juce::Colours::black);
     g.drawRoundedRectangle(bounds, 8, 1.0f);
@@ -67,10 +71,11 @@ void FluxModeEditor::resized()
     auto buttonArea = bounds.removeFromRight(juce::jmax (50, fullArea.getWidth() / 2));
     buttonArea.removeFromTop(juce::jmax (20, fullArea.getHeight() / 5));
     buttonArea.removeFromBottom(juce::jmax (20, fullArea.getHeight() / 10));
-    firstFluxModeButton.setBounds(buttonArea.removeFromTop(juce::jmax (20, fullArea.getHeight() / 6)));
-    secondFluxModeButton.setBounds(buttonArea.removeFromTop(juce::jmax (20, fullArea.getHeight() / 6)));
-    thirdFluxModeButton.setBounds(buttonArea.removeFromTop(juce::jmax (20, fullArea.getHeight() / 6)));
-    fourthFluxModeButton.setBounds(buttonArea.removeFromTop(juce::jmax (20, fullArea.getHeight() / 6)));
+    firstFluxModeButton.setBounds(buttonArea.removeFromTop(juce::jmax (20, fullArea.getHeight() / 8)));
+    secondFluxModeButton.setBounds(buttonArea.removeFromTop(juce::jmax (20, fullArea.getHeight() / 8)));
+    thirdFluxModeButton.setBounds(buttonArea.removeFromTop(juce::jmax (20, fullArea.getHeight() / 8)));
+    fourthFluxModeButton.setBounds(buttonArea.removeFromTop(juce::jmax (20, fullArea.getHeight() / 8)));
+    fifthFluxModeButton.setBounds(buttonArea.removeFromTop(juce::jmax (20, fullArea.getHeight() / 8)));
 
     auto onOffButtonArea = bounds;
     onOffButtonArea.removeFromBottom(static_cast<int>(bounds.getHeight() * 0.8f));
@@ -44,6 +44,7 @@ private:
     juce::TextButton secondFluxModeButton;
     juce::TextButton thirdFluxModeButton;
     juce::TextButton fourthFluxModeButton;
+    juce::TextButton fifthFluxModeButton;
 
     juce::Slider rangeSlider;
     juce::Label rangeLabel;
@@ -55,6 +56,7 @@ private:
     std::unique_ptr<ButtonAttachment> secondFluxButtonAttachment;
     std::unique_ptr<ButtonAttachment> thirdFluxButtonAttachment;
     std::unique_ptr<ButtonAttachment> fourthFluxButtonAttachment;
+    std::unique_ptr<ButtonAttachment> fifthFluxButtonAttachment;
 
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> rangeAttachment;
 
@@ -8,33 +8,68 @@
   ==============================================================================
 */
 #include "Grain.h"
+#include "TraceZones.h"
+
+namespace
+{
+    /** 2 ^ (semitones / 12) for every transposition a note can end up with, so starting a grain never calls std::pow. */
+    struct SemitoneRatios
+    {
+        static constexpr int range = 256;
+
+        SemitoneRatios()
+        {
+            for (int i = 0; i < (int) ratios.size(); ++i)
+                ratios[(size_t) i] = std::pow (2.0, (i - range) / 12.0);
+        }
+
+        double get (int semitones) const noexcept   { return ratios[(size_t) (juce::jlimit (-range, range, semitones) + range)]; }
+
+        std::array<double, 2 * range + 1> ratios;
+    };
+
+    /** A Hann window, the time-stretch grains' envelope - two of them half a grain apart add up to 1. */
+    struct HannWindow
+    {
+        static constexpr int size = 1024;
+
+        HannWindow()
+        {
+            for (int i = 0; i <= size; ++i)
+                table[(size_t) i] = (float) (0.5 - 0.5 * std::cos (juce::MathConstants<double>::twoPi * i / size));
+        }
+
+        /** phase goes from 0 to 1 over the grain. */
+        float get (double phase) const noexcept
+        {
+            auto position = juce::jlimit (0.0, (double) size, phase * size);
+            auto index = juce::jmin ((int) position, size - 1);
+            auto alpha = (float) (position - index);
+
+            return table[(size_t) index] + alpha * (table[(size_t) index + 1] - table[(size_t) index]);
+        }
+
+        std::array<float, size + 1> table;
+    };
+
+    // filled in before main(), so the audio thread never waits for a static to be initialised
+    const SemitoneRatios semitoneRatios;
+    const HannWindow hannWindow;
+}
 
 
 
 GrainSound::GrainSound (const juce::String& soundName,
-                            juce::AudioFormatReader& source,
                             const juce::BigInteger& notes,
                             int midiNoteForNormalPitch,
                             double attackTimeSecs,
-                            double releaseTimeSecs,
-                            double maxSampleLengthSeconds)
+                            double releaseTimeSecs)
     : name (soundName),
-      sourceSampleRate (source.sampleRate),
       midiNotes (notes),
       midiRootNote (midiNoteForNormalPitch)
 {
-    if (sourceSampleRate > 0 && source.lengthInSamples > 0)
-    {
-        length = juce::jmin ((int) source.lengthInSamples,
-                       (int) (maxSampleLengthSeconds * sourceSampleRate));
-
-        data.reset (new juce::AudioBuffer<float> (juce::jmin (2, (int) source.numChannels), length + 4));
-
-        source.read (data.get(), 0, length + 4, 0, true, true);
-
-        params.attack  = static_cast<float> (attackTimeSecs);
-        params.release = static_cast<float> (releaseTimeSecs);
-    }
+    params.attack  = static_cast<float> (attackTimeSecs);
+    params.release = static_cast<float> (releaseTimeSecs);
 }
 
 GrainSound::~GrainSound()
@@ -43,7 +78,12 @@ GrainSound::~GrainSound()
 
 bool GrainSound::appliesToNote (int midiNoteNumber)
 {
-    return midiNotes[midiNoteNumber];
+    if (! active || ! midiNotes[midiNoteNumber])
+        return false;
+
+    // the lowest layer also takes a velocity of exactly zero
+    return incomingVelocity < 0
+        || ((incomingVelocity > lowestVelocity || lowestVelocity <= 0) && incomingVelocity <= highestVelocity);
 }
 
 bool GrainSound::appliesToChannel (int /*midiChannel*/)
@@ -51,7 +91,7 @@ bool GrainSound::appliesToChannel (int /*midiChannel*/)
     return true;
 }
 
-void GrainSound::updateParams(float mode, int availableKeys, double position, double duration, float spread, std::vector<float> fluxMode, int rootNote, float fluxModeRange)
+void GrainSound::updateParams(float mode, int availableKeys, double position, double duration, float spread, int fluxMode, int rootNote, float fluxModeRange)
 {
     pitchModeParam = mode >= 1;
 
@@ -69,41 +109,64 @@ void GrainSound::updateParams(float mode, int availableKeys, double position, do
             numOfKeysAvailable = 96;
     }
 
-    positionParam = position * length;
+    // position and duration stay relative to the tape - every slot can hold a tape of a different length
+    positionParam = position;
+    durationParam = duration;
+
+    spreadParam = spread;
+
+    fluxModeParam = fluxMode;
+
+    fluxRangeParam = fluxModeRange;
+
+    transpositionParam = rootNote;
     
+}
+
+double GrainSound::getDurationInSamples (const GrainTape& tape, double durationOffset) const
+{
+    auto length = tape.getLength();
+    auto duration = juce::jlimit (0.0, 1.0, durationParam + durationOffset);
+
     // change here to a state that won't increase much if a sample is very long
 //    auto lengthInSeconds = length / sourceSampleRate;
 //    lengthInSeconds > 3 ? durationParam = duration * ( 2.5 * sourceSampleRate) : durationParam = duration * length;
     if(length > 88200)
         duration *= 88200.0f / length;
 
-    durationParam = std::max(duration * length, 40.0);
+    return std::max(duration * length, 40.0);
+}
 
-    spreadParam = spread;
+GrainTape::Ptr GrainSound::setTape (int slot, GrainTape::Ptr newTape)
+{
+    std::swap (tapes[(size_t) slot], newTape);
+    return newTape;
+}
 
-    int counter = 1;
-    fluxModeParam = 0;
-    for(auto mode : fluxMode)
-    {
-        if(mode > 0)
-        {
-            fluxModeParam = counter;
-        }
-        counter++;
-    }
+int GrainSound::getPrimarySlot() const
+{
+    auto nearestSlot = juce::roundToInt (tapeCrossfade.load());
+    if (tapes[(size_t) nearestSlot] != nullptr)
+        return nearestSlot;
 
-    fluxRangeParam = fluxModeRange;
+    for (int slot = 0; slot < numTapeSlots; ++slot)
+        if (tapes[(size_t) slot] != nullptr)
+            return slot;
 
-    transpositionParam = rootNote;
-    
+    return -1;
+}
+
+GrainTape* GrainSound::getPrimaryTape() const
+{
+    auto slot = getPrimarySlot();
+    return slot >= 0 ? getTape (slot) : nullptr;
 }
 
 //==============================================================================
 GrainVoice::GrainVoice() : envCurve()  //: createWavetableEnv(), envCurve(envTable) {
 {
-
-    std::srand(time(NULL));
-    
+    // the envelope table starts with a shape of 0, startNote() only reshapes it when the sound's shape differs
+    envShapeValue = 0.0f;
 }
 GrainVoice::~GrainVoice() {}
 
@@ -112,185 +175,816 @@ bool GrainVoice::canPlaySound (juce::SynthesiserSound* sound)
     return dynamic_cast<const GrainSound*> (sound) != nullptr;
 }
 
-void GrainVoice::startNote (int midiNoteNumber, float velocity, juce::SynthesiserSound* s, int /*currentPitchWheelPosition*/)
+void GrainVoice::startNote (int midiNoteNumber, float velocity, juce::SynthesiserSound* s, int currentPitchWheelPosition)
 {
-   if(envShapeValue != WavetableEnvelope::envelopeShape) {
-        envCurve.createWavetableEnv();
-        envShapeValue = WavetableEnvelope::envelopeShape;
-    }
+    TP_TRACE_ZONE ("GrainVoice::startNote");
+
+    // the synth only hands out sounds that canPlaySound() has said yes to, so this doesn't need another dynamic_cast
+    jassert (dynamic_cast<GrainSound*> (s) != nullptr); // this object can only play GrainSounds!
+    auto* sound = static_cast<GrainSound*> (s);
 
-    if (auto* sound = dynamic_cast< GrainSound*> (s)) //deleted const before GrainSound* to make set startPosition work
+    if (envShapeValue != sound->envelopeShape)
     {
-        currentMidiNumber = midiNoteNumber;
-        numToChange = 0;
+        envCurve.createWavetableEnv (sound->envelopeShape);
+        envShapeValue = sound->envelopeShape;
+    }
 
-        setPitchRatio(sound, currentMidiNumber);
-        sourceSamplePosition = setStartPosition(sound, true);
+    currentMidiNumber = midiNoteNumber;
+    numToChange = 0;
+    similarPhase = -1.0;
+    previousSimilarWindow = -1;
 
-        numPlayedSamples = 0;
-        lgain = velocity;
-        rgain = velocity;
+    // the note starts with whatever its channel was set to, the first grain already follows it
+    expression = {};
+    setPitchBend (currentPitchWheelPosition);
+    setPressure (channelPressure);
+    setSlide (channelSlide);
 
-        adsr.setSampleRate (sound->sourceSampleRate);
-        adsr.setParameters (sound->params);
+    // the modulation matrix's velocity and key routes stay the same for the whole note
+    auto keyTrack = juce::jlimit (-1.0f, 1.0f, (float) (midiNoteNumber - sound->midiRootNote) / 60.0f);
+    noteModulation.position = sound->velocityModulation.position * velocity + sound->keyModulation.position * keyTrack;
+    noteModulation.duration = sound->velocityModulation.duration * velocity + sound->keyModulation.duration * keyTrack;
+    noteModulation.spread = sound->velocityModulation.spread * velocity + sound->keyModulation.spread * keyTrack;
+
+    // a time-stretched note starts its first grain when it renders, see renderStretch()
+    stretching = sound->timeStretchParam;
+
+    if (stretching)
+    {
+        for (auto& grain : stretchGrains)
+            grain.active = false;
 
-        adsr.noteOn();
+        firstStretchGrain = true;
+        samplesToNextStretchGrain = 0;
+        scanOffset = 0;
+        setPitchRatio (sound, currentMidiNumber);
     }
     else
     {
-        jassertfalse; // this object can only play SamplerSounds!
+        startGrain(sound, true);
     }
+
+    grainPhasePending = true;
+    lgain = velocity;
+    rgain = velocity;
+
+    adsr.setSampleRate (getSampleRate());
+    adsr.setParameters (sound->params);
+
+    adsr.noteOn();
+    released = false;
+
+    startOffset = eventOffset * oversampling;
+    releaseOffset = -1;
 }
 
 void GrainVoice::stopNote (float /*velocity*/, bool allowTailOff)
 {
     if (allowTailOff)
     {
-        adsr.noteOff();
+        // renderNextBlock() releases the envelope at the note-off's sample. The synth only stops a note that
+        // the key or a pedal still holds for all-notes-off, which ends it whatever the pedals say
+        setKeyDown (false);
+        setSustainPedalDown (false);
+        setSostenutoPedalDown (false);
+        releaseOffset = eventOffset * oversampling;
     }
     else
     {
         clearCurrentNote();
         adsr.reset();
+        startOffset = 0;
+        releaseOffset = -1;
     }
 }
 
-void GrainVoice::pitchWheelMoved (int /*newValue*/) {}
-void GrainVoice::controllerMoved (int /*controllerNumber*/, int /*newValue*/) {}
+void GrainVoice::fadeOut()
+{
+    auto params = adsr.getParameters();
+    params.release = juce::jmin (params.release, fadeOutSeconds);
+    adsr.setParameters (params);
+
+    // startNote() sets the sound's release again
+    setKeyDown (false);
+    adsr.noteOff();
+    released = true;
+    releaseOffset = -1;
+}
+
+void GrainVoice::setOversampling (int factor, double baseSampleRate)
+{
+    factor = juce::jmax (1, factor);
+
+    if (factor == oversampling && getSampleRate() == baseSampleRate * factor)
+        return;
+
+    // what's counted in samples gets longer, what moves by a sample gets slower
+    const auto ratio = (double) factor / oversampling;
+    oversampling = factor;
+    setCurrentPlaybackSampleRate (baseSampleRate * factor);
+
+    for (auto& reader : readers)
+        reader.increment /= ratio;
+
+    grainLength *= ratio;
+    numPlayedSamples *= ratio;
+
+    for (auto& grain : stretchGrains)
+    {
+        grain.length *= ratio;
+        grain.age *= ratio;
+    }
+
+    samplesToNextStretchGrain = juce::roundToInt (samplesToNextStretchGrain * ratio);
+    startOffset = juce::roundToInt (startOffset * ratio);
+    if (releaseOffset >= 0)
+        releaseOffset = juce::roundToInt (releaseOffset * ratio);
+
+    adsr.setSampleRate (getSampleRate());
+    adsr.setParameters (adsr.getParameters());
+
+    if (auto* sound = static_cast<GrainSound*> (getCurrentlyPlayingSound().get()))
+        setEnvelopeFrequency (sound);
+}
+
+double GrainVoice::getPlaybackRatio() const
+{
+    auto* sound = static_cast<GrainSound*> (getCurrentlyPlayingSound().get());
+    auto* tape = sound != nullptr ? sound->getPrimaryTape() : nullptr;
+
+    if (tape == nullptr || getSampleRate() <= 0.0)
+        return 0.0;
+
+    return pitchRatio * tape->getSampleRate() * oversampling / getSampleRate();
+}
+
+void GrainVoice::pitchWheelMoved (int newValue)
+{
+    setPitchBend (newValue);
+}
+
+void GrainVoice::controllerMoved (int controllerNumber, int newValue)
+{
+    if (controllerNumber == slideController)
+        setSlide ((float) newValue / 127.0f);
+}
+
+void GrainVoice::channelPressureChanged (int newChannelPressureValue)
+{
+    setPressure ((float) newChannelPressureValue / 127.0f);
+}
+
+void GrainVoice::aftertouchChanged (int newAftertouchValue)
+{
+    // polyphonic aftertouch is per-note pressure too, for controllers that don't speak MPE
+    setPressure ((float) newAftertouchValue / 127.0f);
+}
+
+void GrainVoice::setPitchBend (int pitchWheelValue)
+{
+    auto range = isPlayingChannel (1) ? channelOneBendRange : mpeBendRange;
+    auto semitones = range * (float) (pitchWheelValue - 8192) / 8192.0f;
+
+    if (semitones == expression.pitchBend)
+        return;
+
+    auto newBendRatio = std::pow (2.0, semitones / 12.0);
+    auto change = newBendRatio / expression.bendRatio;
+
+    // the playing grain bends straight away, it doesn't wait for the next one
+    pitchRatio *= change;
+    for (auto& reader : readers)
+        reader.increment *= change;
+    for (auto& grain : stretchGrains)
+        grain.pitchRatio *= change;
+
+    expression.pitchBend = semitones;
+    expression.bendRatio = newBendRatio;
+}
+
+void GrainVoice::setPressure (float pressure)
+{
+    pressure = juce::jlimit (0.0f, 1.0f, pressure);
+
+    // pressing harder holds on to one fragment with longer grains - picked up by the next grain
+    expression.spreadScale = 1.0f - pressure;
+    expression.durationScale = 1.0f + pressure;
+}
+
+void GrainVoice::setSlide (float slide)
+{
+    expression.positionOffset = slideRange * (juce::jlimit (0.0f, 1.0f, slide) * 2.0f - 1.0f);
+}
 
 //==============================================================================
 void GrainVoice::renderNextBlock (juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples)
 {
+    TP_TRACE_ZONE ("GrainVoice::renderNextBlock");
+
     if (auto* playingSound = static_cast<GrainSound*> (getCurrentlyPlayingSound().get()))
     {
-        auto& data = *playingSound->data;
-        const float* const inL = data.getReadPointer (0);
-        const float* const inR = data.getNumChannels() > 1 ? data.getReadPointer (1) : nullptr;
+        const auto startTicks = juce::Time::getHighResolutionTicks();
+        const int endSample = startSample + numSamples;
+
+        // a note that started during this block stays silent until its own sample
+        if (startOffset > 0)
+        {
+            startSample = juce::jlimit (startSample, endSample, startOffset);
+            startOffset = 0;
+        }
+
+        // the same goes for a note-off - the envelope gets released once, at that sample. ADSR::noteOff()
+        // starts the release from wherever the envelope is, so calling it again would never let it finish.
+        // A note the sustain or sostenuto pedal holds on to keeps playing until the pedal comes up.
+        int releaseSample = -1;
+
+        if (releaseOffset >= 0 && ! released && isPlayingButReleased())
+            releaseSample = juce::jlimit (startSample, endSample, releaseOffset);
 
-        float* outL = outputBuffer.getWritePointer (0, startSample);
-        float* outR = outputBuffer.getNumChannels() > 1 ? outputBuffer.getWritePointer (1, startSample) : nullptr;
-        
+        releaseOffset = -1;
 
-        while (--numSamples >= 0)
+        if (releaseSample > startSample)
         {
-            auto pos = (int) sourceSamplePosition;
-            auto alpha = (float) (sourceSamplePosition - pos);
-            auto invAlpha = 1.0f - alpha;
+            renderNote (outputBuffer, playingSound, startSample, releaseSample, true);
+            startSample = releaseSample;
+        }
+
+        if (releaseSample >= 0)
+        {
+            adsr.noteOff();
+            released = true;
+        }
+
+        renderNote (outputBuffer, playingSound, startSample, endSample, ! released);
+
+        // what the voice costs, for GrainSynthesiser's budget - short blocks count for less,
+        // since the fixed cost of a call makes them look more expensive per sample than they are
+        auto seconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+        auto blockLoad = (float) (seconds * getSampleRate() / juce::jmax (1, numSamples));
+        load += (blockLoad - load) * ((float) numSamples / ((float) numSamples + 2048.0f));
+
+        // the release has finished, so the voice is free for the next note
+        if (! adsr.isActive())
+            clearCurrentNote();
+    }
+    
+}
+
+void GrainVoice::renderNote (juce::AudioBuffer<float>& outputBuffer, GrainSound* playingSound, int startSample, int endSample, bool isHeld)
+{
+    if (startSample >= endSample)
+        return;
+
+    // time-stretched notes keep their grains going through the release, the note envelope fades them out
+    if (stretching)
+    {
+        grainPhasePending = false;
+        renderStretch (outputBuffer, *playingSound, startSample, endSample);
+        return;
+    }
+
+    auto* clock = playingSound->grainClock;
+    const bool synced = clock != nullptr && clock->isSynced();
+
+    if (synced && grainPhasePending)
+    {
+        // the note came in somewhere inside a grid step - start the envelope at that phase
+        // so the first grain ends on the next grid line instead of being cut off there
+        setEnvelopeFrequency (playingSound);
+        envCurve.setPhase ((float) clock->getPhaseAt (startSample / oversampling));
+    }
+    grainPhasePending = false;
+
+    // grain boundaries are worked out up front, so the sample loop itself never has to check them
+    if (synced)
+    {
+        for (int i = 0; i < clock->getNumBoundaries(); ++i)
+        {
+            auto boundary = clock->getBoundary (i) * oversampling;
+
+            if (boundary < startSample || boundary >= endSample)
+                continue;
+
+            renderGrain (outputBuffer, *playingSound, startSample, boundary - startSample);
+            startSample = boundary;
+
+            if (isHeld)
+                retriggerGrain (playingSound);
+        }
+    }
+    else
+    {
+        while (isHeld && startSample < endSample)
+        {
+            // same as restarting once numPlayedSamples has gone past the grain length
+            auto samplesLeftInGrain = (int) std::floor (grainLength - numPlayedSamples) + 1;
+            samplesLeftInGrain = juce::jmax (1, samplesLeftInGrain);
+
+            if (samplesLeftInGrain > endSample - startSample)
+                break;
+
+            renderGrain (outputBuffer, *playingSound, startSample, samplesLeftInGrain);
+            startSample += samplesLeftInGrain;
+            retriggerGrain (playingSound);
+        }
+    }
+
+    renderGrain (outputBuffer, *playingSound, startSample, endSample - startSample);
+}
+
+void GrainVoice::renderGrain (juce::AudioBuffer<float>& outputBuffer, GrainSound& sound, int startSample, int numSamples)
+{
+    // only the two slots either side of the crossfade position are read
+    const auto crossfade = sound.tapeCrossfade.load();
+    auto firstSlot = juce::jmin ((int) crossfade, GrainSound::numTapeSlots - 1);
+    auto secondSlot = juce::jmin (firstSlot + 1, GrainSound::numTapeSlots - 1);
+    auto secondSlotGain = crossfade - (float) firstSlot;
+    auto firstSlotGain = 1.0f - secondSlotGain;
+
+    for (int slot = 0; slot < GrainSound::numTapeSlots; ++slot)
+    {
+        if ((slot != firstSlot || firstSlotGain <= 0.0f) && (slot != secondSlot || secondSlotGain <= 0.0f))
+            readers[(size_t) slot].inSync = false;
+    }
+
+    float* outL = outputBuffer.getWritePointer (0, startSample);
+    float* outR = outputBuffer.getNumChannels() > 1 ? outputBuffer.getWritePointer (1, startSample) : nullptr;
+
+    float envelope[renderChunkSize];
+
+    while (numSamples > 0)
+    {
+        auto numThisTime = juce::jmin (numSamples, (int) renderChunkSize);
+
+        // the envelopes run once per sample no matter how many tapes are being read
+        for (int i = 0; i < numThisTime; ++i)
+        {
+            adsrLevel = adsr.getNextSample();
+            envelope[i] = adsrLevel * envCurve.getNextSample();
+        }
+
+        envelopeLevel = envelope[numThisTime - 1];
+
+        auto* firstTape = sound.getTape (firstSlot);
+        auto* secondTape = sound.getTape (secondSlot);
+
+        if (firstTape != nullptr && firstSlotGain > 0.0f)
+            renderTape (readers[(size_t) firstSlot], *firstTape, outL, outR, envelope, firstSlotGain, numThisTime);
+
+        if (secondTape != nullptr && secondSlotGain > 0.0f && secondSlot != firstSlot)
+            renderTape (readers[(size_t) secondSlot], *secondTape, outL, outR, envelope, secondSlotGain, numThisTime);
 
+        numPlayedSamples += numThisTime;
+
+        outL += numThisTime;
+        if (outR != nullptr)
+            outR += numThisTime;
+
+        numSamples -= numThisTime;
+    }
+}
+
+/** 4-point Hermite - the tapes are padded at the end, the sample before the start is taken as the first one. */
+static forcedinline float interpolateHermite (const float* in, int pos, float alpha) noexcept
+{
+    auto xm1 = in[pos > 0 ? pos - 1 : 0];
+    auto x0 = in[pos];
+    auto x1 = in[pos + 1];
+    auto x2 = in[pos + 2];
+
+    auto c1 = 0.5f * (x1 - xm1);
+    auto c2 = xm1 - 2.5f * x0 + 2.0f * x1 - 0.5f * x2;
+    auto c3 = 0.5f * (x2 - xm1) + 1.5f * (x0 - x1);
+
+    return ((c3 * alpha + c2) * alpha + c1) * alpha + x0;
+}
+
+void GrainVoice::renderTape (TapeReader& reader, const GrainTape& tape, float* outL, float* outR, const float* envelope, float gain, int numSamples)
+{
+    auto& data = tape.getData();
+    const float* const inL = data.getReadPointer (0);
+    const float* const inR = data.getNumChannels() > 1 ? data.getReadPointer (1) : nullptr;
+    const double length = tape.getLength();
+
+    // the tape in this slot was swapped while the grain was playing
+    if (reader.tape != &tape || reader.tapeLength != tape.getLength())
+    {
+        reader.tape = &tape;
+        reader.tapeLength = tape.getLength();
+        reader.startPosition = grainStartPhase * tape.getLength();
+        reader.increment = pitchRatio * tape.getSampleRate() / getSampleRate();
+        reader.loudnessGain = normalising ? tape.getLoudnessGain (grainStartPhase) : 1.0f;
+        reader.inSync = false;
+    }
+
+    // a slot that wasn't playing until now picks up where it would have been
+    if (! reader.inSync)
+    {
+        reader.position = std::fmod (reader.startPosition + reader.increment * numPlayedSamples, length);
+        reader.inSync = true;
+    }
+
+    auto sourceSamplePosition = reader.position;
+    gain *= reader.loudnessGain;
+    const bool hermite = interpolation == Interpolation::hermite;
+    const bool nearest = interpolation == Interpolation::nearest;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto pos = (int) sourceSamplePosition;
+        auto alpha = (float) (sourceSamplePosition - pos);
+        auto invAlpha = 1.0f - alpha;
+
+        float l, r;
+
+        if (hermite)
+        {
+            l = interpolateHermite (inL, pos, alpha);
+            r = (inR != nullptr) ? interpolateHermite (inR, pos, alpha) : l;
+        }
+        else if (nearest)
+        {
+            l = inL[pos];
+            r = (inR != nullptr) ? inR[pos] : l;
+        }
+        else
+        {
             // just using a very simple linear interpolation here..
-            float l = (inL[pos] * invAlpha + inL[pos + 1] * alpha);
-            float r = (inR != nullptr) ? (inR[pos] * invAlpha + inR[pos + 1] * alpha) : l;
+            l = (inL[pos] * invAlpha + inL[pos + 1] * alpha);
+            r = (inR != nullptr) ? (inR[pos] * invAlpha + inR[pos + 1] * alpha) : l;
+        }
+
+        l *= lgain * gain * envelope[i];
+        r *= rgain * gain * envelope[i];
+
+        if (outR != nullptr)
+        {
+            outL[i] += l;
+            outR[i] += r;
+        }
+        else
+        {
+            outL[i] += (l + r) * 0.5f;
+        }
+
+        sourceSamplePosition += reader.increment;
+        sourceSamplePosition = std::fmod(sourceSamplePosition, length);
+    }
+
+    reader.position = sourceSamplePosition;
+}
+
+//==============================================================================
+void GrainVoice::renderStretch (juce::AudioBuffer<float>& outputBuffer, GrainSound& sound, int startSample, int endSample)
+{
+    float* outL = outputBuffer.getWritePointer (0, startSample);
+    float* outR = outputBuffer.getNumChannels() > 1 ? outputBuffer.getWritePointer (1, startSample) : nullptr;
 
-            auto envelopeValue = adsr.getNextSample();
-            auto envTableValue = envCurve.getNextSample();
+    float envelope[renderChunkSize];
+    const auto crossfade = sound.tapeCrossfade.load();
 
-            l *= lgain * envTableValue * envelopeValue;
-            r *= rgain * envTableValue * envelopeValue;
+    while (startSample < endSample)
+    {
+        if (samplesToNextStretchGrain <= 0)
+            startStretchGrain (sound);
+
+        // a chunk never goes past the next grain's start, so the grains start on their exact sample
+        auto numThisTime = juce::jmin (endSample - startSample, (int) renderChunkSize, samplesToNextStretchGrain);
+
+        // the grains have their own window, the note envelope is shared by all of them
+        for (int i = 0; i < numThisTime; ++i)
+        {
+            adsrLevel = adsr.getNextSample();
+            envelope[i] = adsrLevel;
+        }
+
+        envelopeLevel = adsrLevel;
+
+        for (auto& grain : stretchGrains)
+            if (grain.active)
+                renderStretchGrain (grain, sound, crossfade, outL, outR, envelope, numThisTime);
+
+        advancePlayhead (sound, numThisTime);
+        samplesToNextStretchGrain -= numThisTime;
+
+        // for the telemetry, which follows the newest grain
+        numPlayedSamples = stretchGrains[(size_t) newestStretchGrain].age;
+
+        outL += numThisTime;
+        if (outR != nullptr)
+            outR += numThisTime;
+
+        startSample += numThisTime;
+    }
+}
+
+void GrainVoice::renderStretchGrain (StretchGrain& grain, GrainSound& sound, float crossfade, float* outL, float* outR, const float* envelope, int numSamples)
+{
+    // a grain that ends inside this chunk is silent for the rest of it
+    float window[renderChunkSize];
+
+    for (int i = 0; i < numSamples; ++i)
+        window[i] = grain.age + i < grain.length ? hannWindow.get ((grain.age + i) / grain.length) * envelope[i] : 0.0f;
+
+    // the same two slots as renderGrain(), each read at the same point relative to its own tape
+    auto firstSlot = juce::jmin ((int) crossfade, GrainSound::numTapeSlots - 1);
+    auto secondSlot = juce::jmin (firstSlot + 1, GrainSound::numTapeSlots - 1);
+    auto secondSlotGain = crossfade - (float) firstSlot;
+    auto firstSlotGain = 1.0f - secondSlotGain;
+
+    for (auto slot : { firstSlot, secondSlot })
+    {
+        auto* tape = sound.getTape (slot);
+        auto slotGain = slot == firstSlot ? firstSlotGain : secondSlotGain;
+
+        if (tape == nullptr || slotGain <= 0.0f || (slot == secondSlot && secondSlot == firstSlot))
+            continue;
+
+        auto& data = tape->getData();
+        const float* const inL = data.getReadPointer (0);
+        const float* const inR = data.getNumChannels() > 1 ? data.getReadPointer (1) : nullptr;
+        const double length = tape->getLength();
+        slotGain *= grain.loudnessGains[(size_t) slot];
+
+        auto increment = grain.pitchRatio * tape->getSampleRate() / getSampleRate();
+        auto position = std::fmod (grain.startPhase * length + increment * grain.age, length);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto pos = (int) position;
+            auto alpha = (float) (position - pos);
+
+            auto l = interpolate (inL, pos, alpha);
+            auto r = inR != nullptr ? interpolate (inR, pos, alpha) : l;
+
+            auto gain = slotGain * window[i];
+            l *= lgain * gain;
+            r *= rgain * gain;
 
             if (outR != nullptr)
             {
-                *outL++ += l;
-                *outR++ += r;
+                outL[i] += l;
+                outR[i] += r;
             }
             else
             {
-                *outL++ += (l + r) * 0.5f;
+                outL[i] += (l + r) * 0.5f;
             }
 
-            sourceSamplePosition += pitchRatio;
-            sourceSamplePosition = std::fmod(sourceSamplePosition, playingSound->length);
-            
-            numPlayedSamples += pitchRatio;
+            position += increment;
+            if (position >= length)
+                position -= length;
+        }
+    }
 
-            if (!isKeyDown())
-            {
-                //need to make this only be called once (maybe once a block) - at the moment it is called for every sample in the block
-                stopNote (0.0f, true);
-            }
-            else if (numPlayedSamples > playingSound->durationParam)
-            {
-                numPlayedSamples = 0;
-                sourceSamplePosition = setStartPosition(playingSound, false);
-                setPitchRatio(playingSound, currentMidiNumber);
-            }
+    grain.age += numSamples;
+
+    if (grain.age >= grain.length)
+        grain.active = false;
+}
+
+void GrainVoice::startStretchGrain (GrainSound& sound)
+{
+    TP_TRACE_ZONE ("GrainVoice::startGrain");
+    ++numGrainsStarted;
+
+    if (! firstStretchGrain)
+        setCurrentFluxPosition (&sound);
+
+    firstStretchGrain = false;
+    setPitchRatio (&sound, currentMidiNumber);
+
+    // every grain starts where the playhead is now, relative to wherever position and the flux put the note
+    auto phase = getStartPhase (&sound) + scanOffset;
+    phase -= std::floor (phase);
+
+    auto length = 40.0;
+    if (auto* tape = sound.getPrimaryTape())
+        length = sound.getDurationInSamples (*tape, noteModulation.duration) * expression.durationScale / (pitchRatio * tape->getSampleRate() / getSampleRate());
+
+    // a free grain if there is one, otherwise the one closest to its end
+    auto index = 0;
+    auto highestProgress = -1.0;
+
+    for (int i = 0; i < maxStretchGrains; ++i)
+    {
+        auto& grain = stretchGrains[(size_t) i];
+        auto progress = grain.active ? grain.age / grain.length : 2.0;
+
+        if (progress > highestProgress)
+        {
+            highestProgress = progress;
+            index = i;
         }
     }
-    
+
+    auto& grain = stretchGrains[(size_t) index];
+    grain = { phase, pitchRatio, length, 0.0, true, {} };
+
+    for (int slot = 0; slot < GrainSound::numTapeSlots; ++slot)
+    {
+        auto* tape = sound.getTape (slot);
+        grain.loudnessGains[(size_t) slot] = sound.normaliseParam && tape != nullptr ? tape->getLoudnessGain (phase) : 1.0f;
+    }
+
+    newestStretchGrain = index;
+
+    grainLength = length;
+    numPlayedSamples = 0;
+    samplesToNextStretchGrain = juce::jmax (1, juce::roundToInt (length / stretchOverlap));
 }
 
-//==============================================================================
+void GrainVoice::advancePlayhead (GrainSound& sound, int numSamples)
+{
+    auto* tape = sound.getPrimaryTape();
+    if (tape == nullptr || tape->getLength() <= 0)
+        return;
 
-double GrainVoice::getPosition()
+    // at a speed of 1 the playhead moves through the tape in the tape's own time, whatever the note's pitch
+    scanOffset += sound.stretchSpeedParam * numSamples * tape->getSampleRate() / (getSampleRate() * tape->getLength());
+    scanOffset -= std::floor (scanOffset);
+}
+
+float GrainVoice::interpolate (const float* in, int pos, float alpha) const noexcept
 {
-    double position;
-    (!isKeyDown()) ? (position = 0) : (position = sourceSamplePosition);
-    return position;
+    switch (interpolation)
+    {
+        case Interpolation::nearest:    return in[pos];
+        case Interpolation::hermite:    return interpolateHermite (in, pos, alpha);
+        case Interpolation::linear:
+        default:                        return in[pos] * (1.0f - alpha) + in[pos + 1] * alpha;
+    }
 }
 
-double GrainVoice::setStartPosition(GrainSound* sound, bool newlyStarted)
+void GrainVoice::startGrain (GrainSound* sound, bool newlyStarted)
 {
-    envCurve.resetIndex();
-    setEnvelopeFrequency(sound);
+    TP_TRACE_ZONE ("GrainVoice::startGrain");
+    ++numGrainsStarted;
+
     if(!newlyStarted)
     {
         setCurrentFluxPosition(sound);
     }
-    double position;
-    if(!sound->pitchModeParam)
+
+    setPitchRatio(sound, currentMidiNumber);
+
+    // every slot starts at the same point relative to its own tape, the grain length follows the crossfade
+    auto phase = getStartPhase(sound);
+    grainStartPhase = phase;
+    normalising = sound->normaliseParam;
+    const auto crossfade = sound->tapeCrossfade.load();
+    auto firstSlot = juce::jmin ((int) crossfade, GrainSound::numTapeSlots - 1);
+    auto secondSlotGain = (double) crossfade - firstSlot;
+    double weightedLength = 0, totalWeight = 0;
+
+    for (int slot = 0; slot < GrainSound::numTapeSlots; ++slot)
     {
-        if(sound->fluxModeParam == 2)
-        {
-            position = std::fmod((sound->positionParam +  (float((currentMidiNumber - numToChange) % sound->numOfKeysAvailable) / float(sound->numOfKeysAvailable) * sound->length) * sound->spreadParam), sound->length);
-        }
-        else
+        auto& reader = readers[(size_t) slot];
+        reader.inSync = false;
+        reader.tape = sound->getTape (slot);
+        reader.tapeLength = reader.tape != nullptr ? reader.tape->getLength() : 0;
+
+        if (auto* tape = reader.tape)
         {
-            position = std::fmod((sound->positionParam +  (float((currentMidiNumber + numToChange)   % sound->numOfKeysAvailable) / float(sound->numOfKeysAvailable) * sound->length) * sound->spreadParam), sound->length);
+            reader.startPosition = phase * tape->getLength();
+            reader.increment = pitchRatio * tape->getSampleRate() / getSampleRate();
+            reader.loudnessGain = normalising ? tape->getLoudnessGain (phase) : 1.0f;
+
+            auto weight = slot == firstSlot ? 1.0 - secondSlotGain : (slot == firstSlot + 1 ? secondSlotGain : 0.0);
+            if (weight > 0.0)
+            {
+                weightedLength += weight * sound->getDurationInSamples (*tape, noteModulation.duration) * expression.durationScale / reader.increment;
+                totalWeight += weight;
+            }
         }
     }
+
+    if (totalWeight > 0.0)
+        grainLength = weightedLength / totalWeight;
+    else if (auto* tape = sound->getPrimaryTape())
+        grainLength = sound->getDurationInSamples (*tape, noteModulation.duration) * expression.durationScale / (pitchRatio * tape->getSampleRate() / getSampleRate());
     else
+        grainLength = 40.0;
+
+    numPlayedSamples = 0;
+    envCurve.resetIndex();
+    setEnvelopeFrequency(sound);
+}
+
+void GrainVoice::retriggerGrain (GrainSound* sound)
+{
+    startGrain(sound, false);
+}
+
+//==============================================================================
+
+double GrainVoice::getPosition()
+{
+    auto* sound = static_cast<GrainSound*> (getCurrentlyPlayingSound().get());
+
+    // still valid while the release is fading out
+    if (sound == nullptr)
+        return 0;
+
+    auto slot = sound->getPrimarySlot();
+    if (slot < 0)
+        return 0;
+
+    if (stretching)
     {
-        setEnvelopeFrequency(sound);
-        envCurve.resetIndex();
-        if(sound->fluxModeParam == 2)
-        {
-            position = std::fmod((sound->positionParam +  (float((sound->midiRootNote - numToChange) % sound->numOfKeysAvailable) / float(sound->numOfKeysAvailable) * sound->length) * sound->spreadParam), sound->length);
-        }
-        else
-        {
-            position = std::fmod((sound->positionParam +  (float((sound->midiRootNote + numToChange) % sound->numOfKeysAvailable) / float(sound->numOfKeysAvailable) * sound->length) * sound->spreadParam), sound->length);
-        }
+        auto& grain = stretchGrains[(size_t) newestStretchGrain];
+        auto* tape = sound->getTape (slot);
+        auto increment = grain.pitchRatio * tape->getSampleRate() / getSampleRate();
 
+        return std::fmod (grain.startPhase * tape->getLength() + increment * grain.age, (double) tape->getLength());
     }
-    return position;
+
+    auto& reader = readers[(size_t) slot];
+    if (reader.inSync)
+        return reader.position;
+
+    return std::fmod (reader.startPosition + reader.increment * numPlayedSamples, (double) sound->getTape (slot)->getLength());
+}
+
+GrainState GrainVoice::getGrainState()
+{
+    GrainState state;
+    state.midiNote = currentMidiNumber;
+
+    auto* sound = static_cast<GrainSound*> (getCurrentlyPlayingSound().get());
+    if (sound == nullptr)
+        return state;
+
+    state.isRootNote = currentMidiNumber == sound->midiRootNote;
+
+    if (auto* tape = sound->getPrimaryTape())
+        state.position = (float) (getPosition() / tape->getLength());
+
+    // synced grains last exactly one grid step, whatever their own length is
+    auto length = (sound->grainClock != nullptr && sound->grainClock->isSynced()) ? sound->grainClock->getSamplesPerGrain() * oversampling
+                                                                                   : grainLength;
+    if (length > 0)
+        state.grainPhase = (float) juce::jlimit (0.0, 1.0, numPlayedSamples / length);
+
+    return state;
+}
+
+double GrainVoice::getStartPhase(GrainSound* sound)
+{
+    // once the similarity walk has made its first step it plays exactly the window it walked to - any offset
+    // on top would play a part of the tape that isn't the similar one
+    if (sound->fluxModeParam == 5 && similarPhase >= 0.0)
+        return similarPhase;
+
+    // pitch mode always starts from the root note's fragment, position mode from the played key's
+    auto key = sound->pitchModeParam ? sound->midiRootNote : currentMidiNumber;
+    auto fragment = (sound->fluxModeParam == 2) ? key - numToChange : key + numToChange;
+
+    auto spread = juce::jlimit (0.0f, 1.0f, sound->spreadParam + noteModulation.spread);
+
+    auto phase = sound->positionParam + sound->positionOffset + expression.positionOffset + noteModulation.position
+                  + (float(fragment % sound->numOfKeysAvailable) / float(sound->numOfKeysAvailable)) * spread * expression.spreadScale;
+
+    return phase - std::floor (phase);
 }
 
 
 void GrainVoice::setPitchRatio(GrainSound* sound, int midiNoteNumber)
 {
-    int midiNoteParam = 0;
+    // the tape's sample rate is taken into account per slot, see startGrain()
     if(sound->pitchModeParam)
     {
-        midiNoteParam = (midiNoteNumber + (int) sound->transpositionParam) % 120;
+        auto midiNoteParam = (midiNoteNumber + (int) sound->transpositionParam) % 120;
         if(midiNoteParam < 0)
             midiNoteParam = 0;
+
+        pitchRatio = semitoneRatios.get (midiNoteParam - sound->midiRootNote) * expression.bendRatio;
     }
     else
     {
-        midiNoteParam = 60 + (int) sound->transpositionParam;
+        // position mode plays every zone at its own pitch, only the transposition moves it
+        pitchRatio = semitoneRatios.get ((int) sound->transpositionParam) * expression.bendRatio;
     }
-    pitchRatio = std::pow (2.0, (midiNoteParam - sound->midiRootNote) / 12.0) * sound->sourceSampleRate / getSampleRate();
 
 }
 
 void GrainVoice::setEnvelopeFrequency(GrainSound* sound)
 {
-    auto frequency = 1 / ( (sound->durationParam / pitchRatio) / getSampleRate());
+    // when synced every grain lasts exactly one step of the host grid
+    if (sound->grainClock != nullptr && sound->grainClock->isSynced())
+    {
+        envCurve.setFrequency ((float) (getSampleRate() / (sound->grainClock->getSamplesPerGrain() * oversampling)), getSampleRate());
+        return;
+    }
+
+    auto frequency = 1 / (grainLength / getSampleRate());
     envCurve.setFrequency ((float) frequency, getSampleRate());
 }
 
 void GrainVoice::setCurrentFluxPosition(GrainSound* sound)
 {
-    int keyRange = (int)(sound->numOfKeysAvailable * sound->fluxRangeParam);
+    // a range of zero keys would divide by zero below
+    int keyRange = juce::jmax (1, (int)(sound->numOfKeysAvailable * sound->fluxRangeParam));
     switch (sound->fluxModeParam)
     {
         case 1 : case 2 :
@@ -300,7 +994,7 @@ void GrainVoice::setCurrentFluxPosition(GrainSound* sound)
             if(numToChange <= 0)
             {
                 numToChange *= -1;
-                numToChange = (numToChange + 1) % (int) std::ceil(keyRange / 2);
+                numToChange = (numToChange + 1) % juce::jmax (1, keyRange / 2);
             }
             else
             {
@@ -308,13 +1002,46 @@ void GrainVoice::setCurrentFluxPosition(GrainSound* sound)
             }
             break;
         case 4 :
-            numToChange = std::rand() % keyRange;
+            numToChange = random.nextInt (keyRange);
+            break;
+        case 5 :
+            numToChange = 0;
+            walkToSimilarGrain (sound);
             break;
         default:
             numToChange = 0;
     }
 }
 
+void GrainVoice::walkToSimilarGrain (GrainSound* sound)
+{
+    auto* tape = sound->getPrimaryTape();
+
+    // a tape that wasn't analysed stays at the note's own position
+    if (tape == nullptr || tape->getSimilarity().isEmpty())
+    {
+        similarPhase = -1.0;
+        return;
+    }
+
+    // the first step goes from where the last grain really started, with every offset it had - after that
+    // the walk only ever plays the windows' own phases
+    auto& index = tape->getSimilarity();
+    auto playedPhase = stretching ? stretchGrains[(size_t) newestStretchGrain].startPhase : grainStartPhase;
+    auto from = index.getWindow (similarPhase >= 0.0 ? similarPhase : playedPhase);
+
+    auto numChoices = juce::jlimit (1, (int) SimilarityIndex::numNeighbours, juce::roundToInt (sound->fluxRangeParam * SimilarityIndex::numNeighbours));
+    auto rank = random.nextInt (numChoices);
+    auto to = index.getNeighbour (from, rank);
+
+    // two grains that are each other's nearest would just swap back and forth
+    if (to == previousSimilarWindow && numChoices > 1)
+        to = index.getNeighbour (from, (rank + 1) % numChoices);
+
+    previousSimilarWindow = from;
+    similarPhase = index.getPhase (to);
+}
+
 
 
 
@@ -10,21 +10,32 @@
 
 #pragma once
 
-#include <JuceHeader.h>
+#include <juce_audio_basics/juce_audio_basics.h>
 #include "WavetableEnvelope.h"
+#include "GrainClock.h"
+#include "GrainTape.h"
+#include "GrainTelemetry.h"
 
 
+//==============================================================================
+/** Offsets the modulation matrix's velocity and key routes add to one note's parameters,
+    in the parameters' own units. */
+struct NoteModulation
+{
+    float position = 0.0f;
+    float duration = 0.0f;
+    float spread = 0.0f;
+};
 
 class GrainSound : public juce::SynthesiserSound
 {
 public:
+    /** The sound starts with empty tape slots, see setTape(). */
     GrainSound (const juce::String& name,
-                juce::AudioFormatReader& source,
                   const juce::BigInteger& midiNotes,
                   int midiNoteForNormalPitch,
                   double attackTimeSecs,
-                  double releaseTimeSecs,
-                  double maxSampleLengthSeconds);
+                  double releaseTimeSecs);
 
     /** Destructor. */
     ~GrainSound() override;
@@ -33,41 +44,119 @@ public:
     bool appliesToChannel (int midiChannel) override;
     
     int getNumKeysAvailable() { return numOfKeysAvailable; }
-    double getDurationParam() { return durationParam; }
     double getPositionsParam() { return positionParam; }
     float getSpreadParam() { return spreadParam; }
-    
-    void updateParams(float mode, int availableKeys, double position, double duration, float spread, std::vector<float> fluxMode, int rootNote, float fluxModeRange);
 
+    /** The grain length for a given tape - long tapes are scaled down so the grains don't get too long.
+        durationOffset is added to the duration parameter first, for a note's own modulation. */
+    double getDurationInSamples (const GrainTape& tape, double durationOffset = 0.0) const;
     
-    
-    
+    /** fluxMode is 0 when flux mode is off, or 1 - 5 for the active flux mode. */
+    void updateParams(float mode, int availableKeys, double position, double duration, float spread, int fluxMode, int rootNote, float fluxModeRange);
+    void setGrainClock (const GrainClock* clock) { grainClock = clock; }
+
+    /** The grain envelope's shape, 0 - 1. Voices pick up a new shape when their next note starts. */
+    void setEnvelopeShape (float shape) { envelopeShape = shape; }
+
+    /** Only active sounds get new notes, voices that are already playing keep going. */
+    void setActive (bool shouldBeActive) { active = shouldBeActive; }
+
+    /** Shifts every start position by a fraction of the tape, used to keep the live tape's positions relative to its write head. */
+    void setPositionOffset (double offset) { positionOffset = offset; }
+
+    /** The velocities this sound answers to, used for the layers of a bank. */
+    void setVelocityRange (float lowest, float highest) { lowestVelocity = lowest; highestVelocity = highest; }
+
+    /** Set by GrainSynthesiser while it starts a note, so appliesToNote() can check the velocity.
+        A negative value lets every velocity through. */
+    void setIncomingVelocity (float velocity) { incomingVelocity = velocity; }
+
+    /** How much a note's velocity (0 - 1) and key (-1 - 1 around the root note) move its parameters,
+        see ModulationMatrix. Voices pick them up when their next note starts. */
+    void setNoteModulation (const NoteModulation& byVelocity, const NoteModulation& byKey) { velocityModulation = byVelocity; keyModulation = byKey; }
+
+    /** In time-stretch mode every note scans the tape at speed (1 is the tape's own speed), independently
+        of its pitch. Voices pick up the mode when their next note starts, the speed straight away. */
+    void setTimeStretch (bool shouldStretch, float speed) { timeStretchParam = shouldStretch; stretchSpeedParam = speed; }
+
+    /** Every grain gets its tape's loudness gain for where it starts, see LoudnessIndex. Grains that
+        are already playing keep the gain they started with. */
+    void setNormalise (bool shouldNormalise) { normaliseParam = shouldNormalise; }
+
+    //==============================================================================
+    static constexpr int numTapeSlots = 4;
+
+    /** Puts a tape into one of the slots and returns the one that was there before.
+        The synth's lock has to be held while calling this - and the old tape should be
+        released after the lock has been let go. */
+    GrainTape::Ptr setTape (int slot, GrainTape::Ptr newTape);
+    GrainTape* getTape (int slot) const { return tapes[(size_t) slot].get(); }
+
+    /** The tape closest to the crossfade position, or any loaded one if that slot is empty. */
+    GrainTape* getPrimaryTape() const;
+    int getPrimarySlot() const;
+
+    /** Fades between neighbouring slots, 0 is the first slot and numTapeSlots - 1 the last. */
+    void setTapeCrossfade (float slotPosition) { tapeCrossfade = juce::jlimit (0.0f, (float) (numTapeSlots - 1), slotPosition); }
+    float getTapeCrossfade() const { return tapeCrossfade.load(); }
     
 private:
     friend class GrainVoice;
     
     juce::String name;
-    std::unique_ptr<juce::AudioBuffer<float>> data;
-    double sourceSampleRate;
     juce::BigInteger midiNotes;
-    int length = 0, midiRootNote = 0;
+    int midiRootNote = 0;
+
+    std::array<GrainTape::Ptr, numTapeSlots> tapes;
+    std::atomic<float> tapeCrossfade { 0.0f };     // set on the audio thread, the editor reads it too
     
     juce::ADSR::Parameters params;
     
     bool pitchModeParam = false;
-    double positionParam = 11025;
+    double positionParam = 0.25;
+    double positionOffset = 0;
+    bool active = true;
+
+    float lowestVelocity = 0.0f, highestVelocity = 1.0f;
+    float incomingVelocity = -1.0f;
+    NoteModulation velocityModulation, keyModulation;
+
+    bool timeStretchParam = false;
+    float stretchSpeedParam = 1.0f;
+    bool normaliseParam = false;
     float transpositionParam = 60.0f;   //midiRoot
-    double durationParam = 36075;
+    double durationParam = 0.15;
     int numOfKeysAvailable = 12;
     float spreadParam = 0.2f;
+    float envelopeShape = 0.0f;
 
     int fluxModeParam = 0;
     float fluxRangeParam = 0;
 
+    const GrainClock* grainClock = nullptr;
+
     JUCE_LEAK_DETECTOR (GrainSound)
 };
 
 
+//==============================================================================
+/**
+    One voice's own share of the grain parameters, moved by per-note MPE
+    expression: slide (CC 74) shifts the position, pressure narrows the spread
+    and stretches the grains, pitch bend bends the note.
+
+    It lives inside the voice, so the grain maths reads it without going
+    through the sound - at rest it changes nothing.
+*/
+struct NoteExpression
+{
+    float positionOffset = 0.0f;    // a fraction of the tape
+    float spreadScale = 1.0f;
+    float durationScale = 1.0f;
+    float pitchBend = 0.0f;         // semitones
+    double bendRatio = 1.0;
+};
+
 class GrainVoice : public juce::SynthesiserVoice
 {
 public:
@@ -87,18 +176,77 @@ public:
 
     void pitchWheelMoved (int newValue) override;
     void controllerMoved (int controllerNumber, int newValue) override;
+    void channelPressureChanged (int newChannelPressureValue) override;
+    void aftertouchChanged (int newAftertouchValue) override;
+
+    /** Pressure and slide the note's channel had before the note started, 0 - 1.
+        GrainSynthesiser sets them before every note-on, MPE controllers send them first. */
+    void setChannelExpression (float pressure, float slide) noexcept    { channelPressure = pressure; channelSlide = slide; }
+
+    const NoteExpression& getExpression() const noexcept                { return expression; }
+
+    /** Member channels bend as far as MPE says by default, channel 1 as far as a normal pitch wheel. */
+    static constexpr float mpeBendRange = 48.0f;
+    static constexpr float channelOneBendRange = 2.0f;
+    static constexpr float slideRange = 0.25f;
+    static constexpr int slideController = 74;
 
     void renderNextBlock (juce::AudioBuffer<float>&, int startSample, int numSamples) override;
     using juce::SynthesiserVoice::renderNextBlock;
+
+    /** Linear is cheap enough for playing live, Hermite sounds cleaner when a tape gets transposed.
+        Nearest just reads the sample before, for when the engine runs out of time. */
+    enum class Interpolation { nearest, linear, hermite };
+    void setInterpolation (Interpolation newInterpolation) noexcept { interpolation = newInterpolation; }
+
+    /** Seeds the random flux mode, so an offline render can be repeated exactly. */
+    void setRandomSeed (juce::int64 seed) { random.setSeed (seed); }
     
-    double setStartPosition(GrainSound* sound, bool newlyStarted);
+    double getStartPhase(GrainSound* sound);
     void setPitchRatio(GrainSound* sound, int midiNoteNumber);
     void setEnvelopeFrequency(GrainSound* sound);
     void setCurrentFluxPosition(GrainSound* sound);
+
+    /** The similarity flux mode: steps from the current grain to one that sounds like it, see SimilarityIndex.
+        The flux range decides how far down the list of the nearest ones a step can go. The grains then
+        start at the window it stepped to, without the position offsets. */
+    void walkToSimilarGrain (GrainSound* sound);
     
     
     double getPosition();
     int getCurrentMidiNumber() { return currentMidiNumber; }
+
+    /** Called on the audio thread after rendering, for the editor's telemetry. */
+    GrainState getGrainState();
+
+    /** How many grains started since the last call - the engine adds these up for its load display. */
+    int takeNumGrainsStarted() noexcept     { return std::exchange (numGrainsStarted, 0); }
+
+    /** The note's envelope and velocity at the end of the last block, without the grain envelope. */
+    float getEnvelopeLevel() const noexcept { return adsrLevel * lgain; }
+
+    /** What the voice put out at the end of the last block - note envelope, grain envelope and velocity. */
+    float getAmplitude() const noexcept     { return envelopeLevel * lgain; }
+
+    /** The fraction of real time rendering this voice takes, averaged over its last few blocks. */
+    float getLoad() const noexcept          { return load; }
+
+    /** Releases the note within a few milliseconds, for when the voice has to make room for another one. */
+    void fadeOut();
+    static constexpr float fadeOutSeconds = 0.005f;
+
+    /** The sample in the coming block at which the next startNote() or stopNote() happens, at the output rate.
+        GrainSynthesiser sets it on the voices an event starts or stops, so the block never gets split. */
+    void setEventOffset (int offset) noexcept   { eventOffset = offset; }
+
+    /** Renders at factor times baseSampleRate from the next block on, see Oversampler. A note that's playing
+        carries on where it was - everything the voice counts in samples gets rescaled. */
+    void setOversampling (int factor, double baseSampleRate);
+    int getOversampling() const noexcept        { return oversampling; }
+
+    /** How fast the note reads its tape compared to the output rate without oversampling -
+        above 1 the tape's top end folds back below the Nyquist frequency. 0 when no note is playing. */
+    double getPlaybackRatio() const;
     
     void createWavetableEnv();
 
@@ -107,17 +255,93 @@ public:
     
     
 private:
+    /** Renders from startSample up to endSample, isHeld restarts the grains until the note is released. */
+    void renderNote (juce::AudioBuffer<float>& outputBuffer, GrainSound* sound, int startSample, int endSample, bool isHeld);
+    void renderGrain (juce::AudioBuffer<float>& outputBuffer, GrainSound& sound, int startSample, int numSamples);
+    void startGrain (GrainSound* sound, bool newlyStarted);
+    void retriggerGrain (GrainSound* sound);
+
+    //==============================================================================
+    /** A grain of the time-stretch mode - it stays where the playhead was when it started,
+        several of them overlap so the playhead's movement comes out smooth. */
+    struct StretchGrain
+    {
+        double startPhase = 0;      // a fraction of the tape
+        double pitchRatio = 1;
+        double length = 0;          // in output samples
+        double age = 0;
+        bool active = false;
+        std::array<float, GrainSound::numTapeSlots> loudnessGains {};
+    };
+
+    void renderStretch (juce::AudioBuffer<float>& outputBuffer, GrainSound& sound, int startSample, int endSample);
+    void renderStretchGrain (StretchGrain& grain, GrainSound& sound, float crossfade, float* outL, float* outR, const float* envelope, int numSamples);
+    void startStretchGrain (GrainSound& sound);
+    void advancePlayhead (GrainSound& sound, int numSamples);
+    float interpolate (const float* in, int pos, float alpha) const noexcept;
+
+    static constexpr int maxStretchGrains = 4;
+    static constexpr int stretchOverlap = 2;
+
+    bool stretching = false;
+    bool firstStretchGrain = false;
+    std::array<StretchGrain, maxStretchGrains> stretchGrains;
+    int newestStretchGrain = 0;
+    int samplesToNextStretchGrain = 0;
+    double scanOffset = 0;          // how far the playhead has moved since the note started, a fraction of the tape
+
+    void setPitchBend (int pitchWheelValue);
+    void setPressure (float pressure);
+    void setSlide (float slide);
+
+    /** One read head per tape slot, so a crossfade doesn't interrupt the grain. */
+    struct TapeReader
+    {
+        const GrainTape* tape = nullptr;
+        int tapeLength = 0;
+        double startPosition = 0;
+        double position = 0;
+        double increment = 0;
+        float loudnessGain = 1.0f;
+        bool inSync = false;
+    };
+
+    void renderTape (TapeReader& reader, const GrainTape& tape, float* outL, float* outR, const float* envelope, float gain, int numSamples);
+
+    static constexpr int renderChunkSize = 64;
+
+    Interpolation interpolation = Interpolation::linear;
+
     double sampleRate = 0;
     bool keyIsDown = false;
+    bool grainPhasePending = false;
     
-    double startPosition = 0;
     int currentMidiNumber = 0;
     int numToChange = 0;
+    double similarPhase = -1.0;         // where the similarity walk got to, below 0 before its first step
+    int previousSimilarWindow = -1;
+    int numGrainsStarted = 0;
+    bool normalising = false;
     
     double pitchRatio = 0;
-    double sourceSamplePosition = 0;
+    std::array<TapeReader, GrainSound::numTapeSlots> readers;
+    double grainStartPhase = 0;
+    double grainLength = 0;
     double numPlayedSamples = 0;
     float lgain = 0, rgain = 0;
+    float adsrLevel = 0;
+    float envelopeLevel = 0;
+    float load = 0;
+
+    int eventOffset = 0;
+    int oversampling = 1;
+    int startOffset = 0;
+    int releaseOffset = -1;
+    bool released = false;
+
+    NoteExpression expression;
+    NoteModulation noteModulation;
+    float channelPressure = 0.0f, channelSlide = 0.5f;
 
     //needs to be over the actual range - value of 1.0f will throw error when envShape value is really one
     float envShapeValue = 2.0f;
@@ -127,6 +351,9 @@ private:
     juce::ADSR adsr;
     
     WavetableEnvelope envCurve;
+
+    // std::rand() takes a lock in some C libraries, so every voice has its own generator
+    juce::Random random;
     
     JUCE_LEAK_DETECTOR (GrainVoice)
 };
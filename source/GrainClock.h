@@ -0,0 +1,116 @@
+/*
+  ==============================================================================
+
+    GrainClock.h
+    Created: 19 Oct 2026 10:12:31am
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+//==============================================================================
+/**
+    Works out where grain boundaries fall inside the current block when the
+    grains are synced to the host tempo.
+
+    update() is called once per block from processBlock with the host's bpm and
+    ppq position. It precomputes the sample offsets of every grid line (e.g. every
+    1/16 note) inside the block, so the voices only have to walk a short list
+    instead of testing every sample. When the host isn't playing the clock keeps
+    running on its own so the grid stays regular.
+*/
+class GrainClock
+{
+public:
+    GrainClock() {}
+
+    void prepare (double newSampleRate)
+    {
+        sampleRate = newSampleRate;
+        freeRunningPpq = 0.0;
+        numBoundaries = 0;
+    }
+
+    /** beatsPerGrain is the grid length in quarter notes, e.g. 0.25 for 1/16 notes. */
+    void update (bool shouldBeSynced, double bpm, double ppqPosition, bool hostIsPlaying, int numSamples, double beatsPerGrain)
+    {
+        synced = shouldBeSynced && sampleRate > 0.0;
+        numBoundaries = 0;
+
+        if (sampleRate <= 0.0)
+            return;
+
+        if (bpm <= 0.0)
+            bpm = 120.0;
+
+        auto beatsPerSample = bpm / (60.0 * sampleRate);
+        samplesPerGrain = beatsPerGrain / beatsPerSample;
+
+        auto blockStartPpq = hostIsPlaying ? ppqPosition : freeRunningPpq;
+        freeRunningPpq = blockStartPpq + numSamples * beatsPerSample;
+        ppqAtBlockStart = blockStartPpq;
+        gridLength = beatsPerGrain;
+
+        if (! synced)
+            return;
+
+        // A grid line that fell less than one sample before this block was rounded up
+        // into this block by the previous one, so start searching one sample early.
+        auto gridIndex = std::ceil ((blockStartPpq - beatsPerSample) / beatsPerGrain);
+
+        while (numBoundaries < maxBoundariesPerBlock)
+        {
+            auto offset = (int) std::ceil ((gridIndex * beatsPerGrain - blockStartPpq) / beatsPerSample);
+
+            if (offset >= numSamples)
+                break;
+
+            if (offset >= 0)
+                boundaries[(size_t) numBoundaries++] = offset;
+
+            gridIndex += 1.0;
+        }
+    }
+
+    bool isSynced() const noexcept                  { return synced; }
+    int getNumBoundaries() const noexcept           { return numBoundaries; }
+    int getBoundary (int index) const noexcept      { return boundaries[(size_t) index]; }
+    double getSamplesPerGrain() const noexcept      { return samplesPerGrain; }
+
+    /** Where inside the current grid step the given sample of this block lies, from 0 to 1. */
+    double getPhaseAt (int sampleOffset) const noexcept
+    {
+        if (samplesPerGrain <= 0.0)
+            return 0.0;
+
+        auto beatsPerSample = gridLength / samplesPerGrain;
+        auto ppq = ppqAtBlockStart + sampleOffset * beatsPerSample;
+        auto phase = ppq / gridLength - std::floor (ppq / gridLength);
+        return juce::jlimit (0.0, 1.0, phase);
+    }
+
+    /** Grid lengths in quarter notes for the "syncDivision" parameter choices. */
+    static double getBeatsForDivision (int divisionIndex)
+    {
+        static const double divisions[] = { 4.0, 2.0, 1.0, 0.5, 0.25, 0.125 };
+        return divisions[juce::jlimit (0, (int) juce::numElementsInArray (divisions) - 1, divisionIndex)];
+    }
+
+    static constexpr int maxBoundariesPerBlock = 64;
+
+private:
+    double sampleRate = 0;
+    bool synced = false;
+
+    double samplesPerGrain = 0;
+    double gridLength = 0.25;
+    double ppqAtBlockStart = 0;
+    double freeRunningPpq = 0;
+
+    std::array<int, maxBoundariesPerBlock> boundaries {};
+    int numBoundaries = 0;
+};
@@ -0,0 +1,166 @@
+/*
+  ==============================================================================
+
+    GrainParameters.h
+    Created: 21 Oct 2026 9:40:12am
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+//==============================================================================
+/** One route of the modulation matrix, see ModulationMatrix for the sources and destinations. */
+struct ModulationRoute
+{
+    int source = 0;                     // 0 = none
+    int destination = 0;                // 0 = none
+    float amount = 0.0f;                // -1 - 1, a fraction of the destination's whole range
+};
+
+//==============================================================================
+/**
+    The parameter values for one block, as plain numbers.
+
+    The plugin fills this in from its AudioProcessorValueTreeState, the offline
+    tools fill it in directly - so the engine never has to know where the values
+    came from. The defaults are the same as the plugin's parameter defaults.
+*/
+struct GrainParameters
+{
+    float playMode = 1.0f;              // 0 = position mode, 1 = pitch mode
+    int numKeys = 0;                    // index into 12 / 24 / 48 / 96 keys
+    double position = 0.25;
+    double duration = 0.15;
+    float spread = 1.0f;
+    float gain = 0.7f;
+    float envelopeShape = 0.0f;
+    int transpose = 0;
+
+    bool fluxModeOn = false;
+    std::array<bool, 5> fluxModes {};
+    float fluxModeRange = 0.5f;
+
+    bool tempoSync = false;
+    int syncDivision = 4;
+
+    bool liveInput = false;
+    bool freeze = false;
+    bool overdub = false;
+    bool resample = false;
+
+    float tapeSlot = 0.0f;
+    bool bankMode = false;
+
+    bool timeStretch = false;
+    float stretchSpeed = 1.0f;          // how fast the playhead scans the tape, 0 freezes it, below 0 reverses it
+
+    static constexpr float maxStretchSpeed = 2.0f;
+
+    int oversampling = 0;               // 0 = off, 1 = up to 2x, 2 = up to 4x - see TapeEngine::chooseOversampling()
+
+    bool normalise = false;             // evens out the grains' levels, see LoudnessIndex
+
+    static constexpr int numLfos = 3;
+    static constexpr int numModulationRoutes = 6;
+
+    std::array<float, numLfos> lfoRates { { 0.25f, 1.0f, 4.0f } };     // Hz
+    std::array<int, numLfos> lfoShapes {};                              // see ModulationMatrix::Shape
+    float randomRate = 2.0f;                                            // Hz, for both random sources
+    std::array<ModulationRoute, numModulationRoutes> modulationRoutes {};
+
+    /** Sets a value by the ID of the plugin parameter it comes from, in the same units -
+        so a saved plugin state can be applied without the plugin. Returns false for an unknown ID.
+    */
+    bool setValue (const juce::String& parameterID, float value)
+    {
+        auto isOn = value >= 0.5f;
+
+        if      (parameterID == "playMode")         playMode = value;
+        else if (parameterID == "numKeys")          numKeys = (int) value;
+        else if (parameterID == "position")         position = (double) value;
+        else if (parameterID == "duration")         duration = (double) value;
+        else if (parameterID == "spread")           spread = value;
+        else if (parameterID == "gain")             gain = value;
+        else if (parameterID == "envShape")         envelopeShape = value;
+        else if (parameterID == "transpose")        transpose = (int) value;
+        else if (parameterID == "fluxModeOn")       fluxModeOn = isOn;
+        else if (parameterID == "firstFluxMode")    fluxModes[0] = isOn;
+        else if (parameterID == "secondFluxMode")   fluxModes[1] = isOn;
+        else if (parameterID == "thirdFluxMode")    fluxModes[2] = isOn;
+        else if (parameterID == "fourthFluxMode")   fluxModes[3] = isOn;
+        else if (parameterID == "fifthFluxMode")    fluxModes[4] = isOn;
+        else if (parameterID == "fluxModeRange")    fluxModeRange = value;
+        else if (parameterID == "tempoSync")        tempoSync = isOn;
+        else if (parameterID == "syncDivision")     syncDivision = (int) value;
+        else if (parameterID == "liveInput")        liveInput = isOn;
+        else if (parameterID == "freeze")           freeze = isOn;
+        else if (parameterID == "overdub")          overdub = isOn;
+        else if (parameterID == "resample")         resample = isOn;
+        else if (parameterID == "tapeSlot")         tapeSlot = value;
+        else if (parameterID == "bankMode")         bankMode = isOn;
+        else if (parameterID == "timeStretch")      timeStretch = isOn;
+        else if (parameterID == "stretchSpeed")     stretchSpeed = value;
+        else if (parameterID == "oversampling")     oversampling = (int) value;
+        else if (parameterID == "normalise")        normalise = isOn;
+        else if (parameterID == "randomRate")       randomRate = value;
+        else                                        return setModulationValue (parameterID, value);
+
+        return true;
+    }
+
+    /** The numbered parameters: lfo1Rate, lfo1Shape, ... and mod1Source, mod1Destination, mod1Amount, ... */
+    bool setModulationValue (const juce::String& parameterID, float value)
+    {
+        const auto index = parameterID.substring (3, 4).getIntValue() - 1;
+        const auto field = parameterID.substring (4);
+
+        if (parameterID.startsWith ("lfo") && juce::isPositiveAndBelow (index, numLfos))
+        {
+            if      (field == "Rate")               lfoRates[(size_t) index] = value;
+            else if (field == "Shape")              lfoShapes[(size_t) index] = (int) value;
+            else                                    return false;
+
+            return true;
+        }
+
+        if (parameterID.startsWith ("mod") && juce::isPositiveAndBelow (index, numModulationRoutes))
+        {
+            auto& route = modulationRoutes[(size_t) index];
+
+            if      (field == "Source")             route.source = (int) value;
+            else if (field == "Destination")        route.destination = (int) value;
+            else if (field == "Amount")             route.amount = value;
+            else                                    return false;
+
+            return true;
+        }
+
+        return false;
+    }
+
+    /** 0 when flux mode is off, otherwise 1 - 5 - the last one that's switched on wins. */
+    int getActiveFluxMode() const noexcept
+    {
+        if (! fluxModeOn)
+            return 0;
+
+        for (int i = (int) fluxModes.size(); --i >= 0;)
+            if (fluxModes[(size_t) i])
+                return i + 1;
+
+        return 0;
+    }
+};
+
+//==============================================================================
+/** What the host's transport was doing at the start of the block. */
+struct TransportInfo
+{
+    double bpm = 120.0;
+    double ppqPosition = 0.0;
+    bool isPlaying = false;
+};
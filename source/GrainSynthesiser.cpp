@@ -0,0 +1,363 @@
+/*
+  ==============================================================================
+
+    GrainSynthesiser.cpp
+    Created: 20 Oct 2026 7:24:18pm
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#include "GrainSynthesiser.h"
+
+GrainVoice* GrainSynthesiser::addVoice (GrainVoice* newVoice)
+{
+    const juce::ScopedLock sl (lock);
+
+    juce::Synthesiser::addVoice (newVoice);
+    grainVoices.push_back (newVoice);
+    return newVoice;
+}
+
+juce::SynthesiserSound* GrainSynthesiser::addSound (const juce::SynthesiserSound::Ptr& newSound)
+{
+    const juce::ScopedLock sl (lock);
+
+    auto* sound = juce::Synthesiser::addSound (newSound);
+    updateGrainSounds();
+    return sound;
+}
+
+void GrainSynthesiser::removeSound (int index)
+{
+    const juce::ScopedLock sl (lock);
+
+    juce::Synthesiser::removeSound (index);
+    updateGrainSounds();
+}
+
+void GrainSynthesiser::clearSounds()
+{
+    const juce::ScopedLock sl (lock);
+
+    juce::Synthesiser::clearSounds();
+    grainSounds.clear();
+}
+
+void GrainSynthesiser::updateGrainSounds()
+{
+    grainSounds.clear();
+
+    for (auto* sound : sounds)
+        if (auto* grainSound = dynamic_cast<GrainSound*> (sound))
+            grainSounds.push_back (grainSound);
+}
+
+//==============================================================================
+void GrainSynthesiser::noteOn (int midiChannel, int midiNoteNumber, float velocity)
+{
+    const juce::ScopedLock sl (lock);
+
+    if (! isHandlingEvents)
+        usage = getUsage();
+
+    // the same as juce::Synthesiser::noteOn(), but only the voices it touches get the event's offset
+    for (auto* sound : grainSounds)
+    {
+        // note-offs have to find their sound whatever layer it's in, so only note-ons check the velocity
+        sound->setIncomingVelocity (velocity);
+        const bool applies = sound->appliesToNote (midiNoteNumber) && sound->appliesToChannel (midiChannel);
+        sound->setIncomingVelocity (-1.0f);
+
+        if (! applies)
+            continue;
+
+        // a note that's still ringing gets stopped first - the sustain or sostenuto pedal may be holding it
+        for (auto* voice : grainVoices)
+            if (voice->getCurrentlyPlayingNote() == midiNoteNumber && voice->isPlayingChannel (midiChannel))
+                stopVoice (*voice, 1.0f, true);
+
+        if (auto* voice = static_cast<GrainVoice*> (findFreeVoice (sound, midiChannel, midiNoteNumber, isNoteStealingEnabled())))
+        {
+            if (voice->isVoiceActive() && voice->isKeyDown())
+                removeFromUsage (*voice);
+
+            setChannelExpression (*voice, midiChannel);
+
+            voice->setEventOffset (eventOffset);
+            startVoice (voice, sound, midiChannel, midiNoteNumber, velocity);
+            voice->setEventOffset (0);
+
+            ++usage.numHeld;
+            usage.load += voice->getLoad();
+        }
+    }
+}
+
+void GrainSynthesiser::noteOff (int midiChannel, int midiNoteNumber, float velocity, bool allowTailOff)
+{
+    const juce::ScopedLock sl (lock);
+
+    // the same as juce::Synthesiser::noteOff(), keeping the held voices' usage up to date
+    for (auto* voice : grainVoices)
+    {
+        if (voice->getCurrentlyPlayingNote() != midiNoteNumber || ! voice->isPlayingChannel (midiChannel))
+            continue;
+
+        auto sound = voice->getCurrentlyPlayingSound();
+        if (sound == nullptr || ! sound->appliesToNote (midiNoteNumber) || ! sound->appliesToChannel (midiChannel))
+            continue;
+
+        if (voice->isKeyDown())
+            removeFromUsage (*voice);
+
+        voice->setKeyDown (false);
+
+        if (! (voice->isSustainPedalDown() || voice->isSostenutoPedalDown()))
+            stopVoice (*voice, velocity, allowTailOff);
+    }
+}
+
+void GrainSynthesiser::renderBlock (juce::AudioBuffer<float>& output, const MidiIngest& ingest, int numSamples)
+{
+    handleEvents (ingest);
+    renderVoices (output, numSamples);
+}
+
+void GrainSynthesiser::handleEvents (const MidiIngest& ingest)
+{
+    const juce::ScopedLock sl (lock);
+
+    // everything but the notes and pedals only counts once per block, see MidiIngest
+    for (auto& control : ingest.getControls())
+    {
+        switch (control.type)
+        {
+            case MidiIngest::Control::Type::controller:
+                handleController (control.channel, control.number, control.value);
+                break;
+
+            case MidiIngest::Control::Type::pitchWheel:
+                lastPitchWheelValues[control.channel - 1] = control.value;
+                handlePitchWheel (control.channel, control.value);
+                break;
+
+            case MidiIngest::Control::Type::channelPressure:
+                handleChannelPressure (control.channel, control.value);
+                break;
+
+            case MidiIngest::Control::Type::aftertouch:
+                handleAftertouch (control.channel, control.number, control.value);
+                break;
+        }
+    }
+
+    // the held voices are counted once for the whole block, every note-on and note-off keeps the count up to date
+    usage = getUsage();
+    isHandlingEvents = true;
+
+    for (auto& event : ingest.getEvents())
+    {
+        eventOffset = event.sampleOffset;
+
+        switch (event.type)
+        {
+            case MidiIngest::Event::Type::noteOn:
+                noteOn (event.channel, event.number, event.velocity);
+                break;
+
+            case MidiIngest::Event::Type::noteOff:
+                noteOff (event.channel, event.number, event.velocity, true);
+                break;
+
+            case MidiIngest::Event::Type::controller:
+                handleOrderedController (event.channel, event.number, event.value);
+                break;
+        }
+    }
+
+    isHandlingEvents = false;
+    eventOffset = 0;
+}
+
+void GrainSynthesiser::renderVoices (juce::AudioBuffer<float>& output, int numSamples)
+{
+    juce::Synthesiser::renderNextBlock (output, noEvents, 0, numSamples);
+}
+
+void GrainSynthesiser::stopVoice (GrainVoice& voice, float velocity, bool allowTailOff)
+{
+    if (voice.isVoiceActive() && voice.isKeyDown())
+        removeFromUsage (voice);
+
+    voice.setEventOffset (eventOffset);
+    voice.stopNote (velocity, allowTailOff);
+    voice.setEventOffset (0);
+}
+
+void GrainSynthesiser::setChannelExpression (GrainVoice& voice, int midiChannel) const
+{
+    if (midiChannel < 1 || midiChannel > 16)
+        return;
+
+    voice.setChannelExpression (channelPressures[(size_t) (midiChannel - 1)], channelSlides[(size_t) (midiChannel - 1)]);
+}
+
+void GrainSynthesiser::handleController (int midiChannel, int controllerNumber, int controllerValue)
+{
+    if (controllerNumber == GrainVoice::slideController && midiChannel >= 1 && midiChannel <= 16)
+        channelSlides[(size_t) (midiChannel - 1)] = (float) controllerValue / 127.0f;
+
+    juce::Synthesiser::handleController (midiChannel, controllerNumber, controllerValue);
+}
+
+void GrainSynthesiser::handleChannelPressure (int midiChannel, int channelPressureValue)
+{
+    if (midiChannel >= 1 && midiChannel <= 16)
+        channelPressures[(size_t) (midiChannel - 1)] = (float) channelPressureValue / 127.0f;
+
+    juce::Synthesiser::handleChannelPressure (midiChannel, channelPressureValue);
+}
+
+void GrainSynthesiser::handleOrderedController (int midiChannel, int controllerNumber, int controllerValue)
+{
+    // a pedal or all-notes-off can stop any number of voices, all of them at this event's sample - they're
+    // rare enough to set the offset on every voice and count the held ones again afterwards
+    for (auto* voice : grainVoices)
+        voice->setEventOffset (eventOffset);
+
+    // the same as juce::Synthesiser::handleMidiEvent()
+    if (controllerNumber == 120 || controllerNumber == 123)
+        allNotesOff (midiChannel, true);
+    else
+        handleController (midiChannel, controllerNumber, controllerValue);
+
+    for (auto* voice : grainVoices)
+        voice->setEventOffset (0);
+
+    usage = getUsage();
+}
+
+void GrainSynthesiser::fadeOutVoicesOverLimits()
+{
+    usage = getUsage();
+
+    // the last note always keeps playing, however expensive it is
+    while (usage.numHeld > 1 && isOverLimits (usage, false))
+    {
+        auto* voice = findLeastAudibleVoice (nullptr, false);
+        if (voice == nullptr)
+            break;
+
+        removeFromUsage (*voice);
+        voice->fadeOut();
+    }
+}
+
+juce::SynthesiserVoice* GrainSynthesiser::findFreeVoice (juce::SynthesiserSound* soundToPlay, int midiChannel,
+                                                         int midiNoteNumber, bool stealIfNoneAvailable) const
+{
+    if (! isOverLimits (usage, true))
+        return juce::Synthesiser::findFreeVoice (soundToPlay, midiChannel, midiNoteNumber, stealIfNoneAvailable);
+
+    if (! stealIfNoneAvailable)
+        return nullptr;
+
+    // over the limits the new note has to take a held note's place - stealing one that's already been
+    // released frees nothing, and the held notes would grow past the limits
+    auto* voiceToSteal = findLeastAudibleVoice (soundToPlay, false);
+
+    if (voiceToSteal == nullptr)
+        return nullptr;
+
+    // the stolen note fades out on its own voice while the new one starts on a free voice
+    if (auto* freeVoice = juce::Synthesiser::findFreeVoice (soundToPlay, midiChannel, midiNoteNumber, false))
+    {
+        removeFromUsage (*voiceToSteal);
+        voiceToSteal->fadeOut();
+        return freeVoice;
+    }
+
+    // nothing to spare, so the stolen note gets cut off when the new one starts
+    return voiceToSteal;
+}
+
+juce::SynthesiserVoice* GrainSynthesiser::findVoiceToSteal (juce::SynthesiserSound* soundToPlay, int midiChannel,
+                                                            int midiNoteNumber) const
+{
+    if (auto* voice = findLeastAudibleVoice (soundToPlay, true))
+        return voice;
+
+    return juce::Synthesiser::findVoiceToSteal (soundToPlay, midiChannel, midiNoteNumber);
+}
+
+GrainSynthesiser::Usage GrainSynthesiser::getUsage() const
+{
+    Usage newUsage;
+
+    for (auto* voice : grainVoices)
+    {
+        if (! voice->isVoiceActive() || ! voice->isKeyDown())
+            continue;
+
+        ++newUsage.numHeld;
+        newUsage.load += voice->getLoad();
+    }
+
+    return newUsage;
+}
+
+void GrainSynthesiser::removeFromUsage (const GrainVoice& voice) const
+{
+    usage.numHeld = juce::jmax (0, usage.numHeld - 1);
+    usage.load = juce::jmax (0.0f, usage.load - voice.getLoad());
+}
+
+bool GrainSynthesiser::isOverLimits (const Usage& heldUsage, bool withNewVoice) const
+{
+    if (heldUsage.numHeld + (withNewVoice ? 1 : 0) > maxActiveVoices)
+        return true;
+
+    if (voiceBudget <= 0.0f || heldUsage.numHeld == 0)
+        return false;
+
+    // a new note is expected to cost what the held ones cost on average
+    auto load = heldUsage.load + (withNewVoice ? heldUsage.load / (float) heldUsage.numHeld : 0.0f);
+    return load > voiceBudget;
+}
+
+GrainVoice* GrainSynthesiser::findLeastAudibleVoice (juce::SynthesiserSound* soundToPlay, bool includeReleased) const
+{
+    auto averageLoad = usage.numHeld > 0 ? usage.load / (float) usage.numHeld : 0.0f;
+
+    GrainVoice* leastAudible = nullptr;
+    float lowestScore = std::numeric_limits<float>::max();
+
+    for (auto* grainVoice : grainVoices)
+    {
+        if (! grainVoice->isVoiceActive())
+            continue;
+
+        if (soundToPlay != nullptr && ! grainVoice->canPlaySound (soundToPlay))
+            continue;
+
+        const bool isReleased = ! grainVoice->isKeyDown();
+        if (isReleased && ! includeReleased)
+            continue;
+
+        // quiet and cheap notes go first, a note that's already been released before any held one
+        auto relativeLoad = averageLoad > 0.0f ? grainVoice->getLoad() / averageLoad : 1.0f;
+        auto score = grainVoice->getAmplitude() * (0.5f + 0.5f * relativeLoad);
+
+        if (isReleased)
+            score -= 2.0f;
+
+        if (score < lowestScore)
+        {
+            lowestScore = score;
+            leastAudible = grainVoice;
+        }
+    }
+
+    return leastAudible;
+}
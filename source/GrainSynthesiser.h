@@ -0,0 +1,118 @@
+/*
+  ==============================================================================
+
+    GrainSynthesiser.h
+    Created: 20 Oct 2026 7:24:18pm
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "Grain.h"
+#include "MidiIngest.h"
+
+//==============================================================================
+/**
+    A Synthesiser that also picks sounds by velocity, and keeps the voices
+    within a voice count and a CPU budget.
+
+    SynthesiserSound only gets asked about the note, so while a note-on is being
+    handed out every GrainSound is told its velocity - that way a bank's layers
+    are chosen without changing how the base class starts voices.
+
+    A note that would take the held voices over either limit takes a voice from
+    the quietest and cheapest note instead. That note fades out over a few
+    milliseconds while the new one starts on a free voice, only when there is
+    no free voice left does it get cut off.
+*/
+class GrainSynthesiser : public juce::Synthesiser
+{
+public:
+    GrainSynthesiser()      { channelSlides.fill (0.5f); }
+
+    /** The same as the base class's, but the synth keeps its own lists of the GrainVoices and GrainSounds,
+        so handing out notes never has to dynamic_cast them. Voices have to be GrainVoices. */
+    GrainVoice* addVoice (GrainVoice* newVoice);
+    juce::SynthesiserSound* addSound (const juce::SynthesiserSound::Ptr& newSound);
+    void removeSound (int index);
+    void clearSounds();
+
+    void noteOn (int midiChannel, int midiNoteNumber, float velocity) override;
+    void noteOff (int midiChannel, int midiNoteNumber, float velocity, bool allowTailOff) override;
+
+    /** Renders a whole block in one go: all of its notes get their voices first, and every voice
+        starts and stops at its event's sample by itself instead of the block being split there.
+        The held voices are counted once per block, the note-ons and note-offs keep the count. */
+    void renderBlock (juce::AudioBuffer<float>& output, const MidiIngest& ingest, int numSamples);
+
+    /** The two halves of renderBlock(), for when something has to happen once the notes have their
+        voices - renderVoices() can get an oversampled buffer, see GrainVoice::setOversampling(). */
+    void handleEvents (const MidiIngest& ingest);
+    void renderVoices (juce::AudioBuffer<float>& output, int numSamples);
+
+    /** Caps how many notes are held at once. Call it with the lock held. */
+    void setMaxActiveVoices (int newMaxActiveVoices) noexcept   { maxActiveVoices = newMaxActiveVoices; }
+    int getMaxActiveVoices() const noexcept                      { return maxActiveVoices; }
+
+    /** The fraction of real time the held voices may take together, see GrainVoice::getLoad().
+        0 means there's no budget. Call it with the lock held. */
+    void setVoiceBudget (float newVoiceBudget) noexcept         { voiceBudget = newVoiceBudget; }
+    float getVoiceBudget() const noexcept                        { return voiceBudget; }
+
+    /** Fades out held notes until they're within both limits again - once per block, with the lock held.
+        The voices get more expensive while they play, so a budget a note-on kept to can be broken later. */
+    void fadeOutVoicesOverLimits();
+
+    /** Remembers each channel's pressure and slide, so notes that start later begin with them. */
+    void handleController (int midiChannel, int controllerNumber, int controllerValue) override;
+    void handleChannelPressure (int midiChannel, int channelPressureValue) override;
+
+protected:
+    juce::SynthesiserVoice* findFreeVoice (juce::SynthesiserSound*, int midiChannel,
+                                           int midiNoteNumber, bool stealIfNoneAvailable) const override;
+
+    juce::SynthesiserVoice* findVoiceToSteal (juce::SynthesiserSound*, int midiChannel,
+                                              int midiNoteNumber) const override;
+
+private:
+    void updateGrainSounds();
+    void stopVoice (GrainVoice& voice, float velocity, bool allowTailOff);
+    void setChannelExpression (GrainVoice& voice, int midiChannel) const;
+    void handleOrderedController (int midiChannel, int controllerNumber, int controllerValue);
+
+    struct Usage
+    {
+        int numHeld = 0;
+        float load = 0;
+    };
+
+    Usage getUsage() const;
+    void removeFromUsage (const GrainVoice& voice) const;
+    bool isOverLimits (const Usage& heldUsage, bool withNewVoice) const;
+
+    /** The voice whose note is the least missed - released ones first. soundToPlay can be nullptr. */
+    GrainVoice* findLeastAudibleVoice (juce::SynthesiserSound* soundToPlay, bool includeReleased) const;
+
+    int maxActiveVoices = std::numeric_limits<int>::max();
+    float voiceBudget = 0.0f;
+
+    std::vector<GrainVoice*> grainVoices;
+    std::vector<GrainSound*> grainSounds;
+
+    // the held voices while a block's events are handed out - findFreeVoice() is const, but a note it
+    // fades out isn't held any more
+    mutable Usage usage;
+    int eventOffset = 0;
+    bool isHandlingEvents = false;
+
+    juce::MidiBuffer noEvents;
+
+    // per MIDI channel, 0 - 1
+    std::array<float, 16> channelPressures {};
+    std::array<float, 16> channelSlides {};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GrainSynthesiser)
+};
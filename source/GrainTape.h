@@ -0,0 +1,114 @@
+/*
+  ==============================================================================
+
+    GrainTape.h
+    Created: 20 Oct 2026 11:21:07am
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "TapeArena.h"
+#include "LoudnessIndex.h"
+#include "SimilarityIndex.h"
+
+//==============================================================================
+/**
+    The audio of one tape, shared between the GrainSound slots that play it.
+
+    The buffer always has a few samples more than getLength() so the voices'
+    interpolation can read one sample past the current position.
+
+    Tapes that come from files get a LoudnessIndex and a SimilarityIndex when
+    they're loaded. The live tape never gets analysed - it plays at its own
+    level, and the similarity flux mode leaves it where it is.
+*/
+class GrainTape : public juce::ReferenceCountedObject
+{
+public:
+    using Ptr = juce::ReferenceCountedObjectPtr<GrainTape>;
+
+    GrainTape (const juce::String& tapeName,
+               std::unique_ptr<juce::AudioBuffer<float>> sourceData,
+               int sourceLength,
+               double sourceSampleRate)
+        : name (tapeName),
+          data (std::move (sourceData)),
+          length (sourceLength),
+          sampleRate (sourceSampleRate)
+    {
+        jassert (data != nullptr && data->getNumSamples() > length);
+    }
+
+    /** A tape that refers to consecutive regions of an arena, one per channel - each region needs the same padding. */
+    GrainTape (const juce::String& tapeName,
+               TapeArena::Ptr sourceArena,
+               int firstRegion,
+               int numChannels,
+               int sourceLength,
+               double sourceSampleRate)
+        : name (tapeName),
+          arena (sourceArena),
+          length (sourceLength),
+          sampleRate (sourceSampleRate)
+    {
+        jassert (arena != nullptr && firstRegion + numChannels <= arena->getNumRegions());
+
+        std::vector<float*> channels;
+        for (int channel = 0; channel < numChannels; ++channel)
+            channels.push_back (arena->getRegion (firstRegion + channel));
+
+        data = std::make_unique<juce::AudioBuffer<float>> (channels.data(), numChannels, length + padding);
+    }
+
+    /** Reads the file into memory, returns nullptr if there was nothing to read. */
+    static Ptr createFromReader (const juce::String& tapeName, juce::AudioFormatReader& source, double maxSampleLengthSeconds)
+    {
+        if (source.sampleRate <= 0 || source.lengthInSamples <= 0)
+            return nullptr;
+
+        auto sourceLength = juce::jmin ((int) source.lengthInSamples,
+                                        (int) (maxSampleLengthSeconds * source.sampleRate));
+
+        auto sourceData = std::make_unique<juce::AudioBuffer<float>> (juce::jmin (2, (int) source.numChannels), sourceLength + padding);
+        source.read (sourceData.get(), 0, sourceLength + padding, 0, true, true);
+
+        return new GrainTape (tapeName, std::move (sourceData), sourceLength, source.sampleRate);
+    }
+
+    const juce::String& getName() const noexcept                { return name; }
+    const juce::AudioBuffer<float>& getData() const noexcept    { return *data; }
+    int getLength() const noexcept                              { return length; }
+    double getSampleRate() const noexcept                       { return sampleRate; }
+
+    /** Builds the loudness and similarity indexes - only before the tape is handed to the engine,
+        the voices read them without a lock. */
+    void analyse (juce::ThreadPool* pool)
+    {
+        loudness.build (*data, length, pool);
+        similarity.build (*data, length, sampleRate, pool);
+    }
+
+    /** The gain that evens out a grain starting at phase, a fraction of the tape. 1 if the tape wasn't analysed. */
+    float getLoudnessGain (double phase) const noexcept         { return loudness.getGain (phase); }
+
+    /** Empty if the tape wasn't analysed. */
+    const SimilarityIndex& getSimilarity() const noexcept       { return similarity; }
+
+    /** The samples every tape buffer has after getLength(). */
+    static constexpr int padding = 4;
+
+private:
+    juce::String name;
+    TapeArena::Ptr arena;
+    std::unique_ptr<juce::AudioBuffer<float>> data;
+    int length = 0;
+    double sampleRate = 0;
+    LoudnessIndex loudness;
+    SimilarityIndex similarity;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GrainTape)
+};
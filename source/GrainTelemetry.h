@@ -0,0 +1,83 @@
+/*
+  ==============================================================================
+
+    GrainTelemetry.h
+    Created: 21 Oct 2026 2:31:47pm
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+//==============================================================================
+/** What the editor gets to know about one playing grain. */
+struct GrainState
+{
+    float position = 0;         // normalised to the length of the tape
+    float grainPhase = 0;       // how far through its grain the voice is, 0 to 1
+    int midiNote = 0;
+    bool isRootNote = false;
+};
+
+/** All grains that were playing at the end of one audio block, and how hard the engine is working. */
+struct GrainSnapshot
+{
+    static constexpr int maxGrains = 128;
+
+    int numGrains = 0;
+    std::array<GrainState, maxGrains> grains;
+
+    float blockLoad = 0;            // time the last block took, as a fraction of its duration
+    float peakBlockLoad = 0;        // the highest load over the last load window
+    float grainsPerSecond = 0;      // grains started, averaged over the last load window
+    int numOverruns = 0;            // blocks that took longer than their duration since prepare()
+    int qualityLevel = 0;           // see QualityGovernor::Level, 0 is full quality
+    int oversampling = 1;           // the factor the voices rendered the block at
+};
+
+//==============================================================================
+/**
+    Hands a GrainSnapshot from the audio thread to the editor once per block.
+
+    This is a triple buffer: the audio thread fills the back snapshot and swaps
+    it with the middle one, the editor swaps the middle one with its front
+    snapshot whenever there is something new. Neither side ever waits, and
+    snapshots the editor didn't get round to reading are simply overwritten.
+*/
+class GrainTelemetry
+{
+public:
+    GrainTelemetry() = default;
+
+    /** Audio thread: the snapshot to fill in before calling publish(). */
+    GrainSnapshot& getSnapshotToWrite() noexcept    { return snapshots[(size_t) backIndex]; }
+
+    /** Audio thread: makes the filled in snapshot the latest one. */
+    void publish() noexcept
+    {
+        backIndex = middle.exchange (backIndex | newDataBit) & indexMask;
+    }
+
+    /** Editor: the latest published snapshot - stays valid until the next call. */
+    const GrainSnapshot& getLatestSnapshot() noexcept
+    {
+        if ((middle.load() & newDataBit) != 0)
+            frontIndex = middle.exchange (frontIndex) & indexMask;
+
+        return snapshots[(size_t) frontIndex];
+    }
+
+private:
+    static constexpr int indexMask = 3;
+    static constexpr int newDataBit = 4;
+
+    std::array<GrainSnapshot, 3> snapshots;
+    int backIndex = 0;
+    int frontIndex = 1;
+    std::atomic<int> middle { 2 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GrainTelemetry)
+};
@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    LiveTape.cpp
+    Created: 19 Oct 2026 2:40:18pm
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#include "LiveTape.h"
+
+void LiveTape::prepare (double newSampleRate, int numChannels, double lengthInSeconds)
+{
+    sampleRate = newSampleRate;
+    length = juce::jmax (1, (int) (lengthInSeconds * sampleRate));
+
+    buffer.setSize (numChannels, length + GrainTape::padding);
+    buffer.clear();
+    writePosition = 0;
+}
+
+void LiveTape::write (const juce::AudioBuffer<float>& input, int numSamples, bool overdub)
+{
+    if (length <= 0 || input.getNumChannels() == 0)
+        return;
+
+    auto position = writePosition.load();
+    numSamples = juce::jmin (numSamples, length);
+
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+    {
+        // a mono input gets recorded on both sides of the tape
+        auto* source = input.getReadPointer (juce::jmin (channel, input.getNumChannels() - 1));
+        auto* tape = buffer.getWritePointer (channel);
+
+        auto firstPart = juce::jmin (numSamples, length - position);
+        auto secondPart = numSamples - firstPart;
+
+        if (overdub)
+        {
+            juce::FloatVectorOperations::multiply (tape + position, overdubFeedback, firstPart);
+            juce::FloatVectorOperations::add (tape + position, source, firstPart);
+            juce::FloatVectorOperations::multiply (tape, overdubFeedback, secondPart);
+            juce::FloatVectorOperations::add (tape, source + firstPart, secondPart);
+        }
+        else
+        {
+            juce::FloatVectorOperations::copy (tape + position, source, firstPart);
+            juce::FloatVectorOperations::copy (tape, source + firstPart, secondPart);
+        }
+
+        // the padding repeats the start, so the interpolation wraps around smoothly
+        for (int i = 0; i < GrainTape::padding; ++i)
+            tape[length + i] = tape[i % length];
+    }
+
+    writePosition = (position + numSamples) % length;
+}
+
+GrainTape::Ptr LiveTape::createTape()
+{
+    auto playbackBuffer = std::make_unique<juce::AudioBuffer<float>> (buffer.getArrayOfWritePointers(), buffer.getNumChannels(), buffer.getNumSamples());
+    return new GrainTape ("Live", std::move (playbackBuffer), length, sampleRate);
+}
@@ -0,0 +1,56 @@
+/*
+  ==============================================================================
+
+    LiveTape.h
+    Created: 19 Oct 2026 2:40:18pm
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "GrainTape.h"
+
+//==============================================================================
+/**
+    A circular tape that records the sidechain input while the voices are
+    playing from it.
+
+    The buffer is allocated once in prepare() and never resized while audio is
+    running. Writing happens on the audio thread only, the write position is an
+    atomic so the editor can follow it without locking. GrainTape::padding extra
+    samples at the end mirror the first ones, so the voices' Hermite
+    interpolation can read past the wrap point the same way it does for file
+    tapes.
+*/
+class LiveTape
+{
+public:
+    LiveTape() {}
+
+    void prepare (double newSampleRate, int numChannels, double lengthInSeconds);
+
+    /** Records the input into the tape. When overdubbing the old material is kept
+        and fades a little each time it gets written over. */
+    void write (const juce::AudioBuffer<float>& input, int numSamples, bool overdub);
+
+    /** Creates a tape that plays from this one's memory without owning it. */
+    GrainTape::Ptr createTape();
+
+    int getLength() const noexcept              { return length; }
+    double getSampleRate() const noexcept       { return sampleRate; }
+    int getWritePosition() const noexcept       { return writePosition.load(); }
+
+    static constexpr float overdubFeedback = 0.8f;
+
+private:
+    juce::AudioBuffer<float> buffer;
+    double sampleRate = 0;
+    int length = 0;
+
+    std::atomic<int> writePosition { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LiveTape)
+};
@@ -0,0 +1,116 @@
+/*
+  ==============================================================================
+
+    LoadOverlay.cpp
+    Created: 23 Oct 2026 4:27:10pm
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "LoadOverlay.h"
+#include "TraceZones.h"
+
+//==============================================================================
+LoadOverlay::LoadOverlay (TapePerformerAudioProcessor& p) : audioProcessor (p)
+{
+    // only the trace export needs clicks, otherwise the wave display underneath gets them
+    setInterceptsMouseClicks (Tracing::isEnabled(), false);
+
+    if (Tracing::isEnabled())
+        setMouseCursor (juce::MouseCursor::PointingHandCursor);
+
+    startTimerHz (10);
+}
+
+LoadOverlay::~LoadOverlay()
+{
+    stopTimer();
+}
+
+void LoadOverlay::paint (juce::Graphics& g)
+{
+    auto bounds = getLocalBounds().toFloat();
+
+    g.setColour (juce::Colours::black.withAlpha (0.6f));
+    g.fillRoundedRectangle (bounds, 3.0f);
+
+    auto area = getLocalBounds().reduced (4, 3);
+    auto barArea = area.removeFromLeft (40).reduced (0, 3).toFloat();
+
+    // green until half the deadline is used, red once a block doesn't fit anymore
+    auto loadColour = blockLoad < 0.5f ? juce::Colours::limegreen
+                    : blockLoad < 0.9f ? juce::Colours::orange
+                                       : juce::Colours::red;
+
+    g.setColour (juce::Colours::grey);
+    g.drawRect (barArea, 1.0f);
+    g.setColour (loadColour);
+    g.fillRect (barArea.reduced (1.0f).withWidth ((barArea.getWidth() - 2.0f) * juce::jlimit (0.0f, 1.0f, blockLoad)));
+
+    g.setColour (juce::Colours::white.withAlpha (0.8f));
+    g.drawVerticalLine ((int) (barArea.getX() + barArea.getWidth() * juce::jlimit (0.0f, 1.0f, peakBlockLoad)),
+                        barArea.getY(), barArea.getBottom());
+
+    area.removeFromLeft (6);
+
+    juce::String text;
+    text << juce::roundToInt (blockLoad * 100.0f) << "% (peak " << juce::roundToInt (peakBlockLoad * 100.0f) << "%)"
+         << "  voices " << numVoices
+         << "  grains/s " << juce::roundToInt (grainsPerSecond);
+
+    if (oversampling > 1)
+        text << "  " << oversampling << "x";
+
+    if (qualityLevel > 0)
+        text << "  quality -" << qualityLevel;
+
+    if (numOverruns > 0)
+        text << "  overruns " << numOverruns;
+
+    g.setColour (numOverruns > 0 || qualityLevel > 0 ? juce::Colours::orange : juce::Colours::white);
+    g.setFont (12.0f);
+    g.drawFittedText (text, area, juce::Justification::centredLeft, 1);
+}
+
+void LoadOverlay::mouseUp (const juce::MouseEvent&)
+{
+    if (! Tracing::isEnabled())
+        return;
+
+    chooser = std::make_unique<juce::FileChooser> ("Save the trace...",
+                                                   juce::File::getSpecialLocation (juce::File::userDesktopDirectory).getChildFile ("TapePerformer.trace.json"),
+                                                   "*.json");
+
+    auto chooserFlags = juce::FileBrowserComponent::saveMode | juce::FileBrowserComponent::warnAboutOverwriting;
+
+    chooser->launchAsync (chooserFlags, [] (const juce::FileChooser& fc)
+    {
+        auto file = fc.getResult();
+
+        if (file != juce::File() && ! Tracing::writeChromeTrace (file))
+            juce::AlertWindow::showMessageBoxAsync (juce::AlertWindow::WarningIcon, "Trace",
+                                                    "Couldn't write " + file.getFullPathName());
+    });
+}
+
+void LoadOverlay::timerCallback()
+{
+    auto& snapshot = audioProcessor.getTelemetry().getLatestSnapshot();
+
+    if (snapshot.blockLoad == blockLoad && snapshot.peakBlockLoad == peakBlockLoad && snapshot.numGrains == numVoices
+         && snapshot.grainsPerSecond == grainsPerSecond && snapshot.numOverruns == numOverruns
+         && snapshot.qualityLevel == qualityLevel && snapshot.oversampling == oversampling)
+        return;
+
+    blockLoad = snapshot.blockLoad;
+    peakBlockLoad = snapshot.peakBlockLoad;
+    grainsPerSecond = snapshot.grainsPerSecond;
+    numVoices = snapshot.numGrains;
+    numOverruns = snapshot.numOverruns;
+    qualityLevel = snapshot.qualityLevel;
+    oversampling = snapshot.oversampling;
+
+    repaint();
+}
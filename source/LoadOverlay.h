@@ -0,0 +1,45 @@
+/*
+  ==============================================================================
+
+    LoadOverlay.h
+    Created: 23 Oct 2026 4:27:10pm
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+//==============================================================================
+/*
+    A small readout on top of the wave display: how much of each block's time
+    the engine used, how many voices are playing and how many grains start
+    per second. It reads the same telemetry as the wave display.
+
+    When the trace zones are compiled in, clicking it saves the trace.
+*/
+class LoadOverlay  : public juce::Component,
+                     private juce::Timer
+{
+public:
+    LoadOverlay (TapePerformerAudioProcessor&);
+    ~LoadOverlay() override;
+
+    void paint (juce::Graphics&) override;
+    void mouseUp (const juce::MouseEvent&) override;
+
+private:
+    void timerCallback() override;
+
+    TapePerformerAudioProcessor& audioProcessor;
+
+    float blockLoad = 0, peakBlockLoad = 0, grainsPerSecond = 0;
+    int numVoices = 0, numOverruns = 0, qualityLevel = 0, oversampling = 1;
+
+    std::unique_ptr<juce::FileChooser> chooser;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LoadOverlay)
+};
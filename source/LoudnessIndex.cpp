@@ -0,0 +1,88 @@
+/*
+  ==============================================================================
+
+    LoudnessIndex.cpp
+    Created: 26 Oct 2026 9:41:07am
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#include "LoudnessIndex.h"
+#include "ParallelUnits.h"
+
+namespace
+{
+    constexpr int windowsPerUnit = 256;
+}
+
+void LoudnessIndex::build (const juce::AudioBuffer<float>& data, int length, juce::ThreadPool* pool)
+{
+    gains.clear();
+
+    length = juce::jmin (length, data.getNumSamples());
+    if (length <= 0 || data.getNumChannels() <= 0)
+        return;
+
+    auto numWindows = (length + samplesPerWindow - 1) / samplesPerWindow;
+    std::vector<float> meanSquares ((size_t) numWindows);
+
+    // the windows are cut into units of work that any thread can pick up
+    runInParallel ((numWindows + windowsPerUnit - 1) / windowsPerUnit, pool, [&] (int unit)
+    {
+        auto firstWindow = unit * windowsPerUnit;
+        auto endWindow = juce::jmin (firstWindow + windowsPerUnit, numWindows);
+        auto numChannels = data.getNumChannels();
+
+        for (auto i = firstWindow; i < endWindow; ++i)
+        {
+            auto start = i * samplesPerWindow;
+            auto num = juce::jmin (samplesPerWindow, length - start);
+            auto sum = 0.0f;
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                sum += getMeanSquare (data.getReadPointer (channel, start), num);
+
+            meanSquares[(size_t) i] = sum / (float) numChannels;
+        }
+    });
+
+    // a grain plays forward from where it starts, so each window's level takes in the ones after it - wrapping
+    // around the end like the grains do
+    const auto span = juce::jmin (windowsPerGrain, numWindows);
+    const auto minGain = juce::Decibels::decibelsToGain (-maxCutDecibels);
+    const auto maxGain = juce::Decibels::decibelsToGain (maxBoostDecibels);
+
+    auto sum = 0.0;
+    for (int i = 0; i < span; ++i)
+        sum += meanSquares[(size_t) i];
+
+    gains.resize ((size_t) numWindows);
+
+    for (int i = 0; i < numWindows; ++i)
+    {
+        auto level = (float) std::sqrt (juce::jmax (0.0, sum / span));
+        gains[(size_t) i] = level > 0.0f ? juce::jlimit (minGain, maxGain, targetLevel / level) : maxGain;
+
+        sum += meanSquares[(size_t) ((i + span) % numWindows)] - meanSquares[(size_t) i];
+    }
+}
+
+float LoudnessIndex::getMeanSquare (const float* samples, int num) noexcept
+{
+    if (num <= 0)
+        return 0.0f;
+
+    // four separate sums, so the compiler is free to vectorise this
+    float sums[4] = {};
+    int i = 0;
+
+    for (; i + 4 <= num; i += 4)
+        for (int j = 0; j < 4; ++j)
+            sums[j] += samples[i + j] * samples[i + j];
+
+    for (; i < num; ++i)
+        sums[0] += samples[i] * samples[i];
+
+    return (sums[0] + sums[1] + sums[2] + sums[3]) / (float) num;
+}
@@ -0,0 +1,62 @@
+/*
+  ==============================================================================
+
+    LoudnessIndex.h
+    Created: 26 Oct 2026 9:41:07am
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+//==============================================================================
+/**
+    The gain that brings a grain starting anywhere on a tape to the same level,
+    so the quiet and loud parts of a long tape come out alike.
+
+    build() measures the RMS of every window of the tape once, when the tape
+    is loaded - the windows are spread over a thread pool like PeakPyramid's
+    peaks. Each window's gain is worked out from the level of the few windows
+    that follow it, which is what a grain starting there plays. A grain then
+    only looks its gain up when it starts.
+
+    The gain is limited either way, so near-silence doesn't get dragged all
+    the way up to the common level.
+*/
+class LoudnessIndex
+{
+public:
+    LoudnessIndex() {}
+
+    /** Measures length samples of data. Has to happen before the voices can see the index. */
+    void build (const juce::AudioBuffer<float>& data, int length, juce::ThreadPool* pool);
+
+    bool isEmpty() const noexcept   { return gains.empty(); }
+
+    /** The gain for a grain starting at phase, a fraction of the tape - 1 if nothing was built. */
+    float getGain (double phase) const noexcept
+    {
+        if (gains.empty())
+            return 1.0f;
+
+        auto window = (int) (phase * (double) gains.size());
+        return gains[(size_t) juce::jlimit (0, (int) gains.size() - 1, window)];
+    }
+
+    static constexpr int samplesPerWindow = 1024;
+    static constexpr int windowsPerGrain = 4;
+
+    static constexpr float targetLevel = 0.125f;        // about -18 dBFS RMS
+    static constexpr float maxBoostDecibels = 12.0f;
+    static constexpr float maxCutDecibels = 24.0f;
+
+private:
+    static float getMeanSquare (const float* samples, int num) noexcept;
+
+    std::vector<float> gains;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LoudnessIndex)
+};
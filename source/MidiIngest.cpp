@@ -0,0 +1,168 @@
+/*
+  ==============================================================================
+
+    MidiIngest.cpp
+    Created: 24 Oct 2026 2:18:52pm
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#include "MidiIngest.h"
+
+MidiIngest::MidiIngest()
+{
+    prepare();
+}
+
+void MidiIngest::prepare (int maxEventsPerBlock)
+{
+    capacity = juce::jmax (16, maxEventsPerBlock);
+
+    events.clear();
+    events.reserve ((size_t) capacity);
+
+    controls.clear();
+    controls.reserve ((size_t) numControlKeys);
+
+    controlSlots.assign ((size_t) numControlKeys, -1);
+}
+
+void MidiIngest::process (const juce::MidiBuffer& midi, int numSamples)
+{
+    events.clear();
+    numDropped = 0;
+
+    // only the slots used last block need resetting
+    for (auto& control : controls)
+        controlSlots[(size_t) ((((int) control.type * 16) + control.channel - 1) * 128 + control.number)] = -1;
+
+    controls.clear();
+
+    const auto lastSample = juce::jmax (0, numSamples - 1);
+
+    for (const auto metadata : midi)
+    {
+        const auto message = metadata.getMessage();
+        const auto offset = juce::jlimit (0, lastSample, metadata.samplePosition);
+        const auto channel = message.getChannel();
+
+        if (channel < 1 || channel > 16)
+            continue;
+
+        if (message.isNoteOn())
+        {
+            // keep room for the note-offs, a stuck note is worse than a missing one
+            if ((int) events.size() >= capacity - capacity / 4)
+            {
+                ++numDropped;
+                continue;
+            }
+
+            addEvent ({ Event::Type::noteOn, offset, channel, message.getNoteNumber(), 0, message.getFloatVelocity() });
+        }
+        else if (message.isNoteOff())
+        {
+            addEvent ({ Event::Type::noteOff, offset, channel, message.getNoteNumber(), 0, message.getFloatVelocity() });
+        }
+        else if (message.isController())
+        {
+            if (mustStayInOrder (message.getControllerNumber()))
+                addEvent ({ Event::Type::controller, offset, channel, message.getControllerNumber(), message.getControllerValue(), 0.0f });
+            else
+                addControl ({ Control::Type::controller, channel, message.getControllerNumber(), message.getControllerValue() });
+        }
+        else if (message.isPitchWheel())
+        {
+            addControl ({ Control::Type::pitchWheel, channel, 0, message.getPitchWheelValue() });
+        }
+        else if (message.isChannelPressure())
+        {
+            addControl ({ Control::Type::channelPressure, channel, 0, message.getChannelPressureValue() });
+        }
+        else if (message.isAftertouch())
+        {
+            addControl ({ Control::Type::aftertouch, channel, message.getNoteNumber(), message.getAfterTouchValue() });
+        }
+    }
+
+    sortEvents();
+    removeEmptyNotes();
+}
+
+void MidiIngest::addEvent (const Event& event)
+{
+    if ((int) events.size() >= capacity)
+    {
+        ++numDropped;
+        return;
+    }
+
+    events.push_back (event);
+}
+
+void MidiIngest::addControl (const Control& control)
+{
+    auto& slot = controlSlots[(size_t) ((((int) control.type * 16) + control.channel - 1) * 128 + control.number)];
+
+    if (slot < 0)
+    {
+        slot = (int) controls.size();
+        controls.push_back (control);
+    }
+    else
+    {
+        controls[(size_t) slot].value = control.value;
+    }
+}
+
+void MidiIngest::sortEvents()
+{
+    // a MidiBuffer is sorted already, so this hardly ever moves anything - an insertion sort
+    // is linear then, keeps events at the same sample in order, and never allocates
+    for (size_t i = 1; i < events.size(); ++i)
+    {
+        auto event = events[i];
+        auto j = i;
+
+        for (; j > 0 && events[j - 1].sampleOffset > event.sampleOffset; --j)
+            events[j] = events[j - 1];
+
+        events[j] = event;
+    }
+}
+
+void MidiIngest::removeEmptyNotes()
+{
+    // a note that's switched off at the sample it started on would never be heard, so its note-on goes. The
+    // note-off stays - it still ends the same key if an earlier note-on left it sounding
+    auto isEmptyNote = [this] (size_t noteOnIndex)
+    {
+        auto& noteOn = events[noteOnIndex];
+
+        for (auto i = noteOnIndex + 1; i < events.size() && events[i].sampleOffset == noteOn.sampleOffset; ++i)
+        {
+            auto& event = events[i];
+
+            if (event.channel == noteOn.channel && event.number == noteOn.number && event.type != Event::Type::controller)
+                return event.type == Event::Type::noteOff;
+        }
+
+        return false;
+    };
+
+    size_t numKept = 0;
+
+    for (size_t i = 0; i < events.size(); ++i)
+        if (events[i].type != Event::Type::noteOn || ! isEmptyNote (i))
+            events[numKept++] = events[i];
+
+    events.resize (numKept);
+}
+
+bool MidiIngest::mustStayInOrder (int controllerNumber) noexcept
+{
+    return controllerNumber == 0x40         // sustain
+        || controllerNumber == 0x42         // sostenuto
+        || controllerNumber >= 120;         // all sound off, all notes off and the other mode messages
+}
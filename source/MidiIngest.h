@@ -0,0 +1,89 @@
+/*
+  ==============================================================================
+
+    MidiIngest.h
+    Created: 24 Oct 2026 2:18:52pm
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+//==============================================================================
+/**
+    Turns a block's MIDI into what GrainSynthesiser::renderBlock() needs, so
+    the synth never has to split the block at an event.
+
+    Notes, the pedals and the channel mode messages keep their order and their
+    sample offset - the voices start and release at that sample themselves.
+    Every other controller, pitch bend and pressure only keeps its last value
+    in the block, since the voices only read those once per block anyway.
+
+    Everything lives in storage that prepare() allocates, so process() never
+    allocates. A block with more events than that drops note-ons first, to
+    keep room for the note-offs.
+*/
+class MidiIngest
+{
+public:
+    /** A note or a controller that has to stay in order with the notes. */
+    struct Event
+    {
+        enum class Type { noteOn, noteOff, controller };
+
+        Type type;
+        int sampleOffset;
+        int channel;
+        int number;         // the note or the controller
+        int value;          // the controller's value
+        float velocity;
+    };
+
+    /** The last value of a controller, pitch bend or pressure in the block. */
+    struct Control
+    {
+        enum class Type { controller, pitchWheel, channelPressure, aftertouch };
+
+        Type type;
+        int channel;
+        int number;         // the controller or the aftertouch's note, 0 otherwise
+        int value;
+    };
+
+    MidiIngest();
+
+    void prepare (int maxEventsPerBlock = defaultMaxEventsPerBlock);
+
+    /** Sorts and coalesces the block's events - the offsets end up within 0 and numSamples - 1. */
+    void process (const juce::MidiBuffer& midi, int numSamples);
+
+    const std::vector<Event>& getEvents() const noexcept        { return events; }
+    const std::vector<Control>& getControls() const noexcept    { return controls; }
+
+    int getNumDroppedEvents() const noexcept                    { return numDropped; }
+
+    static constexpr int defaultMaxEventsPerBlock = 4096;
+
+private:
+    void addEvent (const Event& event);
+    void addControl (const Control& control);
+    void sortEvents();
+    void removeEmptyNotes();
+
+    /** Controllers that change how the notes around them are released. */
+    static bool mustStayInOrder (int controllerNumber) noexcept;
+
+    std::vector<Event> events;
+    std::vector<Control> controls;
+    int capacity = 0;
+    int numDropped = 0;
+
+    // where each control went in controls, -1 if it hasn't been seen this block
+    static constexpr int numControlKeys = 4 * 16 * 128;
+    std::vector<int> controlSlots;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MidiIngest)
+};
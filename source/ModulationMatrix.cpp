@@ -0,0 +1,187 @@
+/*
+  ==============================================================================
+
+    ModulationMatrix.cpp
+    Created: 25 Oct 2026 10:12:44am
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#include "ModulationMatrix.h"
+
+juce::StringArray ModulationMatrix::getSourceNames()
+{
+    return { "None", "LFO 1", "LFO 2", "LFO 3", "Random", "Sample & Hold", "Follower", "Velocity", "Key" };
+}
+
+juce::StringArray ModulationMatrix::getDestinationNames()
+{
+    return { "None", "Position", "Duration", "Spread", "Env-Shape", "Flux Range", "Tape Slot", "Gain", "Stretch Speed" };
+}
+
+juce::StringArray ModulationMatrix::getShapeNames()
+{
+    return { "Sine", "Triangle", "Saw", "Square" };
+}
+
+ModulationMatrix::ModulationMatrix()
+{
+    reset();
+}
+
+void ModulationMatrix::prepare (double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    reset();
+}
+
+void ModulationMatrix::reset()
+{
+    lfoPhases.fill (0.0);
+
+    randomPhase = 0.0;
+    previousRandom = 0.0f;
+    nextRandom = randomGenerator.nextFloat() * 2.0f - 1.0f;
+
+    followerLevel = inputPeak = 0.0f;
+
+    sourceValues.fill (0.0f);
+    offsets.fill (0.0f);
+}
+
+void ModulationMatrix::setRandomSeed (juce::int64 seed)
+{
+    randomGenerator.setSeed (seed);
+    reset();
+}
+
+void ModulationMatrix::measureInput (const juce::AudioBuffer<float>& input, int numSamples)
+{
+    numSamples = juce::jmin (numSamples, input.getNumSamples());
+
+    if (numSamples <= 0)
+        return;
+
+    // the follower only needs the block's peak, which the vector min/max finds in one pass per channel
+    for (int channel = 0; channel < input.getNumChannels(); ++channel)
+    {
+        auto range = juce::FloatVectorOperations::findMinAndMax (input.getReadPointer (channel), numSamples);
+        inputPeak = juce::jmax (inputPeak, -range.getStart(), range.getEnd());
+    }
+}
+
+void ModulationMatrix::process (GrainParameters& params, int numSamples)
+{
+    advanceSources (params, numSamples);
+
+    offsets.fill (0.0f);
+    velocityModulation = {};
+    keyModulation = {};
+
+    for (auto& route : params.modulationRoutes)
+    {
+        if (route.amount == 0.0f
+             || ! juce::isPositiveAndBelow (route.source, (int) numSources) || route.source == none
+             || ! juce::isPositiveAndBelow (route.destination, (int) numDestinations) || route.destination == noDestination)
+            continue;
+
+        if (route.source == velocity || route.source == key)
+        {
+            auto& noteModulation = route.source == velocity ? velocityModulation : keyModulation;
+
+            switch (route.destination)
+            {
+                case position:  noteModulation.position += route.amount; break;
+                case duration:  noteModulation.duration += route.amount; break;
+                case spread:    noteModulation.spread += route.amount; break;
+                default:        break;      // the rest are shared by all the notes
+            }
+
+            continue;
+        }
+
+        offsets[(size_t) route.destination] += route.amount * sourceValues[(size_t) route.source];
+    }
+
+    applyOffsets (params);
+}
+
+void ModulationMatrix::advanceSources (const GrainParameters& params, int numSamples)
+{
+    const auto blockSeconds = numSamples / sampleRate;
+
+    // the LFOs are read at the start of the block, so a reset one starts exactly at its beginning
+    for (int i = 0; i < GrainParameters::numLfos; ++i)
+    {
+        auto& phase = lfoPhases[(size_t) i];
+
+        sourceValues[(size_t) (lfo1 + i)] = getShapeValue (params.lfoShapes[(size_t) i], phase);
+
+        phase += juce::jmax (0.0f, params.lfoRates[(size_t) i]) * blockSeconds;
+        phase -= std::floor (phase);
+    }
+
+    // both random sources share one clock - sample and hold jumps to the value the smooth line has just reached
+    randomPhase += juce::jmax (0.0f, params.randomRate) * blockSeconds;
+
+    if (randomPhase >= 1.0)
+    {
+        randomPhase -= std::floor (randomPhase);
+        previousRandom = nextRandom;
+        nextRandom = randomGenerator.nextFloat() * 2.0f - 1.0f;
+    }
+
+    sourceValues[random] = previousRandom + (nextRandom - previousRandom) * (float) randomPhase;
+    sourceValues[sampleAndHold] = previousRandom;
+
+    // a peak follower that rises faster than it falls, so grains react to every hit on the sidechain
+    auto time = inputPeak > followerLevel ? followerAttackSeconds : followerReleaseSeconds;
+    auto coefficient = (float) std::exp (-blockSeconds / time);
+
+    followerLevel = inputPeak + (followerLevel - inputPeak) * coefficient;
+    sourceValues[follower] = juce::jlimit (0.0f, 1.0f, followerLevel);
+    inputPeak = 0.0f;
+}
+
+void ModulationMatrix::applyOffsets (GrainParameters& params) const
+{
+    // a destination nothing is routed to keeps its exact value
+    auto apply = [this] (Destination destination, float& value, float maximum)
+    {
+        if (offsets[(size_t) destination] != 0.0f)
+            value = juce::jlimit (0.0f, maximum, value + offsets[(size_t) destination] * maximum);
+    };
+
+    // the position wraps around the tape, like the grains' start positions do
+    if (offsets[position] != 0.0f)
+    {
+        params.position += offsets[position];
+        params.position -= std::floor (params.position);
+    }
+
+    if (offsets[duration] != 0.0f)
+        params.duration = juce::jlimit (0.0, 1.0, params.duration + offsets[duration]);
+
+    apply (spread, params.spread, 1.0f);
+    apply (envelopeShape, params.envelopeShape, 1.0f);
+    apply (fluxRange, params.fluxModeRange, 1.0f);
+    apply (tapeSlot, params.tapeSlot, (float) (GrainSound::numTapeSlots - 1));
+    apply (gain, params.gain, 1.0f);
+
+    // the only destination that goes below 0, so an amount of 1 sweeps it from standing still to full speed
+    if (offsets[stretchSpeed] != 0.0f)
+        params.stretchSpeed = juce::jlimit (-GrainParameters::maxStretchSpeed, GrainParameters::maxStretchSpeed,
+                                            params.stretchSpeed + offsets[stretchSpeed] * GrainParameters::maxStretchSpeed);
+}
+
+float ModulationMatrix::getShapeValue (int shape, double phase) noexcept
+{
+    switch (shape)
+    {
+        case triangle:  return 1.0f - 4.0f * std::abs ((float) phase - 0.5f);
+        case saw:       return 2.0f * (float) phase - 1.0f;
+        case square:    return phase < 0.5 ? 1.0f : -1.0f;
+        default:        return (float) std::sin (juce::MathConstants<double>::twoPi * phase);
+    }
+}
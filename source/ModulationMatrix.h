@@ -0,0 +1,116 @@
+/*
+  ==============================================================================
+
+    ModulationMatrix.h
+    Created: 25 Oct 2026 10:12:44am
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "Grain.h"
+#include "GrainParameters.h"
+
+//==============================================================================
+/**
+    Moves the grain parameters from inside the engine, so position, spread,
+    duration and the rest can wander without the host automating them.
+
+    The sources run at block rate - the voices only read the parameters when a
+    grain starts, so anything faster would never be heard. Each route adds its
+    source times its amount to one destination, an amount of 1 sweeps the
+    destination's whole range.
+
+    Velocity and key are different: they're fixed for each note, so their
+    routes go to the sounds as NoteModulation and every voice works out its
+    own offsets when its note starts. Only position, duration and spread can be
+    moved per note.
+
+    Everything is called on the audio thread, nothing allocates.
+*/
+class ModulationMatrix
+{
+public:
+    enum Source
+    {
+        none = 0,
+        lfo1,
+        lfo2,
+        lfo3,
+        random,                 // a smooth random line, -1 - 1
+        sampleAndHold,          // a new random step at the random rate, -1 - 1
+        follower,               // the sidechain's level, 0 - 1
+        velocity,               // 0 - 1, per note
+        key,                    // -1 - 1 around the sound's root note, per note
+        numSources
+    };
+
+    enum Destination
+    {
+        noDestination = 0,
+        position,
+        duration,
+        spread,
+        envelopeShape,
+        fluxRange,
+        tapeSlot,
+        gain,
+        stretchSpeed,
+        numDestinations
+    };
+
+    enum Shape { sine = 0, triangle, saw, square, numShapes };
+
+    /** The names the plugin's choice parameters show, in the order of the enums. */
+    static juce::StringArray getSourceNames();
+    static juce::StringArray getDestinationNames();
+    static juce::StringArray getShapeNames();
+
+    ModulationMatrix();
+
+    void prepare (double sampleRate);
+
+    /** Starts every LFO from the beginning and the random sources from the seed. */
+    void reset();
+    void setRandomSeed (juce::int64 seed);
+
+    /** Measures the sidechain for the follower - call it before the input gets overwritten. */
+    void measureInput (const juce::AudioBuffer<float>& input, int numSamples);
+
+    /** Advances the sources by one block and adds their routes to params. */
+    void process (GrainParameters& params, int numSamples);
+
+    /** The velocity and key routes from the last process(), for GrainSound::setNoteModulation(). */
+    const NoteModulation& getVelocityModulation() const noexcept    { return velocityModulation; }
+    const NoteModulation& getKeyModulation() const noexcept         { return keyModulation; }
+
+    static constexpr float followerAttackSeconds = 0.01f;
+    static constexpr float followerReleaseSeconds = 0.25f;
+
+private:
+    void advanceSources (const GrainParameters& params, int numSamples);
+    void applyOffsets (GrainParameters& params) const;
+
+    static float getShapeValue (int shape, double phase) noexcept;
+
+    double sampleRate = 44100.0;
+
+    std::array<double, GrainParameters::numLfos> lfoPhases {};
+
+    juce::Random randomGenerator;
+    double randomPhase = 0;
+    float previousRandom = 0, nextRandom = 0;
+
+    float followerLevel = 0, inputPeak = 0;
+
+    // the value of every source this block, and every destination's offset - the per-note sources stay 0 here
+    std::array<float, numSources> sourceValues {};
+    std::array<float, numDestinations> offsets {};
+
+    NoteModulation velocityModulation, keyModulation;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ModulationMatrix)
+};
@@ -0,0 +1,157 @@
+/*
+  ==============================================================================
+
+    OutputRecorder.cpp
+    Created: 19 Oct 2026 5:03:52pm
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#include "OutputRecorder.h"
+
+OutputRecorder::OutputRecorder() : juce::Thread ("Output Recorder")
+{
+}
+
+OutputRecorder::~OutputRecorder()
+{
+    release();
+}
+
+void OutputRecorder::prepare (double newSampleRate, int numChannels, double maxLengthInSeconds)
+{
+    release();
+
+    sampleRate = newSampleRate;
+
+    auto fifoSize = (int) (fifoLengthSeconds * sampleRate);
+    fifo.setTotalSize (fifoSize);
+    fifoBuffer.setSize (numChannels, fifoSize);
+
+    takeBuffer.setSize (numChannels, (int) (maxLengthInSeconds * sampleRate));
+    takeLength = 0;
+
+    finishRequested = false;
+    numDroppedSamples = 0;
+    numSamplesWritten = takeEnd = numSamplesRead = 0;
+
+    startThread();
+}
+
+void OutputRecorder::release()
+{
+    stopThread (1000);
+    fifo.reset();
+}
+
+void OutputRecorder::push (const juce::AudioBuffer<float>& source, int numSamples) noexcept
+{
+    if (! isThreadRunning())
+        return;
+
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite (numSamples, start1, size1, start2, size2);
+
+    for (int channel = 0; channel < fifoBuffer.getNumChannels(); ++channel)
+    {
+        auto sourceChannel = juce::jmin (channel, source.getNumChannels() - 1);
+
+        if (size1 > 0)
+            fifoBuffer.copyFrom (channel, start1, source, sourceChannel, 0, size1);
+
+        if (size2 > 0)
+            fifoBuffer.copyFrom (channel, start2, source, sourceChannel, size1, size2);
+    }
+
+    fifo.finishedWrite (size1 + size2);
+    numSamplesWritten += size1 + size2;
+
+    if (size1 + size2 < numSamples)
+        numDroppedSamples += numSamples - (size1 + size2);
+}
+
+void OutputRecorder::finishTake() noexcept
+{
+    // no notify() here, that would take a lock - the thread picks the request up on its next round
+    takeEnd = numSamplesWritten.load();
+    finishRequested = true;
+}
+
+GrainTape::Ptr OutputRecorder::getFinishedTake()
+{
+    const juce::ScopedLock sl (takeLock);
+
+    takeIsReady = false;
+    return std::move (finishedTake);
+}
+
+void OutputRecorder::run()
+{
+    while (! threadShouldExit())
+    {
+        // what's ready is read before the request - if there's no request yet, all of it is from the current take
+        auto numReady = (juce::int64) fifo.getNumReady();
+
+        if (finishRequested.exchange (false))
+        {
+            // only up to where the take was finished, the rest already belongs to the next one
+            drainFifo (takeEnd.load() - numSamplesRead);
+            commitTake();
+        }
+        else
+        {
+            drainFifo (numReady);
+        }
+
+        wait (10);
+    }
+}
+
+void OutputRecorder::drainFifo (juce::int64 maxSamples)
+{
+    auto numToRead = (int) juce::jlimit ((juce::int64) 0, (juce::int64) fifo.getNumReady(), maxSamples);
+
+    int start1, size1, start2, size2;
+    fifo.prepareToRead (numToRead, start1, size1, start2, size2);
+
+    auto spaceLeft = takeBuffer.getNumSamples() - takeLength;
+    auto toCopy1 = juce::jmin (size1, spaceLeft);
+    auto toCopy2 = juce::jmin (size2, spaceLeft - toCopy1);
+
+    for (int channel = 0; channel < takeBuffer.getNumChannels(); ++channel)
+    {
+        if (toCopy1 > 0)
+            takeBuffer.copyFrom (channel, takeLength, fifoBuffer, channel, start1, toCopy1);
+
+        if (toCopy2 > 0)
+            takeBuffer.copyFrom (channel, takeLength + toCopy1, fifoBuffer, channel, start2, toCopy2);
+    }
+
+    takeLength += toCopy1 + toCopy2;
+    fifo.finishedRead (size1 + size2);
+    numSamplesRead += size1 + size2;
+}
+
+void OutputRecorder::commitTake()
+{
+    if (takeLength == 0)
+        return;
+
+    // same padding the file tapes get, so the interpolation never reads past the end
+    auto data = std::make_unique<juce::AudioBuffer<float>> (takeBuffer.getNumChannels(), takeLength + GrainTape::padding);
+    data->clear();
+
+    for (int channel = 0; channel < takeBuffer.getNumChannels(); ++channel)
+        data->copyFrom (channel, 0, takeBuffer, channel, 0, takeLength);
+
+    GrainTape::Ptr tape = new GrainTape ("Resampled", std::move (data), takeLength, sampleRate);
+    takeLength = 0;
+
+    // on this thread, so the message thread only has to swap the take in
+    tape->analyse (nullptr);
+
+    const juce::ScopedLock sl (takeLock);
+    finishedTake = tape;
+    takeIsReady = true;
+}
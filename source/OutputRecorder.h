@@ -0,0 +1,77 @@
+/*
+  ==============================================================================
+
+    OutputRecorder.h
+    Created: 19 Oct 2026 5:03:52pm
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "GrainTape.h"
+
+//==============================================================================
+/**
+    Records the instrument's own output so it can be played back as a new tape.
+
+    The audio thread only pushes into a lock-free fifo and never waits - if the
+    background thread falls behind the newest samples get dropped. The background
+    thread moves the audio into the take buffer, which is allocated in prepare(),
+    and when a take is finished it copies it into a new GrainTape and analyses
+    it. That tape waits until the message thread picks it up with getFinishedTake().
+*/
+class OutputRecorder : private juce::Thread
+{
+public:
+    OutputRecorder();
+    ~OutputRecorder() override;
+
+    void prepare (double sampleRate, int numChannels, double maxLengthInSeconds);
+    void release();
+
+    /** Called from the audio thread while recording. */
+    void push (const juce::AudioBuffer<float>& source, int numSamples) noexcept;
+
+    /** Called from the audio thread when recording stops - the take gets turned into a tape in the background. */
+    void finishTake() noexcept;
+
+    bool hasFinishedTake() const noexcept         { return takeIsReady.load(); }
+
+    /** Hands the finished take over to the message thread, or nullptr if there is none. */
+    GrainTape::Ptr getFinishedTake();
+
+    int getNumDroppedSamples() const noexcept     { return numDroppedSamples.load(); }
+
+    static constexpr double fifoLengthSeconds = 1.0;
+
+private:
+    void run() override;
+    /** Moves at most maxSamples from the fifo into the take. */
+    void drainFifo (juce::int64 maxSamples);
+    void commitTake();
+
+    juce::AbstractFifo fifo { 1 };
+    juce::AudioBuffer<float> fifoBuffer;
+
+    juce::AudioBuffer<float> takeBuffer;
+    int takeLength = 0;
+    double sampleRate = 0;
+
+    // every sample that went into the fifo and came out of it, so a finished take ends at exactly
+    // the sample it was finished at - even when the next one has started pushing already
+    std::atomic<juce::int64> numSamplesWritten { 0 };
+    std::atomic<juce::int64> takeEnd { 0 };
+    juce::int64 numSamplesRead = 0;
+
+    std::atomic<bool> finishRequested { false };
+    std::atomic<bool> takeIsReady { false };
+    std::atomic<int> numDroppedSamples { 0 };
+
+    juce::CriticalSection takeLock;
+    GrainTape::Ptr finishedTake;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OutputRecorder)
+};
@@ -0,0 +1,435 @@
+/*
+  ==============================================================================
+
+    Oversampler.cpp
+    Created: 25 Oct 2026 3:05:19pm
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#include "Oversampler.h"
+
+HalfBandDecimator::HalfBandDecimator (int extraDelayToUse)
+    : extraDelay (extraDelayToUse)
+{
+    // a windowed sinc at half the input's Nyquist - only the odd taps around the centre are left
+    const auto lastTap = numSideTaps - 1;
+    auto sum = 0.0;
+
+    for (int i = 0; i < numSideTaps; ++i)
+    {
+        auto k = 2 * i - lastTap;
+        auto x = juce::MathConstants<double>::pi * k;
+        auto window = 0.42 + 0.5 * std::cos (x / (lastTap + 1)) + 0.08 * std::cos (2.0 * x / (lastTap + 1));
+        auto tap = std::sin (x / 2.0) / x * window;
+
+        coefficients[(size_t) i] = (float) tap;
+        sum += tap;
+    }
+
+    // together with the centre tap of 0.5, a constant signal comes out as it went in
+    for (auto& coefficient : coefficients)
+        coefficient = (float) (coefficient * 0.5 / sum);
+}
+
+void HalfBandDecimator::prepare (int numChannels, int maxInputSamples)
+{
+    const auto maxOutputSamples = maxInputSamples / 2 + 1;
+
+    centreBranches.assign ((size_t) numChannels, std::vector<float> ((size_t) (getLatency() + maxOutputSamples), 0.0f));
+    sideBranches.assign ((size_t) numChannels, std::vector<float> ((size_t) (numSideTaps - 1 + extraDelay + maxOutputSamples), 0.0f));
+}
+
+void HalfBandDecimator::reset()
+{
+    for (auto& branch : centreBranches)
+        std::fill (branch.begin(), branch.end(), 0.0f);
+
+    for (auto& branch : sideBranches)
+        std::fill (branch.begin(), branch.end(), 0.0f);
+}
+
+void HalfBandDecimator::process (int channel, const float* input, float* output, int numInput) noexcept
+{
+    const auto numOutput = numInput / 2;
+    const auto centreHistory = getLatency();
+    const auto sideHistory = numSideTaps - 1 + extraDelay;
+
+    auto& centreBranch = centreBranches[(size_t) channel];
+    auto& sideBranch = sideBranches[(size_t) channel];
+    jassert ((int) sideBranch.size() >= sideHistory + numOutput);
+
+    auto* centre = centreBranch.data();
+    auto* side = sideBranch.data();
+
+    for (int i = 0; i < numOutput; ++i)
+    {
+        centre[centreHistory + i] = input[2 * i];
+        side[sideHistory + i] = input[2 * i + 1];
+    }
+
+    // the centre branch is only the centre tap, which lands getLatency() output samples later
+    juce::FloatVectorOperations::copyWithMultiply (output, centre, 0.5f, numOutput);
+
+    // every side tap adds the whole side branch, shifted by that tap - the newest extraDelay samples wait for the next block
+    for (int i = 0; i < numSideTaps; ++i)
+        juce::FloatVectorOperations::addWithMultiply (output, side + numSideTaps - 1 - i, coefficients[(size_t) i], numOutput);
+
+    // the newest samples go to the front for the next block
+    std::memmove (centre, centre + numOutput, sizeof (float) * (size_t) centreHistory);
+    std::memmove (side, side + numOutput, sizeof (float) * (size_t) sideHistory);
+}
+
+void HalfBandDecimator::setHistory (int channel, const float* input, int numInput) noexcept
+{
+    jassert (numInput % 2 == 0 && numInput >= getHistoryLength());
+
+    const auto centreHistory = getLatency();
+    const auto sideHistory = numSideTaps - 1 + extraDelay;
+
+    auto* centre = centreBranches[(size_t) channel].data();
+    auto* side = sideBranches[(size_t) channel].data();
+
+    // the oldest sample first, the way process() leaves them
+    for (int i = 0; i < centreHistory; ++i)
+        centre[i] = input[numInput - 2 * (centreHistory - i)];
+
+    for (int i = 0; i < sideHistory; ++i)
+        side[i] = input[numInput - 2 * (sideHistory - i) + 1];
+}
+
+//==============================================================================
+void Oversampler::prepare (int numChannels, int maxBlockSize)
+{
+    // getBuffer() shrinks buffer to each block, so what it can hold is kept here
+    preparedChannels = numChannels;
+    preparedBlockSize = maxBlockSize;
+
+    buffer.setSize (numChannels, maxBlockSize * maxFactor);
+    resampledBuffer.setSize (numChannels, maxBlockSize * maxFactor);
+    halfRateBuffer.setSize (numChannels, maxBlockSize * maxFactor / 2);
+    delayedBuffer.setSize (numChannels, maxBlockSize * maxFactor / 2);
+    crossfadeBuffer.setSize (numChannels, maxBlockSize);
+
+    twoTimesStage.prepare (numChannels, maxBlockSize * 2);
+    fourTimesFirstStage.prepare (numChannels, maxBlockSize * 4);
+    fourTimesSecondStage.prepare (numChannels, maxBlockSize * 2);
+
+    outputRateHistory.setSize (numChannels, historyLength);
+    twoTimesHistory.setSize (numChannels, historyLength);
+    reset();
+}
+
+void Oversampler::reset()
+{
+    twoTimesStage.reset();
+    fourTimesFirstStage.reset();
+    fourTimesSecondStage.reset();
+
+    outputRateHistory.clear();
+    twoTimesHistory.clear();
+    outputRatePosition = 0;
+    twoTimesPosition = 0;
+    isTwoTimesHistoryCurrent = false;
+
+    currentPath = 0;
+    previousPath = 0;
+    crossfadePosition = 0;
+}
+
+bool Oversampler::canProcess (int factor, int numChannels, int numSamples) const noexcept
+{
+    return factor == 1
+        || (numChannels <= preparedChannels && numSamples <= preparedBlockSize);
+}
+
+juce::AudioBuffer<float>& Oversampler::getBuffer (int factor, int numChannels, int numSamples)
+{
+    jassert (canProcess (factor, numChannels, numSamples));
+
+    // smaller than what prepare() allocated, so this never allocates
+    buffer.setSize (numChannels, numSamples * factor, false, false, true);
+    buffer.clear();
+    return buffer;
+}
+
+void Oversampler::process (juce::AudioBuffer<float>& output, int factor, int numSamples)
+{
+    if (numSamples <= 0)
+        return;
+
+    const auto numChannels = juce::jmin (output.getNumChannels(), preparedChannels);
+    const auto& rendered = factor == 1 ? output : buffer;
+
+    if (factor != currentPath)
+    {
+        // a path that's still fading out has kept its filters going
+        if (factor != previousPath)
+            startPath (factor, rendered, numChannels);
+
+        // a faster path only fades in once its filters hold nothing but its own render - a slower one is right
+        // straight away, and the old path fades out before its centre tap gets to the render drawn up to its rate
+        const bool isFaster = factor > currentPath;
+        crossfadeDelay = isFaster ? getWarmUpSamples (factor) : 0;
+        crossfadeLength = isFaster ? crossfadeSamples : latencySamples - 1;
+
+        previousPath = currentPath;
+        currentPath = factor;
+        crossfadePosition = 0;
+    }
+
+    // a block too big for the old path's buffers cuts the crossfade short
+    if (previousPath != 0 && numSamples > preparedBlockSize)
+        previousPath = 0;
+
+    // the old path goes first, while output may still hold the render
+    if (previousPath > 1)
+        processPath (previousPath, factor, rendered, crossfadeBuffer, numChannels, numSamples);
+
+    auto* outputRatePath = currentPath == 1 ? &output : previousPath == 1 ? &crossfadeBuffer : nullptr;
+    pushOutputRateHistory (rendered, factor, outputRatePath, numChannels, numSamples);
+
+    if (currentPath > 1)
+        processPath (currentPath, factor, rendered, output, numChannels, numSamples);
+
+    // the 2x history keeps following a 2x or 4x render even when the 2x path isn't running
+    if (currentPath != 2 && previousPath != 2)
+    {
+        isTwoTimesHistoryCurrent = factor > 1;
+
+        for (int channel = 0; channel < numChannels && factor > 1; ++channel)
+        {
+            const auto* twoTimes = rendered.getReadPointer (channel);
+
+            if (factor == 4)
+            {
+                auto* resampled = resampledBuffer.getWritePointer (channel);
+
+                for (int i = 0; i < numSamples * 2; ++i)
+                    resampled[i] = twoTimes[2 * i];
+
+                twoTimes = resampled;
+            }
+
+            pushTwoTimesHistory (channel, twoTimes, nullptr, numSamples * 2);
+        }
+
+        if (factor > 1)
+            twoTimesPosition = (twoTimesPosition + numSamples * 2) & (historyLength - 1);
+    }
+
+    if (previousPath != 0)
+    {
+        // the new path fades in over the old one
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto* samples = output.getWritePointer (channel);
+            const auto* oldSamples = crossfadeBuffer.getReadPointer (channel);
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                auto gain = juce::jlimit (0.0f, 1.0f, (float) (crossfadePosition + i + 1 - crossfadeDelay) / (float) crossfadeLength);
+                samples[i] = oldSamples[i] + gain * (samples[i] - oldSamples[i]);
+            }
+        }
+
+        crossfadePosition += numSamples;
+
+        if (crossfadePosition >= crossfadeDelay + crossfadeLength)
+            previousPath = 0;
+    }
+}
+
+int Oversampler::getWarmUpSamples (int path) const noexcept
+{
+    // how far back a path's delay and filters reach, in output samples
+    return path == 4 ? fourTimesFirstStage.getHistoryLength() / 4 + fourTimesSecondStage.getHistoryLength() / 2
+         : path == 2 ? twoTimesDelay / 2 + twoTimesStage.getHistoryLength() / 2
+                     : 0;
+}
+
+void Oversampler::startPath (int factor, const juce::AudioBuffer<float>& rendered, int numChannels)
+{
+    // the output rate's history is always up to date, and is all the 1x path needs
+    if (factor == 1)
+        return;
+
+    if (! isTwoTimesHistoryCurrent)
+        rebuildTwoTimesHistory (rendered, numChannels);
+
+    auto& secondStage = factor == 2 ? twoTimesStage : fourTimesSecondStage;
+    auto* samples = primeSamples.data();
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        // the 2x to 1x stage has had the 2x samples up to its path's delay
+        copyTwoTimesHistory (channel, twoTimesDelay, samples, secondStage.getHistoryLength());
+        secondStage.setHistory (channel, samples, secondStage.getHistoryLength());
+
+        if (factor == 4)
+        {
+            // and the first stage the newest 2x samples, brought up to 4x - the render's first sample comes next
+            const auto numFourTimes = fourTimesFirstStage.getHistoryLength();
+
+            copyTwoTimesHistory (channel, 0, samples, numFourTimes / 2);
+            upsample (samples, samples + historyLength, numFourTimes / 2, rendered.getSample (channel, 0));
+            fourTimesFirstStage.setHistory (channel, samples + historyLength, numFourTimes);
+        }
+    }
+}
+
+void Oversampler::rebuildTwoTimesHistory (const juce::AudioBuffer<float>& rendered, int numChannels)
+{
+    // nothing rendered at 2x or 4x lately, so the 2x history is brought up from the output rate's
+    const auto numOutputRate = historyLength / 2;
+    auto* samples = primeSamples.data();
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        const auto* history = outputRateHistory.getReadPointer (channel);
+        auto* twoTimes = twoTimesHistory.getWritePointer (channel);
+
+        for (int i = 0; i < numOutputRate; ++i)
+            samples[i] = history[(outputRatePosition - numOutputRate + i) & (historyLength - 1)];
+
+        upsample (samples, samples + numOutputRate, numOutputRate, rendered.getSample (channel, 0));
+
+        for (int i = 0; i < historyLength; ++i)
+            twoTimes[(twoTimesPosition - historyLength + i) & (historyLength - 1)] = samples[numOutputRate + i];
+    }
+
+    isTwoTimesHistoryCurrent = true;
+}
+
+void Oversampler::processPath (int path, int factor, const juce::AudioBuffer<float>& rendered,
+                               juce::AudioBuffer<float>& pathOutput, int numChannels, int numSamples)
+{
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        // the output rate's history hasn't had this block yet
+        const auto previous = outputRateHistory.getSample (channel, (outputRatePosition - 1) & (historyLength - 1));
+        const auto* input = rendered.getReadPointer (channel);
+        auto* resampled = resampledBuffer.getWritePointer (channel);
+        auto* delayed = delayedBuffer.getWritePointer (channel);
+        auto* out = pathOutput.getWritePointer (channel);
+
+        if (path == 2)
+        {
+            // a 4x render gives every other sample, a 1x render gets them drawn in between
+            const auto* twoTimes = input;
+
+            if (factor == 4)
+            {
+                for (int i = 0; i < numSamples * 2; ++i)
+                    resampled[i] = input[2 * i];
+
+                twoTimes = resampled;
+            }
+            else if (factor == 1)
+            {
+                upsample (input, resampled, numSamples, extrapolate (input, numSamples, previous));
+                twoTimes = resampled;
+            }
+
+            pushTwoTimesHistory (channel, twoTimes, delayed, numSamples * 2);
+            twoTimesStage.process (channel, delayed, out, numSamples * 2);
+        }
+        else
+        {
+            const auto* fourTimes = input;
+
+            if (factor == 2)
+            {
+                upsample (input, resampled, numSamples * 2, extrapolate (input, numSamples * 2, previous));
+                fourTimes = resampled;
+            }
+            else if (factor == 1)
+            {
+                upsample (input, delayed, numSamples, extrapolate (input, numSamples, previous));
+                upsample (delayed, resampled, numSamples * 2, extrapolate (delayed, numSamples * 2, previous));
+                fourTimes = resampled;
+            }
+
+            auto* halfRate = halfRateBuffer.getWritePointer (channel);
+            fourTimesFirstStage.process (channel, fourTimes, halfRate, numSamples * 4);
+            fourTimesSecondStage.process (channel, halfRate, out, numSamples * 2);
+        }
+    }
+
+    if (path == 2)
+    {
+        twoTimesPosition = (twoTimesPosition + numSamples * 2) & (historyLength - 1);
+        isTwoTimesHistoryCurrent = true;
+    }
+}
+
+void Oversampler::pushOutputRateHistory (const juce::AudioBuffer<float>& rendered, int factor, juce::AudioBuffer<float>* pathOutput,
+                                         int numChannels, int numSamples)
+{
+    // every factor-th sample of the render is the output rate's, and the 1x path is only this history delayed
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        const auto* input = rendered.getReadPointer (channel);
+        auto* out = pathOutput != nullptr ? pathOutput->getWritePointer (channel) : nullptr;
+        auto* history = outputRateHistory.getWritePointer (channel);
+        auto position = outputRatePosition;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            history[position] = input[i * factor];
+
+            if (out != nullptr)
+                out[i] = history[(position - latencySamples) & (historyLength - 1)];
+
+            position = (position + 1) & (historyLength - 1);
+        }
+    }
+
+    outputRatePosition = (outputRatePosition + numSamples) & (historyLength - 1);
+}
+
+void Oversampler::pushTwoTimesHistory (int channel, const float* input, float* delayed, int numInput) noexcept
+{
+    // the caller moves twoTimesPosition on once every channel is in
+    auto* history = twoTimesHistory.getWritePointer (channel);
+    auto position = twoTimesPosition;
+
+    for (int i = 0; i < numInput; ++i)
+    {
+        history[position] = input[i];
+
+        if (delayed != nullptr)
+            delayed[i] = history[(position - twoTimesDelay) & (historyLength - 1)];
+
+        position = (position + 1) & (historyLength - 1);
+    }
+}
+
+void Oversampler::copyTwoTimesHistory (int channel, int endDelay, float* dest, int numSamples) const noexcept
+{
+    const auto* history = twoTimesHistory.getReadPointer (channel);
+
+    for (int i = 0; i < numSamples; ++i)
+        dest[i] = history[(twoTimesPosition - endDelay - numSamples + i) & (historyLength - 1)];
+}
+
+void Oversampler::upsample (const float* input, float* output, int numInput, float next) noexcept
+{
+    // a straight line between the samples, next being the one after the last
+    for (int i = 0; i < numInput - 1; ++i)
+    {
+        output[2 * i] = input[i];
+        output[2 * i + 1] = 0.5f * (input[i] + input[i + 1]);
+    }
+
+    output[2 * numInput - 2] = input[numInput - 1];
+    output[2 * numInput - 1] = 0.5f * (input[numInput - 1] + next);
+}
+
+float Oversampler::extrapolate (const float* input, int numInput, float previous) noexcept
+{
+    // the sample after a block hasn't been rendered yet, so the line through the last two goes on -
+    // previous is the one before a block of a single sample
+    return 2.0f * input[numInput - 1] - (numInput > 1 ? input[numInput - 2] : previous);
+}
@@ -0,0 +1,149 @@
+/*
+  ==============================================================================
+
+    Oversampler.h
+    Created: 25 Oct 2026 3:05:19pm
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+//==============================================================================
+/**
+    Halves the sample rate with a half-band low-pass, split into its two
+    polyphase branches.
+
+    Every other tap of a half-band filter is zero, so the even input samples
+    only meet the centre tap - a delay and a gain of 0.5 - and the odd ones go
+    through the remaining side taps. Those run one tap at a time over the whole
+    block with the vector operations, instead of one output sample at a time.
+
+    The centre tap sits on the even input samples, so the filter's delay is a
+    whole number of output samples.
+*/
+class HalfBandDecimator
+{
+public:
+    /** extraDelay delays the input by that many output samples before the filter. */
+    explicit HalfBandDecimator (int extraDelay = 0);
+
+    /** maxInputSamples is the most process() will get per call, per channel. */
+    void prepare (int numChannels, int maxInputSamples);
+    void reset();
+
+    /** Filters numInput samples (an even number) of one channel into numInput / 2 output samples. */
+    void process (int channel, const float* input, float* output, int numInput) noexcept;
+
+    /** Fills one channel's branches as if the last numInput samples it had processed were these -
+        numInput is an even number of at least getHistoryLength(). */
+    void setHistory (int channel, const float* input, int numInput) noexcept;
+
+    /** How many input samples the filter reaches back to. */
+    int getHistoryLength() const noexcept           { return 2 * (numSideTaps - 1 + extraDelay); }
+
+    /** The delay of the filter with the extra delay, in output samples. */
+    int getLatency() const noexcept                 { return latency + extraDelay; }
+
+    /** The non-zero taps either side of the centre. */
+    static constexpr int numTapsPerSide = 12;
+    static constexpr int numSideTaps = 2 * numTapsPerSide;
+
+    /** The delay of the filter, in output samples. */
+    static constexpr int latency = numTapsPerSide - 1;
+
+private:
+    const int extraDelay;
+
+    // the side taps, and each channel's branches with the samples the taps reach back to in front
+    std::array<float, numSideTaps> coefficients {};
+    std::vector<std::vector<float>> centreBranches, sideBranches;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (HalfBandDecimator)
+};
+
+//==============================================================================
+/**
+    Lets the voices render at 2x or 4x the output rate and brings their mix
+    back down, so the tape's top end doesn't fold back when a note reads the
+    tape several times faster than normal.
+
+    The factor can change from block to block. Every factor's path comes out
+    exactly latencySamples late - the 4x path's first stage waits one sample
+    more, so its delay is a whole number of output samples, and the slower
+    paths make up the rest with a plain delay - so switching factors never
+    moves a note in time.
+
+    The last samples at the output rate and at 2x follow every block's render,
+    whatever the factor, so a path that starts again fills its filters from
+    them instead of starting from silence. The old path keeps running for a
+    moment after a switch, on the render brought to its rate, and the two are
+    crossfaded: a faster path fades in over crossfadeSamples once its filters
+    hold nothing but its own render, a slower one takes over within the old
+    path's latency.
+*/
+class Oversampler
+{
+public:
+    Oversampler() {}
+
+    void prepare (int numChannels, int maxBlockSize);
+    void reset();
+
+    static constexpr int maxFactor = 4;
+
+    /** False if the buffers prepare() made aren't big enough for this block at this factor. */
+    bool canProcess (int factor, int numChannels, int numSamples) const noexcept;
+
+    /** A cleared buffer of numSamples * factor samples for the voices to render into. */
+    juce::AudioBuffer<float>& getBuffer (int factor, int numChannels, int numSamples);
+
+    /** Brings what was rendered into getBuffer() back down to the output rate and into output.
+        A factor of 1 only delays output, which then holds the voices' mix already. */
+    void process (juce::AudioBuffer<float>& output, int factor, int numSamples);
+
+    /** Every factor's latency, in output samples. */
+    static int getLatencySamples() noexcept         { return latencySamples; }
+
+    /** How long a faster path takes to fade in, once it's running on its own render. */
+    static constexpr int crossfadeSamples = 64;
+
+private:
+    int getWarmUpSamples (int path) const noexcept;
+    void startPath (int factor, const juce::AudioBuffer<float>& rendered, int numChannels);
+    void rebuildTwoTimesHistory (const juce::AudioBuffer<float>& rendered, int numChannels);
+    void processPath (int path, int factor, const juce::AudioBuffer<float>& rendered,
+                      juce::AudioBuffer<float>& pathOutput, int numChannels, int numSamples);
+    void pushOutputRateHistory (const juce::AudioBuffer<float>& rendered, int factor, juce::AudioBuffer<float>* pathOutput,
+                                int numChannels, int numSamples);
+    void pushTwoTimesHistory (int channel, const float* input, float* delayed, int numInput) noexcept;
+    void copyTwoTimesHistory (int channel, int endDelay, float* dest, int numSamples) const noexcept;
+    static void upsample (const float* input, float* output, int numInput, float next) noexcept;
+    static float extrapolate (const float* input, int numInput, float previous) noexcept;
+
+    // the 2x path waits for the 4x path's first stage, so both reach the 2x to 1x stage equally late
+    static constexpr int firstStageExtraDelay = 1;
+    static constexpr int twoTimesDelay = HalfBandDecimator::latency + firstStageExtraDelay;
+    static constexpr int latencySamples = twoTimesDelay / 2 + HalfBandDecimator::latency;
+
+    juce::AudioBuffer<float> buffer, resampledBuffer, halfRateBuffer, delayedBuffer, crossfadeBuffer;
+    HalfBandDecimator twoTimesStage;                                            // 2x to 1x
+    HalfBandDecimator fourTimesFirstStage { firstStageExtraDelay };             // 4x to 2x
+    HalfBandDecimator fourTimesSecondStage;                                     // 2x to 1x
+
+    int preparedChannels = 0, preparedBlockSize = 0;
+    int currentPath = 0, previousPath = 0;
+    int crossfadePosition = 0, crossfadeDelay = 0, crossfadeLength = crossfadeSamples;
+
+    // the last samples at the output rate and at twice that, at the time they were rendered
+    static constexpr int historyLength = 128;
+    juce::AudioBuffer<float> outputRateHistory, twoTimesHistory;
+    int outputRatePosition = 0, twoTimesPosition = 0;
+    bool isTwoTimesHistoryCurrent = false;
+    std::array<float, 2 * historyLength> primeSamples {};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Oversampler)
+};
@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    ParallelUnits.h
+    Created: 27 Oct 2026 10:18:44am
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+//==============================================================================
+/**
+    Runs runUnit (0) to runUnit (numUnits - 1) on the pool's threads and the
+    calling one, and returns once all of them are done.
+
+    Each unit is picked up by whichever thread gets to it first, so the units must
+    only write to their own part of the result. pool can be nullptr, then the
+    calling thread runs them all.
+*/
+inline void runInParallel (int numUnits, juce::ThreadPool* pool, std::function<void (int)> runUnit)
+{
+    struct Job
+    {
+        std::function<void (int)> runUnit;
+        int numUnits = 0;
+
+        std::atomic<int> nextUnit { 0 };
+        std::atomic<int> numUnitsDone { 0 };
+        juce::WaitableEvent finished;
+
+        void run()
+        {
+            for (;;)
+            {
+                auto unit = nextUnit++;
+                if (unit >= numUnits)
+                    return;
+
+                runUnit (unit);
+
+                if (++numUnitsDone == numUnits)
+                    finished.signal();
+            }
+        }
+    };
+
+    if (numUnits <= 0)
+        return;
+
+    auto job = std::make_shared<Job>();
+    job->runUnit = std::move (runUnit);
+    job->numUnits = numUnits;
+
+    // helpers that only get to run once everything is done just find no work left
+    if (pool != nullptr)
+        for (int i = 0; i < juce::jmin (pool->getNumThreads(), numUnits - 1); ++i)
+            pool->addJob ([job] { job->run(); });
+
+    job->run();
+    job->finished.wait (-1);
+}
@@ -0,0 +1,176 @@
+/*
+  ==============================================================================
+
+    PeakAnalyser.cpp
+    Created: 22 Oct 2026 4:05:51pm
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#include "PeakAnalyser.h"
+
+PeakAnalyser::PeakAnalyser() : juce::Thread ("Peak Analyser")
+{
+    startThread();
+}
+
+PeakAnalyser::~PeakAnalyser()
+{
+    stopThread (10000);
+    helpers.removeAllJobs (true, 10000);
+}
+
+void PeakAnalyser::request (const void* owner, GrainTape::Ptr tape, const juce::File& source, Callback onBuilt)
+{
+    {
+        const juce::ScopedLock sl (lock);
+
+        requests.erase (std::remove_if (requests.begin(), requests.end(),
+                                        [owner] (const Request& r) { return r.owner == owner; }),
+                        requests.end());
+
+        Request newRequest;
+        newRequest.owner = owner;
+        newRequest.generation = ++nextGeneration;
+        newRequest.tape = tape;
+        newRequest.source = source;
+        newRequest.onBuilt = std::move (onBuilt);
+        requests.push_back (std::move (newRequest));
+    }
+
+    notify();
+}
+
+void PeakAnalyser::cancel (const void* owner)
+{
+    const juce::ScopedLock sl (lock);
+
+    requests.erase (std::remove_if (requests.begin(), requests.end(),
+                                    [owner] (const Request& r) { return r.owner == owner; }),
+                    requests.end());
+
+    visibleOwners.erase (owner);
+}
+
+void PeakAnalyser::setVisible (const void* owner, bool isVisible)
+{
+    const juce::ScopedLock sl (lock);
+    visibleOwners[owner] = isVisible;
+}
+
+void PeakAnalyser::run()
+{
+    while (! threadShouldExit())
+    {
+        const void* owner = nullptr;
+        int generation = 0;
+        GrainTape::Ptr tape;
+        juce::File source;
+
+        {
+            const juce::ScopedLock sl (lock);
+
+            // the first waiting request of a visible owner, or else the first waiting one
+            Request* next = nullptr;
+
+            for (auto& r : requests)
+            {
+                if (r.isBuilding || r.result != nullptr)
+                    continue;
+
+                auto visible = visibleOwners.find (r.owner);
+                if (visible != visibleOwners.end() && visible->second)
+                {
+                    next = &r;
+                    break;
+                }
+
+                if (next == nullptr)
+                    next = &r;
+            }
+
+            if (next != nullptr)
+            {
+                next->isBuilding = true;
+                owner = next->owner;
+                generation = next->generation;
+                tape = next->tape;
+                source = next->source;
+            }
+        }
+
+        if (tape == nullptr)
+        {
+            wait (-1);
+            continue;
+        }
+
+        auto peaks = createPeaks (*tape, source);
+
+        {
+            const juce::ScopedLock sl (lock);
+
+            for (auto& r : requests)
+                if (r.owner == owner && r.generation == generation)
+                    r.result = peaks;
+        }
+
+        juce::WeakReference<PeakAnalyser> weakThis (this);
+        juce::MessageManager::callAsync ([weakThis, owner, generation]
+        {
+            if (weakThis != nullptr)
+                weakThis->deliver (owner, generation);
+        });
+    }
+}
+
+PeakPyramid::Ptr PeakAnalyser::createPeaks (const GrainTape& tape, const juce::File& source)
+{
+    PeakPyramid::Ptr peaks;
+    juce::File cacheFile;
+
+    if (source.existsAsFile())
+    {
+        cacheFile = PeakPyramid::getCacheFile (source);
+        peaks = PeakPyramid::readFromFile (cacheFile);
+
+        // a cache from before the tape length limit changed doesn't fit
+        if (peaks != nullptr && peaks->getNumSamples() != tape.getLength())
+            peaks = nullptr;
+    }
+
+    if (peaks == nullptr)
+    {
+        peaks = PeakPyramid::build (tape, &helpers);
+
+        if (cacheFile != juce::File{})
+            peaks->writeToFile (cacheFile);
+    }
+
+    return peaks;
+}
+
+void PeakAnalyser::deliver (const void* owner, int generation)
+{
+    Request finished;
+
+    {
+        const juce::ScopedLock sl (lock);
+
+        auto found = std::find_if (requests.begin(), requests.end(), [owner, generation] (const Request& r)
+        {
+            return r.owner == owner && r.generation == generation && r.result != nullptr;
+        });
+
+        // replaced or cancelled in the meantime
+        if (found == requests.end())
+            return;
+
+        finished = std::move (*found);
+        requests.erase (found);
+    }
+
+    if (finished.onBuilt != nullptr)
+        finished.onBuilt (finished.tape, finished.result);
+}
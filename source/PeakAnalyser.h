@@ -0,0 +1,68 @@
+/*
+  ==============================================================================
+
+    PeakAnalyser.h
+    Created: 22 Oct 2026 4:05:51pm
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PeakPyramid.h"
+
+//==============================================================================
+/**
+    Builds waveform peaks for every plugin instance in the process, one tape at
+    a time, through a juce::SharedResourcePointer.
+
+    Each owner has at most one tape waiting - a new request replaces the old
+    one. Owners whose editor is on screen are served first, so with lots of
+    instances open the waveform the user is looking at shows up first.
+*/
+class PeakAnalyser : private juce::Thread
+{
+public:
+    using Callback = std::function<void (GrainTape::Ptr tape, PeakPyramid::Ptr peaks)>;
+
+    PeakAnalyser();
+    ~PeakAnalyser() override;
+
+    /** Message thread only. The callback is called on the message thread unless the request gets cancelled first.
+        Pass the file the tape came from to use the disk cache, or an empty file. */
+    void request (const void* owner, GrainTape::Ptr tape, const juce::File& source, Callback onBuilt);
+
+    /** Message thread only. Forgets the owner's request, its callback won't be called after this. */
+    void cancel (const void* owner);
+
+    /** Visible owners go to the front of the queue. */
+    void setVisible (const void* owner, bool isVisible);
+
+private:
+    struct Request
+    {
+        const void* owner = nullptr;
+        int generation = 0;
+        GrainTape::Ptr tape;
+        juce::File source;
+        Callback onBuilt;
+        bool isBuilding = false;
+        PeakPyramid::Ptr result;
+    };
+
+    void run() override;
+    PeakPyramid::Ptr createPeaks (const GrainTape& tape, const juce::File& source);
+    void deliver (const void* owner, int generation);
+
+    juce::ThreadPool helpers { juce::jmax (1, juce::SystemStats::getNumCpus() - 1) };
+
+    juce::CriticalSection lock;
+    std::vector<Request> requests;
+    std::map<const void*, bool> visibleOwners;
+    int nextGeneration = 0;
+
+    JUCE_DECLARE_WEAK_REFERENCEABLE (PeakAnalyser)
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PeakAnalyser)
+};
@@ -0,0 +1,292 @@
+/*
+  ==============================================================================
+
+    PeakPyramid.cpp
+    Created: 22 Oct 2026 9:40:26am
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#include "PeakPyramid.h"
+#include "ParallelUnits.h"
+
+namespace
+{
+    constexpr int fileMagic = 0x4b505054; // "TPPK"
+    constexpr int fileVersion = 1;
+    constexpr int peaksPerUnit = 1024;
+}
+
+PeakPyramid::PeakPyramid (int channels, juce::int64 samples, double rate)
+    : numChannels (channels), numSamples (samples), sampleRate (rate)
+{
+}
+
+PeakPyramid::Ptr PeakPyramid::build (const GrainTape& tape, juce::ThreadPool* pool)
+{
+    auto& data = tape.getData();
+    Ptr pyramid = new PeakPyramid (data.getNumChannels(), tape.getLength(), tape.getSampleRate());
+
+    auto numPeaks = (int) ((tape.getLength() + baseSamplesPerPeak - 1) / baseSamplesPerPeak);
+
+    pyramid->levels.resize (1);
+    auto& base = pyramid->levels.front();
+    base.samplesPerPeak = baseSamplesPerPeak;
+    base.channels.resize ((size_t) pyramid->numChannels, std::vector<Peak> ((size_t) numPeaks));
+
+    const auto numUnits = pyramid->numChannels * ((numPeaks + peaksPerUnit - 1) / peaksPerUnit);
+    if (numUnits == 0)
+        return pyramid;
+
+    // the first level is cut into units of work that any thread can pick up
+    const auto length = tape.getLength();
+    const auto numChannels = pyramid->numChannels;
+
+    runInParallel (numUnits, pool, [&] (int unit)
+    {
+        auto& peaks = base.channels[(size_t) (unit % numChannels)];
+        auto* samples = data.getReadPointer (unit % numChannels);
+
+        auto firstPeak = (unit / numChannels) * peaksPerUnit;
+        auto endPeak = juce::jmin (firstPeak + peaksPerUnit, (int) peaks.size());
+
+        for (auto i = firstPeak; i < endPeak; ++i)
+        {
+            auto start = (juce::int64) i * baseSamplesPerPeak;
+            peaks[(size_t) i] = scan (samples + start, (int) juce::jmin ((juce::int64) baseSamplesPerPeak, length - start));
+        }
+    });
+
+    pyramid->addLevelsAbove();
+    return pyramid;
+}
+
+PeakPyramid::Peak PeakPyramid::scan (const float* samples, int num) noexcept
+{
+    Peak peak;
+    if (num <= 0)
+        return peak;
+
+    auto range = juce::FloatVectorOperations::findMinAndMax (samples, num);
+    peak.minimum = range.getStart();
+    peak.maximum = range.getEnd();
+
+    // four separate sums, so the compiler is free to vectorise this
+    float sums[4] = {};
+    int i = 0;
+
+    for (; i + 4 <= num; i += 4)
+        for (int j = 0; j < 4; ++j)
+            sums[j] += samples[i + j] * samples[i + j];
+
+    for (; i < num; ++i)
+        sums[0] += samples[i] * samples[i];
+
+    peak.meanSquare = (sums[0] + sums[1] + sums[2] + sums[3]) / (float) num;
+    return peak;
+}
+
+PeakPyramid::Peak PeakPyramid::merge (const Peak& a, const Peak& b) noexcept
+{
+    Peak peak;
+    peak.minimum = juce::jmin (a.minimum, b.minimum);
+    peak.maximum = juce::jmax (a.maximum, b.maximum);
+    peak.meanSquare = (a.meanSquare + b.meanSquare) * 0.5f;
+    return peak;
+}
+
+void PeakPyramid::addLevelsAbove()
+{
+    while (levels.back().channels.front().size() > 1)
+    {
+        Level level;
+        level.samplesPerPeak = levels.back().samplesPerPeak * 2;
+
+        for (auto& below : levels.back().channels)
+        {
+            std::vector<Peak> peaks ((below.size() + 1) / 2);
+
+            for (size_t i = 0; i < peaks.size(); ++i)
+                peaks[i] = 2 * i + 1 < below.size() ? merge (below[2 * i], below[2 * i + 1]) : below[2 * i];
+
+            level.channels.push_back (std::move (peaks));
+        }
+
+        levels.push_back (std::move (level));
+    }
+}
+
+//==============================================================================
+juce::File PeakPyramid::getCacheFile (const juce::File& source)
+{
+    auto key = source.getFullPathName()
+             + juce::String (source.getSize())
+             + juce::String (source.getLastModificationTime().toMilliseconds());
+
+    return juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
+             .getChildFile ("TapePerformer")
+             .getChildFile ("PeakCache")
+             .getChildFile (juce::String::toHexString (key.hashCode64()) + ".peaks");
+}
+
+PeakPyramid::Ptr PeakPyramid::readFromFile (const juce::File& file)
+{
+    juce::FileInputStream input (file);
+
+    if (! input.openedOk())
+        return nullptr;
+
+    return readFrom (input);
+}
+
+bool PeakPyramid::writeToFile (const juce::File& file) const
+{
+    if (! file.getParentDirectory().createDirectory())
+        return false;
+
+    // written next to the target first, so a half written cache file is never read
+    juce::TemporaryFile temp (file);
+
+    {
+        juce::FileOutputStream output (temp.getFile());
+
+        if (! output.openedOk() || ! writeTo (output))
+            return false;
+    }
+
+    return temp.overwriteTargetFileWithTemporary();
+}
+
+PeakPyramid::Ptr PeakPyramid::readFrom (juce::InputStream& input)
+{
+    if (input.readInt() != fileMagic || input.readInt() != fileVersion)
+        return nullptr;
+
+    auto channels = input.readInt();
+    auto samples = input.readInt64();
+    auto rate = input.readDouble();
+    auto numLevels = input.readInt();
+
+    if (channels <= 0 || channels > 2 || samples <= 0 || rate <= 0 || numLevels <= 0 || numLevels > 64)
+        return nullptr;
+
+    Ptr pyramid = new PeakPyramid (channels, samples, rate);
+
+    for (int l = 0; l < numLevels; ++l)
+    {
+        Level level;
+        level.samplesPerPeak = input.readInt();
+        auto numPeaks = input.readInt();
+
+        if (level.samplesPerPeak != baseSamplesPerPeak << l
+            || numPeaks != (int) ((samples + level.samplesPerPeak - 1) / level.samplesPerPeak))
+            return nullptr;
+
+        for (int channel = 0; channel < channels; ++channel)
+        {
+            std::vector<Peak> peaks ((size_t) numPeaks);
+            auto numBytes = (int) (peaks.size() * sizeof (Peak));
+
+            if (input.read (peaks.data(), numBytes) != numBytes)
+                return nullptr;
+
+            level.channels.push_back (std::move (peaks));
+        }
+
+        pyramid->levels.push_back (std::move (level));
+    }
+
+    return pyramid;
+}
+
+bool PeakPyramid::writeTo (juce::OutputStream& output) const
+{
+    output.writeInt (fileMagic);
+    output.writeInt (fileVersion);
+    output.writeInt (numChannels);
+    output.writeInt64 (numSamples);
+    output.writeDouble (sampleRate);
+    output.writeInt ((int) levels.size());
+
+    for (auto& level : levels)
+    {
+        output.writeInt (level.samplesPerPeak);
+        output.writeInt ((int) level.channels.front().size());
+
+        for (auto& peaks : level.channels)
+            if (! output.write (peaks.data(), peaks.size() * sizeof (Peak)))
+                return false;
+    }
+
+    output.flush();
+    return output.getStatus().wasOk();
+}
+
+//==============================================================================
+void PeakPyramid::drawChannels (juce::Graphics& g, juce::Rectangle<int> area, double startSample, double endSample,
+                                juce::Colour peakColour, juce::Colour rmsColour) const
+{
+    if (levels.empty() || area.isEmpty() || endSample <= startSample)
+        return;
+
+    auto samplesPerPixel = (endSample - startSample) / area.getWidth();
+
+    // the coarsest level that still has at least one peak per pixel
+    size_t levelIndex = 0;
+    while (levelIndex + 1 < levels.size() && levels[levelIndex + 1].samplesPerPeak <= samplesPerPixel)
+        ++levelIndex;
+
+    auto laneHeight = area.getHeight() / numChannels;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        drawChannel (g, area.removeFromTop (laneHeight), levels[levelIndex], channel,
+                     startSample, samplesPerPixel, peakColour, rmsColour);
+}
+
+void PeakPyramid::drawChannel (juce::Graphics& g, juce::Rectangle<int> area, const Level& level, int channel,
+                               double startSample, double samplesPerPixel, juce::Colour peakColour, juce::Colour rmsColour) const
+{
+    auto& peaks = level.channels[(size_t) channel];
+    auto numPeaks = (int) peaks.size();
+
+    std::vector<Peak> columns ((size_t) area.getWidth());
+    int numColumns = 0;
+
+    for (; numColumns < area.getWidth(); ++numColumns)
+    {
+        auto first = (int) std::floor ((startSample + numColumns * samplesPerPixel) / level.samplesPerPeak);
+        auto end = (int) std::ceil ((startSample + (numColumns + 1) * samplesPerPixel) / level.samplesPerPeak);
+
+        first = juce::jmax (0, first);
+        end = juce::jmin (numPeaks, juce::jmax (first + 1, end));
+
+        if (first >= numPeaks)
+            break;
+
+        auto column = peaks[(size_t) first];
+        for (auto i = first + 1; i < end; ++i)
+            column = merge (column, peaks[(size_t) i]);
+
+        columns[(size_t) numColumns] = column;
+    }
+
+    auto centre = (float) area.getCentreY();
+    auto halfHeight = (float) area.getHeight() * 0.5f;
+
+    g.setColour (peakColour);
+    for (int x = 0; x < numColumns; ++x)
+    {
+        auto top = centre - juce::jlimit (-1.0f, 1.0f, columns[(size_t) x].maximum) * halfHeight;
+        auto bottom = centre - juce::jlimit (-1.0f, 1.0f, columns[(size_t) x].minimum) * halfHeight;
+        g.drawVerticalLine (area.getX() + x, top, juce::jmax (bottom, top + 1.0f));
+    }
+
+    g.setColour (rmsColour);
+    for (int x = 0; x < numColumns; ++x)
+    {
+        auto rms = juce::jmin (1.0f, std::sqrt (columns[(size_t) x].meanSquare)) * halfHeight;
+        if (rms >= 0.5f)
+            g.drawVerticalLine (area.getX() + x, centre - rms, centre + rms);
+    }
+}
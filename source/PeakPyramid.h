@@ -0,0 +1,87 @@
+/*
+  ==============================================================================
+
+    PeakPyramid.h
+    Created: 22 Oct 2026 9:40:26am
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "GrainTape.h"
+
+//==============================================================================
+/**
+    Min, max and RMS levels of a tape at power-of-two resolutions.
+
+    The first level has one peak per baseSamplesPerPeak samples, every level
+    after that merges two peaks of the one below. Drawing picks the level that
+    is closest to one peak per pixel, so it never touches more than a couple of
+    peaks per pixel whatever the zoom - and never the samples themselves.
+
+    Pyramids can be written to a cache file keyed by the file they came from,
+    so a tape that was seen before doesn't get scanned again.
+*/
+class PeakPyramid : public juce::ReferenceCountedObject
+{
+public:
+    using Ptr = juce::ReferenceCountedObjectPtr<PeakPyramid>;
+
+    struct Peak
+    {
+        float minimum = 0, maximum = 0;
+        float meanSquare = 0;
+    };
+
+    static constexpr int baseSamplesPerPeak = 64;
+
+    /** Scans the tape, spreading the first level over the pool's threads as well as the calling one. */
+    static Ptr build (const GrainTape& tape, juce::ThreadPool* pool);
+
+    //==============================================================================
+    /** The file a source's pyramid is cached in - it changes with the file's size and date. */
+    static juce::File getCacheFile (const juce::File& source);
+
+    /** Returns nullptr if there is no valid cache file. */
+    static Ptr readFromFile (const juce::File& file);
+    bool writeToFile (const juce::File& file) const;
+
+    static Ptr readFrom (juce::InputStream& input);
+    bool writeTo (juce::OutputStream& output) const;
+
+    //==============================================================================
+    int getNumChannels() const noexcept             { return numChannels; }
+    juce::int64 getNumSamples() const noexcept      { return numSamples; }
+    double getSampleRate() const noexcept           { return sampleRate; }
+    int getNumLevels() const noexcept               { return (int) levels.size(); }
+
+    /** Draws every channel in its own lane, between two sample positions of the tape. */
+    void drawChannels (juce::Graphics& g, juce::Rectangle<int> area, double startSample, double endSample,
+                       juce::Colour peakColour, juce::Colour rmsColour) const;
+
+private:
+    PeakPyramid (int numChannels, juce::int64 numSamples, double sampleRate);
+
+    struct Level
+    {
+        int samplesPerPeak = 0;
+        std::vector<std::vector<Peak>> channels;
+    };
+
+    static Peak scan (const float* samples, int num) noexcept;
+    static Peak merge (const Peak& a, const Peak& b) noexcept;
+    void addLevelsAbove();
+
+    void drawChannel (juce::Graphics& g, juce::Rectangle<int> area, const Level& level, int channel,
+                      double startSample, double samplesPerPixel, juce::Colour peakColour, juce::Colour rmsColour) const;
+
+    int numChannels = 0;
+    juce::int64 numSamples = 0;
+    double sampleRate = 0;
+    std::vector<Level> levels;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PeakPyramid)
+};
@@ -11,17 +11,20 @@
 
 #include <utility>
 #include "WaveDisplay.h"
+#include "TraceZones.h"
 
 //==============================================================================
 TapePerformerAudioProcessorEditor::TapePerformerAudioProcessorEditor (TapePerformerAudioProcessor& p)
-    : AudioProcessorEditor (&p), waveDisplay(p), audioProcessor (p), fluxModeEditor(p)
+    : AudioProcessorEditor (&p), waveDisplay(p), envDisplay(p.apvts), audioProcessor (p), fluxModeEditor(p), loadOverlay(p)
 {
 
     setLookAndFeel(&customLookAndFeel);
+    audioProcessor.editorOpened();
 
     addAndMakeVisible(waveDisplay);
     addAndMakeVisible(envDisplay);
     addAndMakeVisible(fluxModeEditor);
+    addAndMakeVisible(loadOverlay);
     setResizable(true, true);
     setResizeLimits(800, 250, 1200, 400);
     setSize (800, 300);
@@ -102,11 +105,13 @@ TapePerformerAudioProcessorEditor::TapePerformerAudioProcessorEditor (TapePerfor
 TapePerformerAudioProcessorEditor::~TapePerformerAudioProcessorEditor()
 {
     setLookAndFeel (nullptr);
+    audioProcessor.editorClosed();
 }
 
 //==============================================================================
 void TapePerformerAudioProcessorEditor::paint (juce::Graphics& g)
 {
+    TP_TRACE_ZONE ("Editor::paint");
     
     auto bgHue = juce::Colour::fromString("#FFB830").getHue();
     auto backgroundColour = juce::Colour(bgHue, 0.5f, .0f, 1.0f);
@@ -152,6 +157,9 @@ void TapePerformerAudioProcessorEditor::resized()
     envDisplay.setBounds(waveEnvArea.reduced(0));
     fluxModeEditor.setBounds(fluxModeArea.reduced(0));
 
+    // sits on top of the wave display's bottom right corner, clear of its buttons
+    loadOverlay.setBounds(responseArea.reduced(3).removeFromBottom(22).removeFromRight(380).reduced(3));
+
 
     numKeysLabel.setBounds(settingsArea.removeFromTop(juce::jmax (20, parameterArea.getHeight() / 6)).reduced(2));
     numKeysMenu.setBounds(settingsArea.removeFromTop(juce::jmax (20, parameterArea.getHeight() / 6)).reduced(2));
@@ -15,6 +15,7 @@
 #include "CustomToggleButton.h"
 #include "CustomLookAndFeel.h"
 #include "FluxModeEditor.h"
+#include "LoadOverlay.h"
 //==============================================================================
 /**
 */
@@ -39,6 +40,7 @@ private:
     WaveDisplay waveDisplay;
     EnvelopeDisplay envDisplay;
     FluxModeEditor fluxModeEditor;
+    LoadOverlay loadOverlay;
     
     
     juce::Label modeLabel         { {}, "Modes"};
@@ -8,6 +8,7 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "TraceZones.h"
 
 //==============================================================================
 TapePerformerAudioProcessor::TapePerformerAudioProcessor()
@@ -16,14 +17,14 @@ TapePerformerAudioProcessor::TapePerformerAudioProcessor()
                      #if ! JucePlugin_IsMidiEffect
                       #if ! JucePlugin_IsSynth
                        .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
+                      #else
+                       .withInput  ("Sidechain",  juce::AudioChannelSet::stereo(), false)
                       #endif
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
                      #endif
                        )
 #endif
-,thumbnailCache (2),                            // [4]
-thumbnail (512, mFormatManager, thumbnailCache),
-apvts (*this, nullptr, "PARAMETERS", createParameterLayout())
+,apvts (*this, nullptr, "PARAMETERS", createParameterLayout())
 {
     
     modeParameter = apvts.getRawParameterValue ("playMode");
@@ -33,6 +34,7 @@ apvts (*this, nullptr, "PARAMETERS", createParameterLayout())
     secondFluxParameter = apvts.getRawParameterValue("secondFluxMode");
     thirdFluxParameter = apvts.getRawParameterValue("thirdFluxMode");
     fourthFluxParameter = apvts.getRawParameterValue("fourthFluxMode");
+    fifthFluxParameter = apvts.getRawParameterValue("fifthFluxMode");
     fluxModeRange = apvts.getRawParameterValue("fluxModeRange");
     positionParameter = apvts.getRawParameterValue("position");
     durationParameter = apvts.getRawParameterValue("duration");
@@ -40,20 +42,54 @@ apvts (*this, nullptr, "PARAMETERS", createParameterLayout())
     gainParameter  = apvts.getRawParameterValue ("gain");
     envelopeShapeParameter = apvts.getRawParameterValue("envShape");
     transposeParameter = apvts.getRawParameterValue("transpose");
+    tempoSyncParameter = apvts.getRawParameterValue("tempoSync");
+    syncDivisionParameter = apvts.getRawParameterValue("syncDivision");
+    liveInputParameter = apvts.getRawParameterValue("liveInput");
+    freezeParameter = apvts.getRawParameterValue("freeze");
+    overdubParameter = apvts.getRawParameterValue("overdub");
+    resampleParameter = apvts.getRawParameterValue("resample");
+    tapeSlotParameter = apvts.getRawParameterValue("tapeSlot");
+    bankModeParameter = apvts.getRawParameterValue("bankMode");
+    timeStretchParameter = apvts.getRawParameterValue("timeStretch");
+    stretchSpeedParameter = apvts.getRawParameterValue("stretchSpeed");
+    oversamplingParameter = apvts.getRawParameterValue("oversampling");
+    normaliseParameter = apvts.getRawParameterValue("normalise");
+    randomRateParameter = apvts.getRawParameterValue("randomRate");
+
+    for (int i = 0; i < GrainParameters::numLfos; ++i)
+    {
+        auto prefix = "lfo" + juce::String (i + 1);
+        lfoRateParameters[(size_t) i] = apvts.getRawParameterValue (prefix + "Rate");
+        lfoShapeParameters[(size_t) i] = apvts.getRawParameterValue (prefix + "Shape");
+    }
+
+    for (int i = 0; i < GrainParameters::numModulationRoutes; ++i)
+    {
+        auto prefix = "mod" + juce::String (i + 1);
+        auto& route = modulationRouteParameters[(size_t) i];
+        route.source = apvts.getRawParameterValue (prefix + "Source");
+        route.destination = apvts.getRawParameterValue (prefix + "Destination");
+        route.amount = apvts.getRawParameterValue (prefix + "Amount");
+    }
     
     
     mFormatManager.registerBasicFormats();
 
-    
-    for (int i = 0; i < mNumVoices; i++)
+    tapeLoader.onTapeLoaded = [this] (int slot, GrainTape::Ptr tape, const juce::File& file)
     {
-        mSampler.addVoice(new GrainVoice());
-    }
+        engine.setTape (slot, tape);
+        setDisplayedTape (tape, file);
+    };
+
+    tapeLoader.onBankLoaded = [this] (const TapeBank& bank)
+    {
+        setBank (bank);
+    };
 }
  
 TapePerformerAudioProcessor::~TapePerformerAudioProcessor()
 {
-    mFormatReader = nullptr;
+    peakAnalyser->cancel (this);
 }
 
 //==============================================================================
@@ -123,16 +159,17 @@ void TapePerformerAudioProcessor::prepareToPlay (double sampleRate, int samplesP
 {
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
-    mSampler.setCurrentPlaybackSampleRate(sampleRate);
-    
-    previousGain = *gainParameter;
-    
+    engine.prepare(sampleRate, samplesPerBlock);
+
+    // the same whether the oversampling is on or not, so switching it never moves anything in time
+    setLatencySamples (TapeEngine::getLatencySamples());
 }
 
 void TapePerformerAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    engine.release();
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -154,6 +191,13 @@ bool TapePerformerAudioProcessor::isBusesLayoutSupported (const BusesLayout& lay
    #if ! JucePlugin_IsSynth
     if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
         return false;
+   #else
+    // the sidechain that feeds the live tape is optional
+    auto inputLayout = layouts.getMainInputChannelSet();
+    if (! inputLayout.isDisabled()
+     && inputLayout != juce::AudioChannelSet::mono()
+     && inputLayout != juce::AudioChannelSet::stereo())
+        return false;
    #endif
 
     return true;
@@ -163,50 +207,86 @@ bool TapePerformerAudioProcessor::isBusesLayoutSupported (const BusesLayout& lay
 
 void TapePerformerAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+    TP_TRACE_ZONE ("processBlock");
+
     //juce::ScopedNoDenormals noDenormals;
-    auto totalNumInputChannels  = getTotalNumInputChannels();
-    auto totalNumOutputChannels = getTotalNumOutputChannels();
+    auto sidechain = getTotalNumInputChannels() > 0 ? getBusBuffer (buffer, true, 0) : juce::AudioBuffer<float>();
 
-    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
-        buffer.clear (i, 0, buffer.getNumSamples());
+    // bouncing gets the best quality, whatever it costs
+    engine.setNonRealtime (isNonRealtime());
 
-    WavetableEnvelope::envelopeShape = *apvts.getRawParameterValue("envShape");
-    
-    if (auto sound = dynamic_cast<GrainSound*>(mSampler.getSound(0).get()))
+    // the sidechain shares its channels with buffer, the engine records it before it clears the output
+    engine.process (buffer, &sidechain, midiMessages, getParameters(), getTransportInfo());
+}
+
+GrainParameters TapePerformerAudioProcessor::getParameters() const
+{
+    GrainParameters params;
+
+    params.playMode = *modeParameter;
+    params.numKeys = (int) *availableKeysParameter;
+    params.position = (double) *positionParameter;
+    params.duration = (double) *durationParameter;
+    params.spread = *spreadParameter;
+    params.gain = *gainParameter;
+    params.envelopeShape = *envelopeShapeParameter;
+    params.transpose = (int) *transposeParameter;
+
+    params.fluxModeOn = *fluxModeOnParameter >= 0.5f;
+    params.fluxModes = { *firstFluxParameter >= 0.5f, *secondFluxParameter >= 0.5f,
+                         *thirdFluxParameter >= 0.5f, *fourthFluxParameter >= 0.5f,
+                         *fifthFluxParameter >= 0.5f };
+    params.fluxModeRange = *fluxModeRange;
+
+    params.tempoSync = *tempoSyncParameter >= 0.5f;
+    params.syncDivision = (int) *syncDivisionParameter;
+
+    params.liveInput = *liveInputParameter >= 0.5f;
+    params.freeze = *freezeParameter >= 0.5f;
+    params.overdub = *overdubParameter >= 0.5f;
+    params.resample = *resampleParameter >= 0.5f;
+
+    params.tapeSlot = *tapeSlotParameter;
+    params.bankMode = *bankModeParameter >= 0.5f;
+
+    params.timeStretch = *timeStretchParameter >= 0.5f;
+    params.stretchSpeed = *stretchSpeedParameter;
+    params.oversampling = (int) *oversamplingParameter;
+    params.normalise = *normaliseParameter >= 0.5f;
+
+    for (int i = 0; i < GrainParameters::numLfos; ++i)
     {
-        auto& mode = *apvts.getRawParameterValue("playMode");
-        auto& availableKeys = *apvts.getRawParameterValue("numKeys");
-        auto& position = *apvts.getRawParameterValue("position");
-        auto& duration = *apvts.getRawParameterValue("duration");
-        auto& spread = *apvts.getRawParameterValue("spread");
-        auto& midiTrasposition = *apvts.getRawParameterValue("transpose");
-        std::vector<float> fluxMode = {0, 0, 0, 0};
-        if(*apvts.getRawParameterValue("fluxModeOn"))
-        {
-            fluxMode = {*apvts.getRawParameterValue("firstFluxMode"), *apvts.getRawParameterValue("secondFluxMode"), *apvts.getRawParameterValue("thirdFluxMode"), *apvts.getRawParameterValue("fourthFluxMode")};
-        }
-        auto& fluxModeRange = *apvts.getRawParameterValue("fluxModeRange");
+        params.lfoRates[(size_t) i] = *lfoRateParameters[(size_t) i];
+        params.lfoShapes[(size_t) i] = (int) *lfoShapeParameters[(size_t) i];
+    }
 
+    params.randomRate = *randomRateParameter;
 
-        sound->updateParams(mode, (int)availableKeys, (double)position, (double)duration, spread, fluxMode, (int)midiTrasposition, fluxModeRange);
-    }
-    
-    mSampler.renderNextBlock(buffer, midiMessages, 0, buffer.getNumSamples());
-    
-    
-    //Smooth Gain Multiplication with Ramp
-    auto& currentGain = *gainParameter;
-    if (currentGain == previousGain)
+    for (int i = 0; i < GrainParameters::numModulationRoutes; ++i)
     {
-        buffer.applyGain (currentGain);
+        auto& route = modulationRouteParameters[(size_t) i];
+        params.modulationRoutes[(size_t) i] = { (int) *route.source, (int) *route.destination, (float) *route.amount };
     }
-    else
-    {
-        buffer.applyGainRamp (0, buffer.getNumSamples(), previousGain, currentGain);
 
-        previousGain = currentGain;
+    return params;
+}
+
+TransportInfo TapePerformerAudioProcessor::getTransportInfo()
+{
+    TransportInfo transport;
+
+    if (auto* playHead = getPlayHead())
+    {
+        juce::AudioPlayHead::CurrentPositionInfo positionInfo;
+        if (playHead->getCurrentPosition (positionInfo))
+        {
+            transport.bpm = positionInfo.bpm;
+            transport.ppqPosition = positionInfo.ppqPosition;
+            transport.isPlaying = positionInfo.isPlaying;
+        }
     }
-    
+
+    return transport;
 }
 
 //==============================================================================
@@ -272,13 +352,7 @@ void TapePerformerAudioProcessor::loadFile()
      
             if (reader.get() != nullptr)
             {
-                mSampler.clearSounds();
-                mFormatReader = mFormatManager.createReaderFor(file);
-                thumbnail.setSource (new juce::FileInputSource (file));
-                
-                juce::BigInteger range;
-                range.setRange(0, 127, true);
-                mSampler.addSound(new GrainSound("Sample", *mFormatReader, range, midiNoteForNormalPitch, 0.0f, 0.01f, 180));
+                tapeLoader.loadFile (std::move (reader), file, loadSlot);
             }
         }
     });
@@ -287,19 +361,82 @@ void TapePerformerAudioProcessor::loadFile()
  
 void TapePerformerAudioProcessor::loadFile(const juce::String &path)
 {
-    mSampler.clearSounds();
     auto file = juce::File (path);
-    mFormatReader = mFormatManager.createReaderFor(file);
-    thumbnail.setSource (new juce::FileInputSource (file));
-    
-    juce::BigInteger range;
-    range.setRange(0, 127, true);
-    
-    mSampler.addSound(new GrainSound("Sample", *mFormatReader, range, midiNoteForNormalPitch, 0.0f, 0.01f, 180));
+
+    // the file is read in the background and goes into its slot once it's ready
+    tapeLoader.loadFile (file, loadSlot);
     
 //    wavePlayPosition = 0;
 }
 
+void TapePerformerAudioProcessor::loadFolder(const juce::String &path)
+{
+    tapeLoader.loadFolder (juce::File (path));
+}
+
+bool TapePerformerAudioProcessor::swapInResampledTake()
+{
+    auto take = engine.getFinishedTake();
+    if (take == nullptr)
+        return false;
+
+    engine.setTape(loadSlot, take);
+    setDisplayedTape (take, {});
+
+    return true;
+}
+
+void TapePerformerAudioProcessor::editorOpened()
+{
+    if (numOpenEditors++ == 0)
+    {
+        engine.setTelemetryEnabled(true);
+        requestPeaks();
+    }
+}
+
+void TapePerformerAudioProcessor::editorClosed()
+{
+    if (--numOpenEditors == 0)
+    {
+        // nobody is looking, so the waveform goes until the next editor opens
+        engine.setTelemetryEnabled(false);
+        peakAnalyser->cancel (this);
+        peaks = nullptr;
+    }
+}
+
+void TapePerformerAudioProcessor::setDisplayedTape(GrainTape::Ptr tape, const juce::File& file)
+{
+    // the waveform follows the last tape that was loaded
+    displayedTape = tape;
+    displayedFile = file;
+    peaks = nullptr;
+
+    requestPeaks();
+}
+
+void TapePerformerAudioProcessor::requestPeaks()
+{
+    if (numOpenEditors == 0 || displayedTape == nullptr || peaks != nullptr)
+        return;
+
+    peakAnalyser->request (this, displayedTape, displayedFile, [this] (GrainTape::Ptr tape, PeakPyramid::Ptr newPeaks)
+    {
+        if (tape == displayedTape && numOpenEditors > 0)
+            peaks = newPeaks;
+    });
+}
+
+void TapePerformerAudioProcessor::setBank(const TapeBank& bank)
+{
+    engine.setBank(bank);
+
+    if (auto* bankModeParam = apvts.getParameter("bankMode"))
+        bankModeParam->setValueNotifyingHost(1.0f);
+
+}
+
 //==============================================================================
 // This creates new instances of the plugin..
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
@@ -327,6 +464,8 @@ juce::AudioProcessorValueTreeState::ParameterLayout TapePerformerAudioProcessor:
 
     params.add(std::make_unique<juce::AudioParameterBool>("fourthFluxMode", "Fourth Flux Mode", false));
 
+    params.add(std::make_unique<juce::AudioParameterBool>("fifthFluxMode", "Fifth Flux Mode", false));
+
     params.add(std::make_unique<juce::AudioParameterFloat>("fluxModeRange", "Flux Mode Range", 0.0f, 1.0f, 0.5f));
 
     params.add(std::make_unique<juce::AudioParameterFloat>("position", "SamplePosition", juce::NormalisableRange<float>(0.f, 1.f, 0.001f, 1.f), 0.25f));
@@ -338,12 +477,58 @@ juce::AudioProcessorValueTreeState::ParameterLayout TapePerformerAudioProcessor:
     params.add(std::make_unique<juce::AudioParameterFloat>("gain", "Gain", 0.0f, 1.0f, 0.7f));
     
     params.add(std::make_unique<juce::AudioParameterFloat>("envShape", "Shape", juce::NormalisableRange<float>(0.f, 1.f, 0.001f, 1.f), 0.0f));
+
+    params.add(std::make_unique<juce::AudioParameterBool>("tempoSync", "Tempo Sync", false));
+
+    params.add(std::make_unique<juce::AudioParameterChoice>("syncDivision", "Sync Division", juce::StringArray("1/1", "1/2", "1/4", "1/8", "1/16", "1/32"), 4));
+
+    params.add(std::make_unique<juce::AudioParameterBool>("liveInput", "Live Input", false));
+
+    params.add(std::make_unique<juce::AudioParameterBool>("freeze", "Freeze", false));
+
+    params.add(std::make_unique<juce::AudioParameterBool>("overdub", "Overdub", false));
+
+    params.add(std::make_unique<juce::AudioParameterBool>("resample", "Resample", false));
+
+    params.add(std::make_unique<juce::AudioParameterFloat>("tapeSlot", "Tape Slot", juce::NormalisableRange<float>(0.f, (float) (GrainSound::numTapeSlots - 1), 0.001f, 1.f), 0.0f));
+
+    params.add(std::make_unique<juce::AudioParameterBool>("bankMode", "Bank Mode", false));
+
+    params.add(std::make_unique<juce::AudioParameterBool>("timeStretch", "Time Stretch", false));
+
+    params.add(std::make_unique<juce::AudioParameterChoice>("oversampling", "Oversampling", juce::StringArray("Off", "Up to 2x", "Up to 4x"), 0));
+
+    params.add(std::make_unique<juce::AudioParameterBool>("normalise", "Normalise", false));
+
+    params.add(std::make_unique<juce::AudioParameterFloat>("stretchSpeed", "Stretch Speed", juce::NormalisableRange<float>(-GrainParameters::maxStretchSpeed, GrainParameters::maxStretchSpeed, 0.001f, 1.f), 1.0f));
+
+    // the modulation matrix - the defaults match GrainParameters, with every route switched off
+    const GrainParameters defaults {};
+    const juce::NormalisableRange<float> rateRange (0.01f, 20.0f, 0.001f, 0.3f);
+
+    for (int i = 0; i < GrainParameters::numLfos; ++i)
+    {
+        auto number = juce::String (i + 1);
+
+        params.add(std::make_unique<juce::AudioParameterFloat>("lfo" + number + "Rate", "LFO " + number + " Rate", rateRange, defaults.lfoRates[(size_t) i]));
+
+        params.add(std::make_unique<juce::AudioParameterChoice>("lfo" + number + "Shape", "LFO " + number + " Shape", ModulationMatrix::getShapeNames(), defaults.lfoShapes[(size_t) i]));
+    }
+
+    params.add(std::make_unique<juce::AudioParameterFloat>("randomRate", "Random Rate", rateRange, defaults.randomRate));
+
+    for (int i = 0; i < GrainParameters::numModulationRoutes; ++i)
+    {
+        auto number = juce::String (i + 1);
+
+        params.add(std::make_unique<juce::AudioParameterChoice>("mod" + number + "Source", "Mod " + number + " Source", ModulationMatrix::getSourceNames(), 0));
+
+        params.add(std::make_unique<juce::AudioParameterChoice>("mod" + number + "Destination", "Mod " + number + " Destination", ModulationMatrix::getDestinationNames(), 0));
+
+        params.add(std::make_unique<juce::AudioParameterFloat>("mod" + number + "Amount", "Mod " + number + " Amount", juce::NormalisableRange<float>(-1.f, 1.f, 0.001f, 1.f), 0.0f));
+    }
         
     return params;
 
 }
 
-//this initializes a static variable of WavetableEnvelope - needs to be done in a cpp file
-//this enables to use one global parameter for every instance of WavetableEnvelope - as the shape should be the same for every voice and for EnvelopeDisplay too
-float WavetableEnvelope::envelopeShape{1};
-
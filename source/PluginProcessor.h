@@ -9,8 +9,9 @@
 #pragma once
 
 #include <JuceHeader.h>
-#include "Grain.h"
-#include "WavetableEnvelope.h"
+#include "TapeEngine.h"
+#include "TapeLoader.h"
+#include "PeakAnalyser.h"
 
 //==============================================================================
 /**
@@ -57,19 +58,37 @@ public:
     
     void loadFile();
     void loadFile (const juce::String& path);
+
+    /** Loads every tape in a folder as a key-zoned bank, see TapeBank. */
+    void loadFolder (const juce::String& path);
     
-    int getNumSamplerSounds() { return mSampler.getNumSounds(); }
+    int getNumSamplerSounds() { return engine.getSynthesiser().getNumSounds(); }
+    GrainSound* getTapeSound() { return engine.getTapeSound(); }
+
+    /** The slot that loadFile() and swapInResampledTake() put new tapes into. */
+    void setLoadSlot (int slot) { loadSlot = juce::jlimit (0, GrainSound::numTapeSlots - 1, slot); }
+    int getLoadSlot() const { return loadSlot; }
+
+    /** Puts the last resampled take into the load slot, returns false if there wasn't one. */
+    bool swapInResampledTake();
+    bool hasResampledTake() const { return engine.hasFinishedTake(); }
+
+    /** Only read this from the editor - the audio thread publishes into it once per block. */
+    GrainTelemetry& getTelemetry() { return engine.getTelemetry(); }
     
 
     
-    juce::AudioThumbnailCache thumbnailCache;
-    juce::AudioThumbnail thumbnail;
-    juce::Synthesiser mSampler;
+    /** The waveform of the tape that was loaded last, nullptr until its peaks are ready.
+        Peaks are only built while an editor is open. */
+    PeakPyramid::Ptr getPeaks() const { return peaks; }
 
-    const int mNumVoices { 6 };
-    int midiNoteForNormalPitch = 60;
+    /** Called by the editor - visualisation data only exists while at least one editor is open. */
+    void editorOpened();
+    void editorClosed();
+
+    /** Editors on screen get their waveform built before the ones that are hidden. */
+    void setEditorVisible (bool isVisible) { peakAnalyser->setVisible (this, isVisible); }
 
-    
     juce::AudioProcessorValueTreeState apvts;
     
     
@@ -80,15 +99,28 @@ private:
 
 
     juce::AudioFormatManager mFormatManager;
-    juce::AudioFormatReader* mFormatReader { nullptr };
-    
+
+    TapeEngine engine;
+    TapeLoader tapeLoader;
+    int loadSlot = 0;
+
+    GrainTape::Ptr displayedTape;
+    juce::File displayedFile;
+    PeakPyramid::Ptr peaks;
+    juce::SharedResourcePointer<PeakAnalyser> peakAnalyser;
+    int numOpenEditors = 0;
+
     std::unique_ptr<juce::FileChooser> chooser;
     
     
     juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+
+    void setBank (const TapeBank& bank);
+    GrainParameters getParameters() const;
+    TransportInfo getTransportInfo();
+    void setDisplayedTape (GrainTape::Ptr tape, const juce::File& file);
+    void requestPeaks();
     
-    float previousGain;
-     
     std::atomic<float>* modeParameter = nullptr;
     std::atomic<float>* availableKeysParameter  = nullptr;
     std::atomic<float>* fluxModeOnParameter  = nullptr;
@@ -96,6 +128,7 @@ private:
     std::atomic<float>* secondFluxParameter  = nullptr;
     std::atomic<float>* thirdFluxParameter  = nullptr;
     std::atomic<float>* fourthFluxParameter  = nullptr;
+    std::atomic<float>* fifthFluxParameter  = nullptr;
     std::atomic<float>* fluxModeRange  = nullptr;
     std::atomic<float>* positionParameter = nullptr;
     std::atomic<float>* durationParameter  = nullptr;
@@ -103,6 +136,31 @@ private:
     std::atomic<float>* gainParameter  = nullptr;
     std::atomic<float>* envelopeShapeParameter  = nullptr;
     std::atomic<float>* transposeParameter  = nullptr;
+    std::atomic<float>* tempoSyncParameter  = nullptr;
+    std::atomic<float>* syncDivisionParameter  = nullptr;
+    std::atomic<float>* liveInputParameter  = nullptr;
+    std::atomic<float>* freezeParameter  = nullptr;
+    std::atomic<float>* overdubParameter  = nullptr;
+    std::atomic<float>* resampleParameter  = nullptr;
+    std::atomic<float>* tapeSlotParameter  = nullptr;
+    std::atomic<float>* bankModeParameter  = nullptr;
+    std::atomic<float>* timeStretchParameter  = nullptr;
+    std::atomic<float>* stretchSpeedParameter  = nullptr;
+    std::atomic<float>* oversamplingParameter  = nullptr;
+    std::atomic<float>* normaliseParameter  = nullptr;
+    std::atomic<float>* randomRateParameter  = nullptr;
+
+    std::array<std::atomic<float>*, GrainParameters::numLfos> lfoRateParameters {};
+    std::array<std::atomic<float>*, GrainParameters::numLfos> lfoShapeParameters {};
+
+    struct ModulationRouteParameters
+    {
+        std::atomic<float>* source = nullptr;
+        std::atomic<float>* destination = nullptr;
+        std::atomic<float>* amount = nullptr;
+    };
+
+    std::array<ModulationRouteParameters, GrainParameters::numModulationRoutes> modulationRouteParameters {};
     
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TapePerformerAudioProcessor)
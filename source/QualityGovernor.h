@@ -0,0 +1,109 @@
+/*
+  ==============================================================================
+
+    QualityGovernor.h
+    Created: 24 Oct 2026 9:41:05am
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+//==============================================================================
+/**
+    Decides how much quality the engine can afford from how long its blocks take.
+
+    update() is called at the end of every block with the block's load - the
+    time it took as a fraction of its duration. When a block gets close to its
+    deadline the governor steps down a level: on stage a worse sound is fine, a
+    dropout isn't. It only steps back up after the load has stayed low for a
+    while, and one level at a time, so it doesn't flip between two levels.
+
+    What each level means is up to the engine, see TapeEngine::applyQuality().
+*/
+class QualityGovernor
+{
+public:
+    enum Level
+    {
+        full = 0,
+        cheaperInterpolation,       // no oversampling, and one interpolation step down
+        fewerVoices,                // fewer overlapping grains, the quietest voices fade out
+        quietVoicesCulled,          // fewer still, and voices that are barely audible get stopped
+        numLevels
+    };
+
+    QualityGovernor() {}
+
+    void prepare (double newSampleRate)
+    {
+        sampleRate = newSampleRate;
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        level = full;
+        samplesSinceStepDown = 0;
+        quietSamples = 0;
+    }
+
+    /** Off for offline rendering, which never has a deadline and has to come out the same every time. */
+    void setEnabled (bool shouldBeEnabled) noexcept
+    {
+        enabled = shouldBeEnabled;
+
+        if (! enabled)
+            reset();
+    }
+
+    bool isEnabled() const noexcept                 { return enabled; }
+    Level getLevel() const noexcept                 { return level; }
+
+    /** Returns true if the level has changed. */
+    bool update (float load, int numSamples) noexcept
+    {
+        if (! enabled || sampleRate <= 0.0)
+            return false;
+
+        samplesSinceStepDown += numSamples;
+
+        // a block that overran steps down straight away, otherwise the last step gets a moment to show its effect
+        const bool canStepDown = load > 1.0f || samplesSinceStepDown >= settleSeconds * sampleRate;
+
+        if (load > stepDownLoad && canStepDown && level < numLevels - 1)
+        {
+            level = (Level) (level + 1);
+            samplesSinceStepDown = 0;
+            quietSamples = 0;
+            return true;
+        }
+
+        quietSamples = load < stepUpLoad ? quietSamples + numSamples : 0;
+
+        if (level > full && quietSamples >= recoverySeconds * sampleRate)
+        {
+            level = (Level) (level - 1);
+            quietSamples = 0;
+            return true;
+        }
+
+        return false;
+    }
+
+    static constexpr float stepDownLoad = 0.75f;
+    static constexpr float stepUpLoad = 0.45f;
+    static constexpr double settleSeconds = 0.1;
+    static constexpr double recoverySeconds = 2.0;
+
+private:
+    double sampleRate = 0.0;
+    bool enabled = true;
+
+    Level level = full;
+    juce::int64 samplesSinceStepDown = 0;
+    juce::int64 quietSamples = 0;
+};
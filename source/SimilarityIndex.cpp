@@ -0,0 +1,333 @@
+/*
+  ==============================================================================
+
+    SimilarityIndex.cpp
+    Created: 26 Oct 2026 2:27:51pm
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#include "SimilarityIndex.h"
+#include "ParallelUnits.h"
+#include <complex>
+
+namespace
+{
+    constexpr int windowsPerUnit = 64;
+    constexpr float silenceLevel = 1.0e-8f;     // a mean square of -80 dB
+
+    //==============================================================================
+    // the tables every window's analysis shares - only read once they're built
+    struct FeatureAnalyser
+    {
+        static constexpr int size = SimilarityIndex::samplesPerWindow;
+        static constexpr int numBins = size / 2 + 1;
+
+        explicit FeatureAnalyser (double sampleRate)
+            : binWidth (sampleRate / size)
+        {
+            for (int i = 0; i < size; ++i)
+                window[(size_t) i] = (float) (0.5 - 0.5 * std::cos (juce::MathConstants<double>::twoPi * i / size));
+
+            for (int i = 0; i < size / 2; ++i)
+                twiddles[(size_t) i] = std::polar (1.0f, (float) (-juce::MathConstants<double>::twoPi * i / size));
+
+            for (int i = 0; i < size; ++i)
+            {
+                auto reversed = 0;
+                for (int bit = 0; bit < SimilarityIndex::fftOrder; ++bit)
+                    reversed |= ((i >> bit) & 1) << (SimilarityIndex::fftOrder - 1 - bit);
+
+                bitReversed[(size_t) i] = reversed;
+            }
+
+            // every bin between A1 and about D#8 counts towards its note's pitch class
+            for (int bin = 0; bin < numBins; ++bin)
+            {
+                auto frequency = bin * binWidth;
+                chromaClasses[(size_t) bin] = frequency >= 55.0 && frequency <= 5000.0
+                                                ? (juce::roundToInt (12.0 * std::log2 (frequency / 440.0)) + 69) % SimilarityIndex::numChroma
+                                                : -1;
+            }
+
+            // triangular bands evenly spaced on the mel scale, between 20 Hz and 8 kHz
+            auto toMel = [] (double hz)  { return 2595.0 * std::log10 (1.0 + hz / 700.0); };
+            auto toHz = [] (double mel)  { return 700.0 * (std::pow (10.0, mel / 2595.0) - 1.0); };
+
+            auto lowestMel = toMel (20.0);
+            auto highestMel = toMel (juce::jmin (8000.0, sampleRate / 2.0));
+            std::array<double, SimilarityIndex::numMelBands + 2> edges {};
+
+            for (size_t i = 0; i < edges.size(); ++i)
+                edges[i] = toHz (lowestMel + (highestMel - lowestMel) * (double) i / (double) (edges.size() - 1)) / binWidth;
+
+            for (int band = 0; band < SimilarityIndex::numMelBands; ++band)
+            {
+                auto& filter = melFilters[(size_t) band];
+                auto low = edges[(size_t) band], centre = edges[(size_t) band + 1], high = edges[(size_t) band + 2];
+
+                filter.firstBin = juce::jlimit (0, numBins - 1, (int) std::ceil (low));
+                auto endBin = juce::jlimit (filter.firstBin, numBins, (int) std::floor (high) + 1);
+
+                for (int bin = filter.firstBin; bin < endBin; ++bin)
+                    filter.weights.push_back ((float) (bin <= centre ? (bin - low) / juce::jmax (1.0e-9, centre - low)
+                                                                     : (high - bin) / juce::jmax (1.0e-9, high - centre)));
+            }
+
+            for (int k = 0; k < SimilarityIndex::numCoefficients; ++k)
+                for (int band = 0; band < SimilarityIndex::numMelBands; ++band)
+                    dct[(size_t) k][(size_t) band] = (float) std::cos (juce::MathConstants<double>::pi * (k + 1) * (band + 0.5) / SimilarityIndex::numMelBands);
+        }
+
+        /** Fills one window's descriptors, returns false if the window is silent. */
+        bool measure (const juce::AudioBuffer<float>& data, int length, int windowIndex,
+                      std::vector<std::complex<float>>& spectrum, std::vector<float>& power, float* features) const
+        {
+            const auto start = windowIndex * size;
+            const auto num = juce::jmin (size, length - start);
+            const auto numChannels = data.getNumChannels();
+
+            auto meanSquare = 0.0f;
+
+            for (int i = 0; i < size; ++i)
+            {
+                auto sample = 0.0f;
+
+                if (i < num)
+                    for (int channel = 0; channel < numChannels; ++channel)
+                        sample += data.getSample (channel, start + i);
+
+                sample /= (float) numChannels;
+                meanSquare += sample * sample;
+                spectrum[(size_t) bitReversed[(size_t) i]] = sample * window[(size_t) i];
+            }
+
+            if (meanSquare / (float) size < silenceLevel)
+                return false;
+
+            transform (spectrum);
+
+            for (int bin = 0; bin < numBins; ++bin)
+                power[(size_t) bin] = std::norm (spectrum[(size_t) bin]);
+
+            // centroid and flatness leave DC out
+            auto weightedSum = 0.0, magnitudeSum = 0.0, logSum = 0.0, powerSum = 0.0;
+
+            for (int bin = 1; bin < numBins; ++bin)
+            {
+                auto magnitude = std::sqrt ((double) power[(size_t) bin]);
+                weightedSum += magnitude * bin;
+                magnitudeSum += magnitude;
+                logSum += std::log (power[(size_t) bin] + 1.0e-12);
+                powerSum += power[(size_t) bin] + 1.0e-12;
+            }
+
+            features[0] = magnitudeSum > 0.0 ? (float) (weightedSum / magnitudeSum / (numBins - 1)) : 0.0f;
+            features[1] = (float) (std::exp (logSum / (numBins - 1)) / (powerSum / (numBins - 1)));
+
+            auto* chroma = features + 2;
+            std::fill (chroma, chroma + SimilarityIndex::numChroma, 0.0f);
+            auto chromaSum = 0.0f;
+
+            for (int bin = 0; bin < numBins; ++bin)
+            {
+                if (chromaClasses[(size_t) bin] >= 0)
+                {
+                    chroma[chromaClasses[(size_t) bin]] += power[(size_t) bin];
+                    chromaSum += power[(size_t) bin];
+                }
+            }
+
+            if (chromaSum > 0.0f)
+                for (int i = 0; i < SimilarityIndex::numChroma; ++i)
+                    chroma[i] /= chromaSum;
+
+            std::array<float, SimilarityIndex::numMelBands> logBands {};
+
+            for (int band = 0; band < SimilarityIndex::numMelBands; ++band)
+            {
+                auto& filter = melFilters[(size_t) band];
+                auto energy = 0.0f;
+
+                for (size_t i = 0; i < filter.weights.size(); ++i)
+                    energy += filter.weights[i] * power[(size_t) filter.firstBin + i];
+
+                logBands[(size_t) band] = std::log (energy + 1.0e-10f);
+            }
+
+            // the first coefficient is left out - it's the level, and the grains are compared by their sound
+            auto* coefficients = chroma + SimilarityIndex::numChroma;
+
+            for (int k = 0; k < SimilarityIndex::numCoefficients; ++k)
+            {
+                auto sum = 0.0f;
+                for (int band = 0; band < SimilarityIndex::numMelBands; ++band)
+                    sum += dct[(size_t) k][(size_t) band] * logBands[(size_t) band];
+
+                coefficients[k] = sum;
+            }
+
+            return true;
+        }
+
+        /** An in-place radix-2 FFT of data that's already in bit-reversed order. */
+        void transform (std::vector<std::complex<float>>& data) const noexcept
+        {
+            for (int half = 1; half < size; half *= 2)
+            {
+                auto step = size / (2 * half);
+
+                for (int start = 0; start < size; start += 2 * half)
+                {
+                    for (int k = 0; k < half; ++k)
+                    {
+                        auto& a = data[(size_t) (start + k)];
+                        auto& b = data[(size_t) (start + k + half)];
+                        auto t = twiddles[(size_t) (k * step)] * b;
+
+                        b = a - t;
+                        a += t;
+                    }
+                }
+            }
+        }
+
+        struct MelFilter
+        {
+            int firstBin = 0;
+            std::vector<float> weights;
+        };
+
+        double binWidth;
+        std::array<float, size> window {};
+        std::array<std::complex<float>, size / 2> twiddles {};
+        std::array<int, size> bitReversed {};
+        std::array<int, numBins> chromaClasses {};
+        std::array<MelFilter, SimilarityIndex::numMelBands> melFilters;
+        std::array<std::array<float, SimilarityIndex::numMelBands>, SimilarityIndex::numCoefficients> dct {};
+    };
+}
+
+void SimilarityIndex::build (const juce::AudioBuffer<float>& data, int length, double sampleRate, juce::ThreadPool* pool)
+{
+    numWindows = tapeLength = 0;
+    features.clear();
+    neighbours.clear();
+    silent.clear();
+
+    length = juce::jmin (length, data.getNumSamples());
+    if (length <= 0 || data.getNumChannels() <= 0 || sampleRate <= 0)
+        return;
+
+    const auto windows = (length + samplesPerWindow - 1) / samplesPerWindow;
+    const auto numUnits = (windows + windowsPerUnit - 1) / windowsPerUnit;
+
+    features.assign ((size_t) (windows * numFeatures), 0.0f);
+    silent.assign ((size_t) windows, 0);
+    neighbours.assign ((size_t) (windows * numNeighbours), 0);
+
+    auto analyser = std::make_unique<FeatureAnalyser> (sampleRate);
+
+    runInParallel (numUnits, pool, [&] (int unit)
+    {
+        std::vector<std::complex<float>> spectrum ((size_t) FeatureAnalyser::size);
+        std::vector<float> power ((size_t) FeatureAnalyser::numBins);
+
+        for (auto i = unit * windowsPerUnit; i < juce::jmin (windows, (unit + 1) * windowsPerUnit); ++i)
+            silent[(size_t) i] = analyser->measure (data, length, i, spectrum, power, features.data() + (size_t) i * numFeatures) ? 0 : 1;
+    });
+
+    numWindows = windows;
+    tapeLength = length;
+
+    scaleFeatures();
+
+    runInParallel (numUnits, pool, [this] (int unit)
+    {
+        findNeighbours (unit * windowsPerUnit, juce::jmin (numWindows, (unit + 1) * windowsPerUnit));
+    });
+}
+
+void SimilarityIndex::scaleFeatures()
+{
+    // every descriptor ends up with the same spread over the tape, and each of the four kinds weighs the same
+    // however many values it has
+    for (int feature = 0; feature < numFeatures; ++feature)
+    {
+        auto sum = 0.0, sumOfSquares = 0.0;
+        auto num = 0;
+
+        for (int i = 0; i < numWindows; ++i)
+        {
+            if (silent[(size_t) i] != 0)
+                continue;
+
+            auto value = (double) features[(size_t) (i * numFeatures + feature)];
+            sum += value;
+            sumOfSquares += value * value;
+            ++num;
+        }
+
+        auto mean = num > 0 ? sum / num : 0.0;
+        auto deviation = num > 0 ? std::sqrt (juce::jmax (0.0, sumOfSquares / num - mean * mean)) : 0.0;
+        auto groupSize = feature < 2 ? 1 : (feature < 2 + numChroma ? numChroma : numCoefficients);
+        auto scale = (deviation > 1.0e-9 ? 1.0 / deviation : 1.0) / std::sqrt ((double) groupSize);
+
+        for (int i = 0; i < numWindows; ++i)
+        {
+            auto& value = features[(size_t) (i * numFeatures + feature)];
+            value = (float) ((value - mean) * scale);
+        }
+    }
+}
+
+void SimilarityIndex::findNeighbours (int firstWindow, int endWindow)
+{
+    std::array<float, numNeighbours> distances;
+    std::array<int, numNeighbours> nearest;
+
+    for (auto window = firstWindow; window < endWindow; ++window)
+    {
+        distances.fill (std::numeric_limits<float>::max());
+        nearest.fill (-1);
+
+        auto* windowFeatures = getFeatures (window);
+        auto numFound = 0;
+
+        for (int other = 0; other < numWindows; ++other)
+        {
+            // the tape wraps around, so do the distances along it
+            auto apart = std::abs (other - window);
+            if (silent[(size_t) other] != 0 || juce::jmin (apart, numWindows - apart) <= excludedDistance)
+                continue;
+
+            auto* otherFeatures = getFeatures (other);
+            auto distance = 0.0f;
+
+            for (int i = 0; i < numFeatures; ++i)
+                distance += (windowFeatures[i] - otherFeatures[i]) * (windowFeatures[i] - otherFeatures[i]);
+
+            if (distance >= distances.back())
+                continue;
+
+            // a short sorted list, the new one moves in from the end
+            auto position = numNeighbours - 1;
+            for (; position > 0 && distances[(size_t) position - 1] > distance; --position)
+            {
+                distances[(size_t) position] = distances[(size_t) position - 1];
+                nearest[(size_t) position] = nearest[(size_t) position - 1];
+            }
+
+            distances[(size_t) position] = distance;
+            nearest[(size_t) position] = other;
+            numFound = juce::jmin (numFound + 1, (int) numNeighbours);
+        }
+
+        // a short tape might not have enough windows - the ones it has come round again, or the window itself
+        auto* row = neighbours.data() + (size_t) window * numNeighbours;
+
+        for (int rank = 0; rank < numNeighbours; ++rank)
+            row[rank] = numFound > 0 ? nearest[(size_t) (rank % numFound)] : window;
+    }
+}
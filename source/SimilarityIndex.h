@@ -0,0 +1,87 @@
+/*
+  ==============================================================================
+
+    SimilarityIndex.h
+    Created: 26 Oct 2026 2:27:51pm
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+//==============================================================================
+/**
+    Which parts of a tape sound alike, for the similarity flux mode.
+
+    build() cuts the tape into windows about a grain long and describes each
+    one by its spectrum: the centroid, the flatness, a 12-note chroma and 12
+    MFCCs, all in one flat array. Every window then gets a list of the windows
+    that sound most like it, nearest first - leaving out its direct
+    neighbours on the tape, which would only crawl along it.
+
+    All of that happens once when the tape is loaded, spread over a thread
+    pool, so the voices only ever read one entry of the list per grain.
+*/
+class SimilarityIndex
+{
+public:
+    SimilarityIndex() {}
+
+    /** Analyses length samples of data. Has to happen before the voices can see the index. */
+    void build (const juce::AudioBuffer<float>& data, int length, double sampleRate, juce::ThreadPool* pool);
+
+    bool isEmpty() const noexcept           { return numWindows == 0; }
+    int getNumWindows() const noexcept      { return numWindows; }
+
+    /** The window a phase (a fraction of the tape) falls into. */
+    int getWindow (double phase) const noexcept
+    {
+        return juce::jlimit (0, juce::jmax (0, numWindows - 1), (int) (phase * tapeLength / samplesPerWindow));
+    }
+
+    /** Where a window starts, as a fraction of the tape. */
+    double getPhase (int window) const noexcept
+    {
+        return tapeLength > 0 ? (double) window * samplesPerWindow / tapeLength : 0.0;
+    }
+
+    /** The rank-th most similar window to window, 0 is the nearest. */
+    int getNeighbour (int window, int rank) const noexcept
+    {
+        window = juce::jlimit (0, juce::jmax (0, numWindows - 1), window);
+        rank = juce::jlimit (0, numNeighbours - 1, rank);
+        return neighbours[(size_t) (window * numNeighbours + rank)];
+    }
+
+    /** The descriptors of one window, numFeatures of them, scaled so they can be compared directly. */
+    const float* getFeatures (int window) const noexcept    { return features.data() + (size_t) window * numFeatures; }
+
+    static constexpr int fftOrder = 11;
+    static constexpr int samplesPerWindow = 1 << fftOrder;
+
+    static constexpr int numChroma = 12;
+    static constexpr int numMelBands = 26;
+    static constexpr int numCoefficients = 12;
+    static constexpr int numFeatures = 2 + numChroma + numCoefficients;
+
+    static constexpr int numNeighbours = 16;
+
+    /** Windows this close on the tape are never each other's neighbours. */
+    static constexpr int excludedDistance = 2;
+
+private:
+    void scaleFeatures();
+    void findNeighbours (int firstWindow, int endWindow);
+
+    int numWindows = 0;
+    int tapeLength = 0;
+
+    std::vector<float> features;        // numFeatures per window
+    std::vector<int> neighbours;        // numNeighbours per window
+    std::vector<char> silent;           // silent windows are nobody's neighbour
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SimilarityIndex)
+};
@@ -0,0 +1,68 @@
+/*
+  ==============================================================================
+
+    TapeArena.h
+    Created: 20 Oct 2026 6:40:12pm
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+//==============================================================================
+/**
+    One block of memory that holds the channels of a whole bank of tapes.
+
+    Every region starts on a cache line, so the tapes sit next to each other in
+    memory instead of being spread over one allocation per channel. The tapes
+    that point into the arena keep it alive.
+*/
+class TapeArena : public juce::ReferenceCountedObject
+{
+public:
+    using Ptr = juce::ReferenceCountedObjectPtr<TapeArena>;
+
+    static constexpr size_t alignment = 64;
+
+    /** Lays out one region per entry, the sizes are in samples. */
+    explicit TapeArena (const std::vector<int>& regionSizes)
+    {
+        size_t totalBytes = 0;
+
+        for (auto size : regionSizes)
+        {
+            offsets.push_back (totalBytes);
+            totalBytes += alignedSize ((size_t) size * sizeof (float));
+        }
+
+        // not cleared - the readers fill every sample of a region, padding included
+        memory.allocate (totalBytes + alignment, false);
+
+        if (memory.get() != nullptr)
+        {
+            auto address = reinterpret_cast<juce::pointer_sized_uint> (memory.get());
+            base = memory.get() + (alignedSize ((size_t) address) - (size_t) address);
+            numBytes = totalBytes;
+        }
+    }
+
+    /** False if the allocation failed - none of the regions can be used then. */
+    bool isValid() const noexcept                       { return base != nullptr; }
+
+    int getNumRegions() const noexcept                  { return (int) offsets.size(); }
+    float* getRegion (int index) const noexcept         { return reinterpret_cast<float*> (base + offsets[(size_t) index]); }
+    size_t getSizeInBytes() const noexcept              { return numBytes; }
+
+private:
+    static size_t alignedSize (size_t bytes) noexcept   { return (bytes + alignment - 1) & ~(alignment - 1); }
+
+    juce::HeapBlock<char> memory;
+    char* base = nullptr;
+    std::vector<size_t> offsets;
+    size_t numBytes = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TapeArena)
+};
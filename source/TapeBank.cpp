@@ -0,0 +1,114 @@
+/*
+  ==============================================================================
+
+    TapeBank.cpp
+    Created: 20 Oct 2026 6:52:30pm
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#include "TapeBank.h"
+
+static juce::StringArray getNameTokens (const juce::String& fileName)
+{
+    juce::StringArray tokens;
+    tokens.addTokens (fileName, " _-.", "");
+    tokens.removeEmptyStrings();
+    return tokens;
+}
+
+int TapeBank::parseRootNote (const juce::String& fileName)
+{
+    static const juce::StringArray noteNames { "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B" };
+    static const juce::StringArray flatNames { "C", "Db", "D", "Eb", "E", "F", "Gb", "G", "Ab", "A", "Bb", "B" };
+
+    for (auto& token : getNameTokens (fileName))
+    {
+        // a bare number is more likely a track number than a note, so numbers need a root field, e.g. root64
+        auto lowerToken = token.toLowerCase();
+        auto prefix = lowerToken.startsWith ("root") || lowerToken.startsWith ("note") ? 4 : 0;
+        auto number = token.substring (prefix);
+
+        if (prefix > 0 && number.isNotEmpty() && number.containsOnly ("0123456789"))
+        {
+            if (number.getIntValue() <= 127)
+                return number.getIntValue();
+
+            continue;
+        }
+
+        // a note name followed by an octave, e.g. C3, F#2 or Bb0
+        auto octaveStart = token.indexOfAnyOf ("0123456789");
+        if (octaveStart <= 0 || ! token.substring (octaveStart).containsOnly ("0123456789"))
+            continue;
+
+        auto noteName = token.substring (0, octaveStart);
+        auto noteIndex = noteNames.indexOf (noteName, true);
+        if (noteIndex < 0)
+            noteIndex = flatNames.indexOf (noteName, true);
+
+        if (noteIndex >= 0)
+        {
+            auto note = (token.substring (octaveStart).getIntValue() + 2) * 12 + noteIndex;
+            if (juce::isPositiveAndNotGreaterThan (note, 127))
+                return note;
+        }
+    }
+
+    return -1;
+}
+
+int TapeBank::parseVelocityLayer (const juce::String& fileName)
+{
+    for (auto& token : getNameTokens (fileName))
+    {
+        auto lowerToken = token.toLowerCase();
+        auto prefix = lowerToken.startsWith ("vel") ? 3 : (lowerToken.startsWith ("v") ? 1 : 0);
+        auto number = lowerToken.substring (prefix);
+
+        if (prefix > 0 && number.isNotEmpty() && number.containsOnly ("0123456789"))
+            return number.getIntValue();
+    }
+
+    return 0;
+}
+
+void TapeBank::assignZones()
+{
+    auto nextNote = firstUnnamedNote;
+    for (auto& zone : zones)
+        if (zone.rootNote < 0)
+            zone.rootNote = juce::jmin (nextNote++, 127);
+
+    std::stable_sort (zones.begin(), zones.end(), [] (const Zone& a, const Zone& b)
+    {
+        return a.rootNote != b.rootNote ? a.rootNote < b.rootNote : a.velocityLayer < b.velocityLayer;
+    });
+
+    for (size_t first = 0; first < zones.size();)
+    {
+        auto root = zones[first].rootNote;
+
+        auto last = first;
+        while (last + 1 < zones.size() && zones[last + 1].rootNote == root)
+            ++last;
+
+        // the keys between two roots are split in the middle
+        auto lowestNote = first == 0 ? 0 : (zones[first - 1].rootNote + root) / 2 + 1;
+        auto highestNote = last + 1 == zones.size() ? 127 : (root + zones[last + 1].rootNote) / 2;
+
+        auto numLayers = (float) (last - first + 1);
+
+        for (auto i = first; i <= last; ++i)
+        {
+            auto& zone = zones[i];
+            zone.lowestNote = lowestNote;
+            zone.highestNote = highestNote;
+            zone.lowestVelocity = (float) (i - first) / numLayers;
+            zone.highestVelocity = (float) (i - first + 1) / numLayers;
+        }
+
+        first = last + 1;
+    }
+}
@@ -0,0 +1,52 @@
+/*
+  ==============================================================================
+
+    TapeBank.h
+    Created: 20 Oct 2026 6:52:30pm
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "GrainTape.h"
+
+//==============================================================================
+/**
+    A folder of tapes spread over the keyboard.
+
+    The root note and velocity layer of every tape come from its file name, e.g.
+    "Choir_C3_v2.wav" or "Bell root64.wav" - middle C is C3 like everywhere in JUCE.
+    A number on its own, like the 01 in "Track 01.wav", is never taken as a note.
+    Tapes without a note in their name get consecutive notes. Every root note
+    plays the keys up to halfway to its neighbours, and the tapes that share a
+    root note split the velocity range between them.
+*/
+struct TapeBank
+{
+    struct Zone
+    {
+        GrainTape::Ptr tape;
+        int rootNote = -1;
+        int velocityLayer = 0;
+
+        int lowestNote = 0, highestNote = 127;
+        float lowestVelocity = 0.0f, highestVelocity = 1.0f;
+    };
+
+    juce::String name;
+    std::vector<Zone> zones;
+
+    /** Works out the key and velocity ranges from the root notes and layers. */
+    void assignZones();
+
+    /** Returns the note name or the root field (root64 or note64) in a file name, or -1 if there is none. */
+    static int parseRootNote (const juce::String& fileName);
+
+    /** Returns the layer in a file name like "v2" or "vel2", or 0 if there is none. */
+    static int parseVelocityLayer (const juce::String& fileName);
+
+    static constexpr int firstUnnamedNote = 36;
+};
@@ -0,0 +1,425 @@
+/*
+  ==============================================================================
+
+    TapeEngine.cpp
+    Created: 21 Oct 2026 9:52:38am
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#include "TapeEngine.h"
+#include "TraceZones.h"
+
+TapeEngine::TapeEngine (int numVoices)
+{
+    for (int i = 0; i < numVoices; ++i)
+    {
+        auto voice = new GrainVoice();
+        synth.addVoice (voice);
+        grainVoices.push_back (voice);
+    }
+
+    // the tape slots all live in one sound, so switching tapes never has to remove it
+    juce::BigInteger range;
+    range.setRange (0, 127, true);
+    tapeSound = new GrainSound ("Tapes", range, midiNoteForNormalPitch, 0.0f, 0.01f);
+    synth.addSound (tapeSound.get());
+}
+
+TapeEngine::~TapeEngine()
+{
+    outputRecorder.release();
+}
+
+void TapeEngine::prepare (double sampleRate, int maxBlockSize)
+{
+    synth.setCurrentPlaybackSampleRate (sampleRate);
+    grainClock.prepare (sampleRate);
+    governor.prepare (sampleRate);
+    modulation.prepare (sampleRate);
+    currentSampleRate = sampleRate;
+
+    // a block bigger than this plays without oversampling
+    oversampler.prepare (2, maxBlockSize);
+    samplesBelowFactor = 0;
+    setVoiceOversampling (1);
+
+    // the live tape is allocated here once - recording never resizes it
+    if (liveSound != nullptr)
+    {
+        for (int i = synth.getNumSounds(); --i >= 0;)
+            if (synth.getSound (i).get() == liveSound.get())
+                synth.removeSound (i);
+    }
+
+    liveTape.prepare (sampleRate, 2, liveTapeLengthSeconds);
+
+    juce::BigInteger range;
+    range.setRange (0, 127, true);
+    liveSound = new GrainSound ("Live", range, midiNoteForNormalPitch, 0.0f, 0.01f);
+    liveSound->setTape (0, liveTape.createTape());
+    synth.addSound (liveSound.get());
+
+    outputRecorder.prepare (sampleRate, 2, resampleLengthSeconds);
+    wasResampling = false;
+
+    isFirstBlock = true;
+
+    lastBlockLoad = 0.0f;
+    windowPeakLoad = peakBlockLoad = grainsPerSecond = 0.0f;
+    windowNumSamples = windowNumGrains = numOverruns = 0;
+}
+
+void TapeEngine::release()
+{
+    outputRecorder.release();
+}
+
+void TapeEngine::process (juce::AudioBuffer<float>& output,
+                          const juce::AudioBuffer<float>* liveInput,
+                          juce::MidiBuffer& midi,
+                          const GrainParameters& params,
+                          const TransportInfo& transport)
+{
+    TP_TRACE_ZONE ("TapeEngine::process");
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+    const auto numSamples = output.getNumSamples();
+
+    // the follower hears the sidechain whether it's being recorded or not
+    if (liveInput != nullptr)
+        modulation.measureInput (*liveInput, numSamples);
+
+    // record the live input first - the buffer is cleared afterwards so the input doesn't leak into the output
+    if (params.liveInput && liveInput != nullptr && liveInput->getNumChannels() > 0 && ! params.freeze)
+        liveTape.write (*liveInput, numSamples, params.overdub);
+
+    output.clear();
+
+    grainClock.update (params.tempoSync, transport.bpm, transport.ppqPosition, transport.isPlaying, numSamples,
+                       GrainClock::getBeatsForDivision (params.syncDivision));
+
+    if (liveSound != nullptr)
+        liveSound->setPositionOffset ((double) liveTape.getWritePosition() / liveTape.getLength());
+
+    // from here on the voices and the output gain see the modulated values
+    auto modulatedParams = params;
+    modulation.process (modulatedParams, numSamples);
+
+    updateSounds (modulatedParams);
+    applyQuality();
+
+    {
+        TP_TRACE_ZONE ("Synthesiser::renderNextBlock");
+        midiIngest.process (midi, numSamples);
+        synth.handleEvents (midiIngest);
+        renderVoices (output, modulatedParams, numSamples);
+    }
+
+    if (telemetryEnabled)
+        publishTelemetry();
+
+    //Smooth Gain Multiplication with Ramp
+    if (isFirstBlock)
+    {
+        previousGain = modulatedParams.gain;
+        isFirstBlock = false;
+    }
+
+    if (modulatedParams.gain == previousGain)
+    {
+        output.applyGain (modulatedParams.gain);
+    }
+    else
+    {
+        output.applyGainRamp (0, numSamples, previousGain, modulatedParams.gain);
+        previousGain = modulatedParams.gain;
+    }
+
+    // capture the final output so it can be played back as a tape
+    if (params.resample)
+        outputRecorder.push (output, numSamples);
+    else if (wasResampling)
+        outputRecorder.finishTake();
+
+    wasResampling = params.resample;
+
+    updateLoad (startTicks, numSamples);
+}
+
+void TapeEngine::updateSounds (const GrainParameters& params)
+{
+    TP_TRACE_ZONE ("GrainSound::updateParams");
+    const auto fluxMode = params.getActiveFluxMode();
+
+    // a new bank replaces its sounds under this lock
+    const juce::ScopedLock sl (synth.getLock());
+    const bool bankMode = params.bankMode && ! bankSounds.isEmpty();
+
+    for (int i = 0; i < synth.getNumSounds(); ++i)
+    {
+        auto sound = dynamic_cast<GrainSound*> (synth.getSound (i).get());
+        if (sound == nullptr)
+            continue;
+
+        sound->updateParams (params.playMode, params.numKeys, params.position, params.duration, params.spread, fluxMode, params.transpose, params.fluxModeRange);
+        sound->setGrainClock (&grainClock);
+        sound->setEnvelopeShape (params.envelopeShape);
+        sound->setNoteModulation (modulation.getVelocityModulation(), modulation.getKeyModulation());
+        sound->setTimeStretch (params.timeStretch, params.stretchSpeed);
+        sound->setNormalise (params.normalise);
+
+        // live input wins over the bank, the bank over the tape slots
+        const bool isBankSound = sound != liveSound.get() && sound != tapeSound.get();
+        if (params.liveInput)
+            sound->setActive (sound == liveSound.get());
+        else
+            sound->setActive (bankMode ? isBankSound : sound == tapeSound.get());
+
+        if (sound == tapeSound.get())
+            sound->setTapeCrossfade (params.tapeSlot);
+    }
+}
+
+void TapeEngine::publishTelemetry()
+{
+    auto& snapshot = telemetry.getSnapshotToWrite();
+    snapshot.numGrains = 0;
+
+    for (auto voice : grainVoices)
+    {
+        if (! voice->isVoiceActive() || snapshot.numGrains >= GrainSnapshot::maxGrains)
+            continue;
+
+        snapshot.grains[(size_t) snapshot.numGrains++] = voice->getGrainState();
+    }
+
+    // these are from the block before, this one's still being measured
+    snapshot.blockLoad = lastBlockLoad;
+    snapshot.peakBlockLoad = peakBlockLoad;
+    snapshot.grainsPerSecond = grainsPerSecond;
+    snapshot.numOverruns = numOverruns;
+    snapshot.qualityLevel = (int) governor.getLevel();
+    snapshot.oversampling = oversamplingFactor;
+
+    telemetry.publish();
+}
+
+void TapeEngine::updateLoad (juce::int64 startTicks, int numSamples)
+{
+    if (numSamples <= 0)
+        return;
+
+    auto seconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+    auto load = (float) (seconds * currentSampleRate / numSamples);
+
+    lastBlockLoad = load;
+
+    if (load > 1.0f)
+        ++numOverruns;
+
+    governor.update (load, numSamples);
+
+    for (auto voice : grainVoices)
+        windowNumGrains += voice->takeNumGrainsStarted();
+
+    windowPeakLoad = juce::jmax (windowPeakLoad, load);
+    windowNumSamples += numSamples;
+
+    if (windowNumSamples >= currentSampleRate * loadWindowSeconds)
+    {
+        peakBlockLoad = windowPeakLoad;
+        grainsPerSecond = (float) (windowNumGrains * currentSampleRate / windowNumSamples);
+
+        windowPeakLoad = 0.0f;
+        windowNumSamples = windowNumGrains = 0;
+    }
+}
+
+void TapeEngine::applyQuality()
+{
+    // a bounce has all the time it needs, so its load says nothing about the deadline
+    governor.setEnabled (adaptiveQuality && ! nonRealtime);
+    const auto level = governor.getLevel();
+
+    // offline gets Hermite, live gets linear, and one step below that when the governor says so
+    auto interpolation = nonRealtime ? GrainVoice::Interpolation::hermite : GrainVoice::Interpolation::linear;
+
+    if (level >= QualityGovernor::cheaperInterpolation)
+        interpolation = (GrainVoice::Interpolation) juce::jmax (0, (int) interpolation - 1);
+
+    if (interpolation != voiceInterpolation)
+    {
+        voiceInterpolation = interpolation;
+
+        for (auto voice : grainVoices)
+            voice->setInterpolation (voiceInterpolation);
+    }
+
+    const auto numVoices = (int) grainVoices.size();
+    const auto maxActiveVoices = level >= QualityGovernor::quietVoicesCulled ? juce::jmax (1, numVoices / 2)
+                               : level >= QualityGovernor::fewerVoices       ? juce::jmax (1, (numVoices * 2) / 3)
+                                                                             : numVoices;
+
+    const juce::ScopedLock sl (synth.getLock());
+
+    // the budget is only worth keeping to when there's a deadline, like the governor
+    synth.setMaxActiveVoices (maxActiveVoices);
+    synth.setVoiceBudget (governor.isEnabled() ? voiceBudget.load() : 0.0f);
+    synth.fadeOutVoicesOverLimits();
+
+    if (level < QualityGovernor::quietVoicesCulled)
+        return;
+
+    for (auto voice : grainVoices)
+        if (voice->isVoiceActive() && voice->isKeyDown() && voice->getEnvelopeLevel() < cullLevel)
+            voice->fadeOut();
+}
+
+void TapeEngine::renderVoices (juce::AudioBuffer<float>& output, const GrainParameters& params, int numSamples)
+{
+    // every block goes through the oversampler, even with the oversampling off - it then only delays the voices,
+    // so the latency the plugin reports stays the same whatever the parameter does
+
+    // the notes that start in this block already have their voices, so their pitch counts too
+    auto factor = chooseOversampling (params, output.getNumChannels(), numSamples);
+
+    if (factor != oversamplingFactor)
+        setVoiceOversampling (factor);
+
+    if (factor == 1)
+        synth.renderVoices (output, numSamples);
+    else
+        synth.renderVoices (oversampler.getBuffer (factor, output.getNumChannels(), numSamples), numSamples * factor);
+
+    oversampler.process (output, factor, numSamples);
+}
+
+int TapeEngine::chooseOversampling (const GrainParameters& params, int numChannels, int numSamples)
+{
+    // a bounce always gets the most the oversampler can do, whatever the notes and the parameter say
+    if (nonRealtime)
+    {
+        auto factor = Oversampler::maxFactor;
+
+        while (factor > 1 && ! oversampler.canProcess (factor, numChannels, numSamples))
+            factor /= 2;
+
+        samplesBelowFactor = 0;
+        return factor;
+    }
+
+    // the governor takes the oversampling away before anything else
+    auto maxFactor = params.oversampling >= 2 ? 4
+                   : params.oversampling == 1 ? 2
+                                              : 1;
+
+    if (governor.getLevel() > QualityGovernor::full)
+        maxFactor = 1;
+
+    auto highestRatio = 0.0;
+
+    for (auto voice : grainVoices)
+        if (voice->isVoiceActive())
+            highestRatio = juce::jmax (highestRatio, voice->getPlaybackRatio());
+
+    auto factor = highestRatio > fourTimesRatio ? 4
+                : highestRatio > twoTimesRatio  ? 2
+                                                : 1;
+
+    factor = juce::jmin (factor, maxFactor);
+
+    while (factor > 1 && ! oversampler.canProcess (factor, numChannels, numSamples))
+        factor /= 2;
+
+    // going up happens straight away, going down only once the lower factor has been enough for a while -
+    // unless the current one isn't allowed anymore
+    const bool mustChange = oversamplingFactor > maxFactor || ! oversampler.canProcess (oversamplingFactor, numChannels, numSamples);
+
+    if (factor >= oversamplingFactor || mustChange)
+    {
+        samplesBelowFactor = 0;
+        return factor;
+    }
+
+    samplesBelowFactor += numSamples;
+
+    if (samplesBelowFactor < oversamplingHoldSeconds * currentSampleRate)
+        return oversamplingFactor;
+
+    samplesBelowFactor = 0;
+    return factor;
+}
+
+void TapeEngine::setVoiceOversampling (int factor)
+{
+    const juce::ScopedLock sl (synth.getLock());
+
+    oversamplingFactor = factor;
+
+    for (auto voice : grainVoices)
+        voice->setOversampling (factor, currentSampleRate);
+}
+
+void TapeEngine::setRandomSeed (juce::int64 seed)
+{
+    // every voice gets its own sequence, but the same ones for the same seed
+    for (size_t i = 0; i < grainVoices.size(); ++i)
+        grainVoices[i]->setRandomSeed (seed + (juce::int64) i);
+
+    modulation.setRandomSeed (seed);
+}
+
+void TapeEngine::setTape (int slot, GrainTape::Ptr newTape)
+{
+    GrainTape::Ptr oldTape;
+
+    // only swaps a pointer while holding the lock - the voices pick the new tape up on their next block
+    {
+        const juce::ScopedLock sl (synth.getLock());
+        oldTape = tapeSound->setTape (slot, newTape);
+    }
+
+    // oldTape gets freed here, outside the lock
+}
+
+void TapeEngine::setBank (const TapeBank& bank)
+{
+    juce::ReferenceCountedArray<GrainSound> newSounds;
+
+    for (auto& zone : bank.zones)
+    {
+        juce::BigInteger zoneNotes;
+        zoneNotes.setRange (zone.lowestNote, zone.highestNote - zone.lowestNote + 1, true);
+
+        auto sound = new GrainSound (zone.tape->getName(), zoneNotes, zone.rootNote, 0.0f, 0.01f);
+        sound->setVelocityRange (zone.lowestVelocity, zone.highestVelocity);
+        sound->setTape (0, zone.tape);
+        newSounds.add (sound);
+    }
+
+    auto oldSounds = bankSounds;
+
+    {
+        const juce::ScopedLock sl (synth.getLock());
+
+        // voices let go of the old sounds here, so none of them gets deleted on the audio thread
+        for (int i = 0; i < synth.getNumVoices(); ++i)
+        {
+            auto voice = synth.getVoice (i);
+            if (oldSounds.contains (dynamic_cast<GrainSound*> (voice->getCurrentlyPlayingSound().get())))
+                voice->stopNote (0.0f, false);
+        }
+
+        for (int i = synth.getNumSounds(); --i >= 0;)
+            if (oldSounds.contains (dynamic_cast<GrainSound*> (synth.getSound (i).get())))
+                synth.removeSound (i);
+
+        for (auto sound : newSounds)
+            synth.addSound (sound);
+
+        bankSounds = newSounds;
+    }
+
+    // the old sounds and the arena behind their tapes get freed here, outside the lock
+}
@@ -0,0 +1,175 @@
+/*
+  ==============================================================================
+
+    TapeEngine.h
+    Created: 21 Oct 2026 9:52:38am
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include "Grain.h"
+#include "GrainSynthesiser.h"
+#include "GrainParameters.h"
+#include "GrainClock.h"
+#include "GrainTelemetry.h"
+#include "LiveTape.h"
+#include "MidiIngest.h"
+#include "ModulationMatrix.h"
+#include "OutputRecorder.h"
+#include "Oversampler.h"
+#include "QualityGovernor.h"
+#include "TapeBank.h"
+#include "WavetableEnvelope.h"
+
+//==============================================================================
+/**
+    Everything that makes sound, without any plugin or GUI code around it.
+
+    The plugin's processor owns one of these and feeds it the parameter values
+    every block, and the benchmark and offline tools drive it the same way. The
+    engine never reads an AudioProcessorValueTreeState or talks to a host.
+
+    process() is called on the audio thread, setTape(), setBank() and
+    getFinishedTake() on the message thread (or whichever thread the owner
+    loads tapes on).
+*/
+class TapeEngine
+{
+public:
+    TapeEngine (int numVoices = defaultNumVoices);
+    ~TapeEngine();
+
+    void prepare (double sampleRate, int maxBlockSize);
+    void release();
+
+    /** Renders one block into output.
+
+        The live input is written to the live tape before output gets cleared, so
+        liveInput may refer to the same channels as output (as a plugin's input
+        bus does). Pass nullptr when there is no live input.
+    */
+    void process (juce::AudioBuffer<float>& output,
+                  const juce::AudioBuffer<float>* liveInput,
+                  juce::MidiBuffer& midi,
+                  const GrainParameters& params,
+                  const TransportInfo& transport);
+
+    /** The output is always this late against the notes - the oversampler's delay, which it keeps up
+        even when the oversampling is off, as a plain delay line. A fixed latency is what lets the factor
+        follow the notes without moving them or making the host line the plugin up again. The plugin
+        reports it to the host. */
+    static int getLatencySamples() noexcept         { return Oversampler::getLatencySamples(); }
+
+    /** Puts a tape into one of the tape slots, the old one is released on the calling thread. */
+    void setTape (int slot, GrainTape::Ptr newTape);
+
+    /** Replaces the current bank's sounds with a sound per zone. */
+    void setBank (const TapeBank& bank);
+    bool hasBank() const                            { return ! bankSounds.isEmpty(); }
+
+    /** The last resampled take, nullptr if there isn't one. */
+    GrainTape::Ptr getFinishedTake()                { return outputRecorder.getFinishedTake(); }
+    bool hasFinishedTake() const                    { return outputRecorder.hasFinishedTake(); }
+
+    /** Offline rendering gets the best quality the voices have - Hermite interpolation and the oversampler's
+        highest factor, whatever the oversampling parameter says. Can be called from any thread, the voices
+        pick it up on the next block. */
+    void setNonRealtime (bool isNonRealtime) noexcept   { nonRealtime = isNonRealtime; }
+
+    /** Lets the engine trade quality for time when its blocks get close to their deadline, see QualityGovernor.
+        On by default - turn it off for renders that have to come out the same every time.
+        Non-realtime blocks are never degraded either way. */
+    void setAdaptiveQuality (bool shouldAdapt) noexcept     { adaptiveQuality = shouldAdapt; }
+    QualityGovernor::Level getQualityLevel() const noexcept { return governor.getLevel(); }
+
+    /** The fraction of each block's time the voices may take together, before new notes steal voices
+        instead of adding one. Only applies while the quality adapts, see setAdaptiveQuality(). */
+    void setVoiceBudget (float newVoiceBudget) noexcept     { voiceBudget = newVoiceBudget; }
+
+    /** Makes the random flux mode and the random modulation sources repeatable - call this before rendering, not while the audio thread is running. */
+    void setRandomSeed (juce::int64 seed);
+
+    GrainSound* getTapeSound()                      { return tapeSound.get(); }
+    GrainSynthesiser& getSynthesiser()              { return synth; }
+
+    /** Only read this from the editor - process() publishes into it once per block while it's enabled. */
+    GrainTelemetry& getTelemetry()                  { return telemetry; }
+    void setTelemetryEnabled (bool shouldBeEnabled) { telemetryEnabled = shouldBeEnabled; }
+
+    /** How long the last block took to process, as a fraction of the block's duration. */
+    float getLastBlockLoad() const noexcept         { return lastBlockLoad; }
+
+    static constexpr int defaultNumVoices = 16;
+    static constexpr float defaultVoiceBudget = 0.6f;
+    static constexpr int midiNoteForNormalPitch = 60;
+    static constexpr double liveTapeLengthSeconds = 30.0;
+    static constexpr double resampleLengthSeconds = 60.0;
+    static constexpr double loadWindowSeconds = 0.5;
+
+    /** Voices quieter than this get stopped at QualityGovernor::quietVoicesCulled. */
+    static constexpr float cullLevel = 0.03f;
+
+    /** The playback ratios above which the voices render at 2x and 4x, see GrainVoice::getPlaybackRatio().
+        A little aliasing from a few semitones up is cheaper to live with than doubling every voice's work. */
+    static constexpr double twoTimesRatio = 1.5;
+    static constexpr double fourTimesRatio = 3.0;
+
+    /** How long the notes have to get by with a lower factor before the oversampling goes down. */
+    static constexpr double oversamplingHoldSeconds = 0.5;
+
+private:
+    void updateSounds (const GrainParameters& params);
+    void publishTelemetry();
+    void updateLoad (juce::int64 startTicks, int numSamples);
+    void applyQuality();
+    void renderVoices (juce::AudioBuffer<float>& output, const GrainParameters& params, int numSamples);
+    int chooseOversampling (const GrainParameters& params, int numChannels, int numSamples);
+    void setVoiceOversampling (int factor);
+
+    GrainSynthesiser synth;
+    MidiIngest midiIngest;
+    ModulationMatrix modulation;
+    std::vector<GrainVoice*> grainVoices;
+
+    juce::ReferenceCountedObjectPtr<GrainSound> tapeSound;
+    juce::ReferenceCountedArray<GrainSound> bankSounds;
+
+    LiveTape liveTape;
+    juce::ReferenceCountedObjectPtr<GrainSound> liveSound;
+
+    GrainClock grainClock;
+
+    GrainTelemetry telemetry;
+    std::atomic<bool> telemetryEnabled { false };
+
+    OutputRecorder outputRecorder;
+    bool wasResampling = false;
+
+    float previousGain = 0.0f;
+    bool isFirstBlock = true;
+
+    std::atomic<bool> nonRealtime { false };
+    std::atomic<bool> adaptiveQuality { true };
+    std::atomic<float> voiceBudget { defaultVoiceBudget };
+
+    QualityGovernor governor;
+
+    Oversampler oversampler;
+    int oversamplingFactor = 1;
+    juce::int64 samplesBelowFactor = 0;
+    GrainVoice::Interpolation voiceInterpolation = GrainVoice::Interpolation::linear;
+
+    // measured at the end of every block, the window values are what the telemetry shows
+    double currentSampleRate = 44100.0;
+    std::atomic<float> lastBlockLoad { 0.0f };
+    float windowPeakLoad = 0, peakBlockLoad = 0;
+    int windowNumSamples = 0, windowNumGrains = 0;
+    float grainsPerSecond = 0;
+    int numOverruns = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TapeEngine)
+};
@@ -0,0 +1,181 @@
+/*
+  ==============================================================================
+
+    TapeLoader.cpp
+    Created: 20 Oct 2026 3:15:44pm
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#include "TapeLoader.h"
+#include "TraceZones.h"
+
+TapeLoader::TapeLoader()
+{
+    formatManager.registerBasicFormats();
+}
+
+TapeLoader::~TapeLoader()
+{
+    cancelPendingUpdate();
+    pool.removeAllJobs (true, 10000);
+}
+
+void TapeLoader::loadFile (const juce::File& file, int slot)
+{
+    pool.addJob ([this, file, slot]
+    {
+        TP_TRACE_ZONE ("TapeLoader::loadFile");
+        std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (file));
+
+        if (reader != nullptr)
+            readTape (*reader, file, slot);
+    });
+}
+
+void TapeLoader::loadFile (std::unique_ptr<juce::AudioFormatReader> reader, const juce::File& file, int slot)
+{
+    if (reader == nullptr)
+        return;
+
+    // the pool's jobs have to be copyable
+    std::shared_ptr<juce::AudioFormatReader> sharedReader (std::move (reader));
+
+    pool.addJob ([this, sharedReader, file, slot]
+    {
+        TP_TRACE_ZONE ("TapeLoader::loadFile");
+        readTape (*sharedReader, file, slot);
+    });
+}
+
+void TapeLoader::readTape (juce::AudioFormatReader& reader, const juce::File& file, int slot)
+{
+    if (auto tape = GrainTape::createFromReader (file.getFileNameWithoutExtension(), reader, maxTapeLengthSeconds))
+    {
+        tape->analyse (&pool);
+
+        {
+            const juce::ScopedLock sl (lock);
+            loadedTapes.push_back ({ slot, tape, file });
+        }
+
+        triggerAsyncUpdate();
+    }
+}
+
+void TapeLoader::loadFolder (const juce::File& folder)
+{
+    pool.addJob ([this, folder]
+    {
+        TP_TRACE_ZONE ("TapeLoader::loadFolder");
+        auto files = folder.findChildFiles (juce::File::findFiles, false, formatManager.getWildcardForAllFormats());
+        files.sort();
+
+        auto load = std::make_shared<BankLoad>();
+        load->bank.name = folder.getFileName();
+
+        // the headers are read first so the whole bank fits into one allocation
+        struct Header
+        {
+            juce::String name;
+            int numChannels, length;
+            double sampleRate;
+        };
+
+        std::vector<Header> headers;
+        std::vector<int> regionSizes;
+
+        for (auto& file : files)
+        {
+            std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (file));
+
+            if (reader == nullptr || reader->sampleRate <= 0 || reader->lengthInSamples <= 0)
+                continue;
+
+            Header header { file.getFileNameWithoutExtension(),
+                            juce::jmin (2, (int) reader->numChannels),
+                            juce::jmin ((int) reader->lengthInSamples, (int) (maxBankTapeLengthSeconds * reader->sampleRate)),
+                            reader->sampleRate };
+
+            for (int channel = 0; channel < header.numChannels; ++channel)
+                regionSizes.push_back (header.length + GrainTape::padding);
+
+            headers.push_back (header);
+            load->readers.push_back (std::move (reader));
+        }
+
+        if (headers.empty())
+            return;
+
+        TapeArena::Ptr arena = new TapeArena (regionSizes);
+        if (! arena->isValid())
+            return;
+
+        int region = 0;
+        for (auto& header : headers)
+        {
+            TapeBank::Zone zone;
+            zone.tape = new GrainTape (header.name, arena, region, header.numChannels, header.length, header.sampleRate);
+            zone.rootNote = TapeBank::parseRootNote (header.name);
+            zone.velocityLayer = TapeBank::parseVelocityLayer (header.name);
+
+            load->bank.zones.push_back (zone);
+            region += header.numChannels;
+        }
+
+        load->numPending = (int) load->readers.size();
+
+        for (size_t i = 0; i < load->readers.size(); ++i)
+            pool.addJob ([this, load, i] { readBankTape (*load, i); });
+    });
+}
+
+void TapeLoader::readBankTape (BankLoad& load, size_t index)
+{
+    TP_TRACE_ZONE ("TapeLoader::readBankTape");
+    auto& tape = *load.bank.zones[index].tape;
+    auto& data = tape.getData();
+
+    // the tape only refers to its arena regions, so this reads straight into the arena
+    juce::AudioBuffer<float> destination (const_cast<float* const*> (data.getArrayOfReadPointers()),
+                                          data.getNumChannels(), data.getNumSamples());
+
+    load.readers[index]->read (&destination, 0, data.getNumSamples(), 0, true, true);
+    load.readers[index].reset();
+
+    // the other tapes are being read on the other threads already
+    tape.analyse (nullptr);
+
+    if (--load.numPending == 0)
+    {
+        load.bank.assignZones();
+
+        {
+            const juce::ScopedLock sl (lock);
+            loadedBanks.push_back (std::move (load.bank));
+        }
+
+        triggerAsyncUpdate();
+    }
+}
+
+void TapeLoader::handleAsyncUpdate()
+{
+    std::vector<LoadedTape> finished;
+    std::vector<TapeBank> finishedBanks;
+
+    {
+        const juce::ScopedLock sl (lock);
+        std::swap (finished, loadedTapes);
+        std::swap (finishedBanks, loadedBanks);
+    }
+
+    for (auto& loaded : finished)
+        if (onTapeLoaded != nullptr)
+            onTapeLoaded (loaded.slot, loaded.tape, loaded.file);
+
+    for (auto& bank : finishedBanks)
+        if (onBankLoaded != nullptr)
+            onBankLoaded (bank);
+}
@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+    TapeLoader.h
+    Created: 20 Oct 2026 3:15:44pm
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_events/juce_events.h>
+#include "GrainTape.h"
+#include "TapeBank.h"
+
+//==============================================================================
+/**
+    Reads tapes on a background thread so loading never blocks the audio or the
+    editor. Finished tapes are handed to onTapeLoaded on the message thread.
+
+    A folder is loaded as a bank: its files get read in parallel, straight into
+    one TapeArena, and the bank is handed to onBankLoaded once all of them are in.
+
+    Every tape gets analysed here too, before anything can play it - see
+    GrainTape::analyse().
+*/
+class TapeLoader : private juce::AsyncUpdater
+{
+public:
+    TapeLoader();
+    ~TapeLoader() override;
+
+    void loadFile (const juce::File& file, int slot);
+
+    /** Loads from a reader the caller has opened already, so the file doesn't get opened twice. */
+    void loadFile (std::unique_ptr<juce::AudioFormatReader> reader, const juce::File& file, int slot);
+    void loadFolder (const juce::File& folder);
+
+    std::function<void (int slot, GrainTape::Ptr tape, const juce::File& file)> onTapeLoaded;
+    std::function<void (const TapeBank& bank)> onBankLoaded;
+
+    static constexpr double maxTapeLengthSeconds = 180.0;
+    static constexpr double maxBankTapeLengthSeconds = 30.0;
+
+private:
+    void handleAsyncUpdate() override;
+
+    struct LoadedTape
+    {
+        int slot;
+        GrainTape::Ptr tape;
+        juce::File file;
+    };
+
+    struct BankLoad
+    {
+        TapeBank bank;
+        std::vector<std::unique_ptr<juce::AudioFormatReader>> readers;
+        std::atomic<int> numPending { 0 };
+    };
+
+    void readTape (juce::AudioFormatReader& reader, const juce::File& file, int slot);
+    void readBankTape (BankLoad& load, size_t index);
+
+    juce::AudioFormatManager formatManager;
+    juce::ThreadPool pool { juce::jmax (2, juce::SystemStats::getNumCpus()) };
+
+    juce::CriticalSection lock;
+    std::vector<LoadedTape> loadedTapes;
+    std::vector<TapeBank> loadedBanks;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TapeLoader)
+};
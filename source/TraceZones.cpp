@@ -0,0 +1,108 @@
+/*
+  ==============================================================================
+
+    TraceZones.cpp
+    Created: 23 Oct 2026 3:02:36pm
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#include "TraceZones.h"
+
+#include <juce_events/juce_events.h>
+
+namespace Tracing
+{
+    namespace
+    {
+       #if TAPEPERFORMER_TRACING
+        constexpr int maxThreads = 32;
+
+        // never touched unless something gets traced, so it only costs address space otherwise
+        std::array<ThreadRing, maxThreads> rings;
+       #else
+        std::array<ThreadRing, 0> rings;
+       #endif
+
+        std::atomic<int> numClaimed { 0 };
+
+        // the oldest events in a full ring may be getting overwritten while they're exported
+        constexpr int numUnsafeEvents = 256;
+    }
+
+    ThreadRing* getRingForThisThread() noexcept
+    {
+        thread_local ThreadRing* ring = nullptr;
+        thread_local bool hasTriedToClaim = false;
+
+        if (! hasTriedToClaim)
+        {
+            hasTriedToClaim = true;
+            auto index = numClaimed++;
+
+            if (index < (int) rings.size())
+            {
+                ring = &rings[(size_t) index];
+
+                if (juce::MessageManager::getInstanceWithoutCreating() != nullptr
+                     && juce::MessageManager::getInstanceWithoutCreating()->isThisTheMessageThread())
+                    juce::String ("Message Thread").copyToUTF8 (ring->threadName, sizeof (ring->threadName));
+                else if (auto* thread = juce::Thread::getCurrentThread())
+                    thread->getThreadName().copyToUTF8 (ring->threadName, sizeof (ring->threadName));
+                else
+                    (juce::String ("Thread ") + juce::String (index)).copyToUTF8 (ring->threadName, sizeof (ring->threadName));
+            }
+        }
+
+        return ring;
+    }
+
+    bool writeChromeTrace (const juce::File& file)
+    {
+        juce::FileOutputStream stream (file);
+        if (! stream.openedOk())
+            return false;
+
+        stream.setPosition (0);
+        stream.truncate();
+
+        auto toMicroseconds = [] (juce::int64 ticks)
+        {
+            return juce::Time::highResolutionTicksToSeconds (ticks) * 1.0e6;
+        };
+
+        stream << "{\"traceEvents\":[";
+        bool isFirst = true;
+
+        auto numRings = juce::jmin (numClaimed.load(), (int) rings.size());
+
+        for (int tid = 0; tid < numRings; ++tid)
+        {
+            auto& ring = rings[(size_t) tid];
+
+            stream << (isFirst ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+                   << ",\"args\":{\"name\":" << juce::JSON::toString (juce::String (ring.threadName)) << "}}";
+            isFirst = false;
+
+            auto end = ring.numWritten.load (std::memory_order_acquire);
+            auto start = end > ThreadRing::capacity ? end - ThreadRing::capacity + numUnsafeEvents : 0;
+
+            for (auto i = start; i < end; ++i)
+            {
+                auto event = ring.events[(size_t) (i & (ThreadRing::capacity - 1))];
+                if (event.name == nullptr)
+                    continue;
+
+                stream << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+                       << ",\"ts\":" << juce::String (toMicroseconds (event.startTicks), 3)
+                       << ",\"dur\":" << juce::String (toMicroseconds (event.endTicks - event.startTicks), 3) << "}";
+            }
+        }
+
+        stream << "\n]}\n";
+        stream.flush();
+
+        return stream.getStatus().wasOk();
+    }
+}
@@ -0,0 +1,95 @@
+/*
+  ==============================================================================
+
+    TraceZones.h
+    Created: 23 Oct 2026 3:02:36pm
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#ifndef TAPEPERFORMER_TRACING
+ #define TAPEPERFORMER_TRACING 0
+#endif
+
+//==============================================================================
+/**
+    Timing of the hot paths, for finding out where an xrun came from.
+
+    TP_TRACE_ZONE ("name") at the top of a scope records how long the scope
+    took. The zones only exist when the build has TAPEPERFORMER_TRACING
+    switched on, otherwise the macro is empty and costs nothing.
+
+    Every thread writes into its own ring of the most recent events, so
+    recording never locks or allocates - the rings are claimed from a fixed
+    pool the first time a thread records something. writeChromeTrace() saves
+    what's in the rings in the Chrome trace format, which chrome://tracing
+    and Perfetto can open.
+*/
+namespace Tracing
+{
+    struct Event
+    {
+        const char* name;           // always a string literal
+        juce::int64 startTicks;
+        juce::int64 endTicks;
+    };
+
+    class ThreadRing
+    {
+    public:
+        static constexpr int capacity = 1 << 13;
+
+        /** Only ever called by the thread that owns the ring. */
+        void add (const char* name, juce::int64 startTicks, juce::int64 endTicks) noexcept
+        {
+            auto index = numWritten.load (std::memory_order_relaxed);
+            events[(size_t) (index & (capacity - 1))] = { name, startTicks, endTicks };
+            numWritten.store (index + 1, std::memory_order_release);
+        }
+
+        std::atomic<juce::int64> numWritten { 0 };
+        std::array<Event, capacity> events;
+        char threadName[32] = {};
+    };
+
+    /** The calling thread's ring, or nullptr if every ring has been taken. */
+    ThreadRing* getRingForThisThread() noexcept;
+
+    /** Writes the recorded events of every thread - can be called while they keep recording. */
+    bool writeChromeTrace (const juce::File& file);
+
+    /** True when the build has the trace zones compiled in. */
+    constexpr bool isEnabled() noexcept    { return TAPEPERFORMER_TRACING != 0; }
+
+    class ScopedZone
+    {
+    public:
+        explicit ScopedZone (const char* zoneName) noexcept
+            : name (zoneName), startTicks (juce::Time::getHighResolutionTicks())
+        {
+        }
+
+        ~ScopedZone() noexcept
+        {
+            if (auto* ring = getRingForThisThread())
+                ring->add (name, startTicks, juce::Time::getHighResolutionTicks());
+        }
+
+    private:
+        const char* name;
+        juce::int64 startTicks;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedZone)
+    };
+}
+
+#if TAPEPERFORMER_TRACING
+ #define TP_TRACE_ZONE(name)   const Tracing::ScopedZone JUCE_JOIN_MACRO (traceZone_, __LINE__) (name)
+#else
+ #define TP_TRACE_ZONE(name)
+#endif
@@ -10,6 +10,7 @@
 
 #include <JuceHeader.h>
 #include "WaveDisplay.h"
+#include "TraceZones.h"
 
 //==============================================================================
 WaveDisplay::WaveDisplay(TapePerformerAudioProcessor& p) : audioProcessor(p)
@@ -17,6 +18,45 @@ WaveDisplay::WaveDisplay(TapePerformerAudioProcessor& p) : audioProcessor(p)
     mLoadButton.onClick = [&]() { audioProcessor.loadFile(); };
     addAndMakeVisible(mLoadButton);
 
+    addAndMakeVisible(tempoSyncButton);
+    syncDivisionMenu.addItemList(audioProcessor.apvts.getParameter("syncDivision")->getAllValueStrings(), 1);
+    addAndMakeVisible(syncDivisionMenu);
+
+    tempoSyncAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.apvts, "tempoSync", tempoSyncButton);
+    syncDivisionAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.apvts, "syncDivision", syncDivisionMenu);
+
+    addAndMakeVisible(liveInputButton);
+    addAndMakeVisible(freezeButton);
+    addAndMakeVisible(overdubButton);
+
+    liveInputAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.apvts, "liveInput", liveInputButton);
+    freezeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.apvts, "freeze", freezeButton);
+    overdubAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.apvts, "overdub", overdubButton);
+
+    addAndMakeVisible(resampleButton);
+    resampleAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.apvts, "resample", resampleButton);
+
+    useTakeButton.onClick = [&]() { audioProcessor.swapInResampledTake(); };
+    useTakeButton.setEnabled(false);
+    addAndMakeVisible(useTakeButton);
+
+    for (int slot = 0; slot < GrainSound::numTapeSlots; ++slot)
+        loadSlotMenu.addItem(juce::String::charToString((juce::juce_wchar) ('A' + slot)), slot + 1);
+
+    loadSlotMenu.setSelectedId(audioProcessor.getLoadSlot() + 1, juce::dontSendNotification);
+    loadSlotMenu.onChange = [this] { audioProcessor.setLoadSlot(loadSlotMenu.getSelectedId() - 1); };
+    addAndMakeVisible(loadSlotMenu);
+
+    tapeSlotSlider.setSliderStyle(juce::Slider::SliderStyle::LinearHorizontal);
+    tapeSlotSlider.setTextBoxStyle(juce::Slider::NoTextBox, true, 0, 0);
+    addAndMakeVisible(tapeSlotSlider);
+    tapeSlotAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.apvts, "tapeSlot", tapeSlotSlider);
+
+    addAndMakeVisible(bankModeButton);
+    bankModeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.apvts, "bankMode", bankModeButton);
+
+    playheads.reserve(GrainSnapshot::maxGrains);
+    newPlayheads.reserve(GrainSnapshot::maxGrains);
     startTimer(20);
 }
 
@@ -25,6 +65,7 @@ WaveDisplay::~WaveDisplay()
 
 void WaveDisplay::paint (juce::Graphics& g)
 {
+    TP_TRACE_ZONE ("WaveDisplay::paint");
     
     g.fillAll(juce::Colours::darkgrey);
             
@@ -35,7 +76,7 @@ void WaveDisplay::paint (juce::Graphics& g)
 
     
     
-    if (audioProcessor.thumbnail.getNumChannels() == 0)
+    if (audioProcessor.getPeaks() == nullptr)
     {
         paintIfNoFileLoaded (g, waveFileArea);
     }
@@ -44,8 +85,6 @@ void WaveDisplay::paint (juce::Graphics& g)
         paintIfFileLoaded (g, waveFileArea);
     }
     
-    mLoadButton.setBounds(waveFileArea.getWidth() * 0.95, waveFileArea.getHeight() * 0.02, 40, 20);
-    
     auto waveArea = bounds.removeFromTop(bounds.getHeight());
     g.setColour(juce::Colours::white);
     g.setFont(15.0f);
@@ -61,7 +100,17 @@ void WaveDisplay::resized()
 {
     // This method is where you should set the bounds of any child
     // components that your component contains..
-
+    mLoadButton.setBounds(getWidth() * 0.95, getHeight() * 0.02, 40, 20);
+    tempoSyncButton.setBounds(4, 4, 60, 20);
+    syncDivisionMenu.setBounds(66, 4, 70, 20);
+    liveInputButton.setBounds(146, 4, 60, 20);
+    freezeButton.setBounds(206, 4, 70, 20);
+    overdubButton.setBounds(276, 4, 80, 20);
+    resampleButton.setBounds(366, 4, 90, 20);
+    useTakeButton.setBounds(456, 4, 70, 20);
+    loadSlotMenu.setBounds(536, 4, 50, 20);
+    tapeSlotSlider.setBounds(590, 4, 140, 20);
+    bankModeButton.setBounds(736, 4, 60, 20);
 }
 
 bool WaveDisplay::isInterestedInFileDrag(const juce::StringArray &files)
@@ -72,6 +121,12 @@ bool WaveDisplay::isInterestedInFileDrag(const juce::StringArray &files)
         {
             return true;
         }
+
+        // a folder gets loaded as a bank
+        if (juce::File(file).isDirectory())
+        {
+            return true;
+        }
     }
     return false;
 }
@@ -81,7 +136,11 @@ void WaveDisplay::filesDropped(const juce::StringArray &files, int x, int y)
 {
     for ( const auto& file:files)
     {
-        if (isInterestedInFileDrag(files))
+        if (juce::File(file).isDirectory())
+        {
+            audioProcessor.loadFolder (file);
+        }
+        else if (isInterestedInFileDrag(files))
         {
             audioProcessor.loadFile (file);
         }
@@ -91,81 +150,147 @@ void WaveDisplay::filesDropped(const juce::StringArray &files, int x, int y)
 
 void WaveDisplay::paintIfFileLoaded (juce::Graphics& g, const juce::Rectangle<int>& thumbnailBounds)
 {
+    // waveform and fragments come from the cache, only the playheads are drawn here
+    if (layerImage.isValid())
+    {
+        g.drawImageAt (layerImage, thumbnailBounds.getX(), thumbnailBounds.getY());
+    }
+    else
+    {
+        g.setColour (juce::Colour::fromString("#36ae7c"));
+        g.fillRect (thumbnailBounds);
+    }
 
+    for (auto& playhead : playheads)
+    {
+        if (playhead.x < 0)
+            continue;
 
-    g.setColour (juce::Colour::fromString("#36ae7c"));
-    g.fillRect (thumbnailBounds);
+        //the root note is drawn red
+        if (playhead.isRootNote)
+        {
+            g.setColour (juce::Colours::red);
+            g.drawLine (playhead.x, (float) thumbnailBounds.getY(), playhead.x, (float) thumbnailBounds.getBottom(), 1.5f);
+        }
+        else
+        {
+            g.setColour (juce::Colours::black);
+            g.drawLine (playhead.x, (float) thumbnailBounds.getY(), playhead.x, (float) thumbnailBounds.getBottom(), 1.0f);
+        }
+    }
+}
 
-    //g.setColour (juce::Colours::lightseagreen);
-    g.setColour (juce::Colour::fromString("#F9D923"));
+void WaveDisplay::timerCallback()
+{
+    useTakeButton.setEnabled(audioProcessor.hasResampledTake());
 
+    if (isShowing() != wasShowing)
+    {
+        wasShowing = isShowing();
+        audioProcessor.setEditorVisible(wasShowing);
+    }
 
-    //make draw Wave only when new file is loaded ? or does it need to draw new when draw position is drawn on top??
-    audioProcessor.thumbnail.drawChannels (g, thumbnailBounds, 0.0, audioProcessor.thumbnail.getTotalLength(), 1.0f);
-    
+    layerCache.request(createLayout());
 
-    auto audioLength = (float) audioProcessor.thumbnail.getTotalLength();
-    
-    for (int i = 0; i < audioProcessor.mNumVoices; i++)
+    if (layerCache.getLatestImage(layerImage))
+        repaint();
+
+    updatePlayheads();
+}
+
+WaveLayerCache::Layout WaveDisplay::createLayout() const
+{
+    WaveLayerCache::Layout layout;
+    layout.width = getWidth();
+    layout.height = getHeight();
+
+    layout.peaks = audioProcessor.getPeaks();
+    layout.visibleStart = visibleRange.getStart();
+    layout.visibleEnd = visibleRange.getEnd();
+
+    layout.position = *audioProcessor.apvts.getRawParameterValue("position");
+    layout.spread = *audioProcessor.apvts.getRawParameterValue("spread");
+
+    auto sound = audioProcessor.getTapeSound();
+    if (auto tape = sound->getPrimaryTape())
     {
-                                                      
-        if (auto voice = dynamic_cast<GrainVoice*>(audioProcessor.mSampler.getVoice(i)))
-        {
-//            audioProcessor.wavePlayPosition[i] = voice->getPosition();
-            auto audioPosition = voice->getPosition() /  audioProcessor.getSampleRate();
-
-            auto drawPosition = (audioPosition / audioLength) * (float) thumbnailBounds.getWidth() + (float) thumbnailBounds.getX();
-
-            if (auto sound = dynamic_cast<GrainSound*>(audioProcessor.mSampler.getSound(0).get()))
-            {
-                //get MidiNotenUmber that is trigerred if it is the root than draw red !!needs to be changed here!!!
-                if ( voice->getCurrentMidiNumber() == audioProcessor.midiNoteForNormalPitch )
-                {
-                    g.setColour (juce::Colours::red);
-                    g.drawLine (drawPosition, (float) thumbnailBounds.getY(), drawPosition, (float) thumbnailBounds.getBottom(), 1.5f);
-                }
-                else
-                {
-                    g.setColour (juce::Colours::black);
-                    g.drawLine (drawPosition, (float) thumbnailBounds.getY(), drawPosition, (float) thumbnailBounds.getBottom(), 1.0f);
-                }
-            }
-    
-        }
+        layout.numFragments = sound->getNumKeysAvailable();
+        layout.fragmentLength = sound->getDurationInSamples (*tape) / tape->getLength();
     }
-    
-    
-    if (auto sound = dynamic_cast<GrainSound*>(audioProcessor.mSampler.getSound(0).get()))
+
+    return layout;
+}
+
+void WaveDisplay::updatePlayheads()
+{
+    // positions arrive normalised to their tape, so they map straight onto the width
+    auto& snapshot = audioProcessor.getTelemetry().getLatestSnapshot();
+
+    newPlayheads.clear();
+    for (int i = 0; i < snapshot.numGrains; ++i)
     {
-        auto numFragments = sound->getNumKeysAvailable();
-        auto widthOfFragment = sound->getDurationParam() / audioProcessor.getSampleRate();
-        auto initialXPosition = *audioProcessor.apvts.getRawParameterValue("position") * audioLength;
-        auto& spreadParam = *audioProcessor.apvts.getRawParameterValue("spread");
-        
-        
-        for (int i = 0; i < numFragments; i++)
-        {
-            
-            juce::Rectangle<float> fragmentBounds (initialXPosition / audioLength * thumbnailBounds.getWidth(), 0, widthOfFragment / audioLength * thumbnailBounds.getWidth(), thumbnailBounds.getHeight());
+        auto& grain = snapshot.grains[(size_t) i];
+        auto x = (grain.position - visibleRange.getStart()) / visibleRange.getLength() * getWidth();
 
-            initialXPosition = std::fmod(initialXPosition + (audioLength / numFragments) * spreadParam, audioLength);
-            
-            auto purpleHue = juce::Colours::royalblue.getHue();
-            g.setColour (juce::Colour::fromHSV (purpleHue, .2f, 1.f, 0.4f));
-            g.fillRect (fragmentBounds);
-            
-            if( initialXPosition + widthOfFragment > audioLength)
-            {
-                juce::Rectangle<float> fragmentWrapped (0, 0, ( (initialXPosition + widthOfFragment) - audioLength) / audioLength * thumbnailBounds.getWidth(), thumbnailBounds.getHeight());
-                
-//                auto purpleHue = juce::Colours::darkgrey.getHue();
-//                g.setColour (juce::Colour::fromHSV (purpleHue, 0.3f, 0.5f, 0.25f));
-                g.fillRect (fragmentWrapped);
-                
-            }
-        }
+        if (x >= 0 && x <= getWidth())
+            newPlayheads.push_back ({ (float) x, grain.isRootNote });
+    }
+
+    // only the strips under lines that moved need repainting
+    for (size_t i = 0; i < juce::jmax (playheads.size(), newPlayheads.size()); ++i)
+    {
+        Playhead lastPlayhead, playhead;
+
+        if (i < playheads.size())
+            lastPlayhead = playheads[i];
+
+        if (i < newPlayheads.size())
+            playhead = newPlayheads[i];
+
+        if (playhead.x == lastPlayhead.x && playhead.isRootNote == lastPlayhead.isRootNote)
+            continue;
+
+        if (lastPlayhead.x >= 0)
+            repaint ((int) lastPlayhead.x - 2, 0, 5, getHeight());
+
+        if (playhead.x >= 0)
+            repaint ((int) playhead.x - 2, 0, 5, getHeight());
+    }
+
+    std::swap (playheads, newPlayheads);
+}
+
+void WaveDisplay::mouseWheelMove (const juce::MouseEvent& event, const juce::MouseWheelDetails& wheel)
+{
+    auto peaks = audioProcessor.getPeaks();
+    if (peaks == nullptr || getWidth() <= 0)
+        return;
+
+    auto length = visibleRange.getLength();
+
+    if (event.mods.isShiftDown() || wheel.deltaX != 0)
+    {
+        auto delta = event.mods.isShiftDown() ? wheel.deltaY : wheel.deltaX;
+        visibleRange = visibleRange.movedToStartAt (visibleRange.getStart() - delta * length);
+    }
+    else
+    {
+        // zooming stops at one sample per pixel
+        auto minimumLength = juce::jmin (1.0, getWidth() / (double) peaks->getNumSamples());
+        auto newLength = juce::jlimit (minimumLength, 1.0, length * std::pow (2.0, -wheel.deltaY * 4.0));
+
+        // the point under the mouse stays where it is
+        auto proportion = event.position.x / getWidth();
+        auto anchor = visibleRange.getStart() + proportion * length;
+        visibleRange = { anchor - proportion * newLength, anchor - proportion * newLength + newLength };
     }
 
+    visibleRange = juce::Range<double> (0.0, 1.0).constrainRange (visibleRange);
+}
+
+void WaveDisplay::mouseDoubleClick (const juce::MouseEvent&)
+{
+    visibleRange = { 0.0, 1.0 };
 }
 
 void WaveDisplay::paintIfNoFileLoaded (juce::Graphics& g, const juce::Rectangle<int>& thumbnailBounds)
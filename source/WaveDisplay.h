@@ -12,6 +12,7 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "WaveLayerCache.h"
 
 //==============================================================================
 /*
@@ -19,7 +20,6 @@
 class WaveDisplay  : public juce::Component,
 public juce::FileDragAndDropTarget,
 private juce::Timer
-//, public juce::ChangeListener
 {
 public:
     WaveDisplay(TapePerformerAudioProcessor&);
@@ -30,6 +30,10 @@ public:
     
     bool isInterestedInFileDrag (const juce::StringArray& files) override;
     void filesDropped (const juce::StringArray& files, int x, int y) override;
+
+    /** The wheel zooms in around the mouse, shift + wheel scrolls, a double click shows the whole tape. */
+    void mouseWheelMove (const juce::MouseEvent& event, const juce::MouseWheelDetails& wheel) override;
+    void mouseDoubleClick (const juce::MouseEvent& event) override;
     
     void paintIfFileLoaded(juce::Graphics& g, const juce::Rectangle<int>& thumbnailBounds);
     void paintIfNoFileLoaded (juce::Graphics& g, const juce::Rectangle<int>& thumbnailBounds);
@@ -38,14 +42,53 @@ public:
 private:
     
     juce::TextButton mLoadButton { "Load" };
+
+    juce::ToggleButton tempoSyncButton { "Sync" };
+    juce::ComboBox syncDivisionMenu;
+
+    juce::ToggleButton liveInputButton { "Live" };
+    juce::ToggleButton freezeButton { "Freeze" };
+    juce::ToggleButton overdubButton { "Overdub" };
+
+    juce::ToggleButton resampleButton { "Resample" };
+    juce::TextButton useTakeButton { "Use Take" };
+
+    juce::ComboBox loadSlotMenu;
+    juce::Slider tapeSlotSlider;
+    juce::ToggleButton bankModeButton { "Bank" };
+
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> tempoSyncAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> syncDivisionAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> liveInputAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> freezeAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> overdubAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> resampleAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> tapeSlotAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> bankModeAttachment;
     
-    void timerCallback() override
+    void timerCallback() override;
+
+    WaveLayerCache::Layout createLayout() const;
+    void updatePlayheads();
+
+    struct Playhead
     {
-        repaint();
-    }
+        float x = -1.0f;
+        bool isRootNote = false;
+    };
+
+    std::vector<Playhead> playheads, newPlayheads;
+    juce::Image layerImage;
+    bool wasShowing = false;
+
+    // fractions of the tape
+    juce::Range<double> visibleRange { 0.0, 1.0 };
     
     
     TapePerformerAudioProcessor& audioProcessor;
+
+    // the waveform and fragments only get redrawn in the background when they change
+    WaveLayerCache layerCache;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WaveDisplay)
 };
@@ -0,0 +1,128 @@
+/*
+  ==============================================================================
+
+    WaveLayerCache.cpp
+    Created: 21 Oct 2026 10:12:05am
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#include "WaveLayerCache.h"
+#include "TraceZones.h"
+
+WaveLayerCache::WaveLayerCache()
+    : juce::Thread ("Wave Layer Cache")
+{
+    startThread();
+}
+
+WaveLayerCache::~WaveLayerCache()
+{
+    stopThread (1000);
+}
+
+void WaveLayerCache::request (const Layout& layout)
+{
+    {
+        const juce::ScopedLock sl (lock);
+
+        if (layout == requestedLayout)
+            return;
+
+        requestedLayout = layout;
+        hasRequest = true;
+    }
+
+    notify();
+}
+
+bool WaveLayerCache::getLatestImage (juce::Image& dest)
+{
+    const juce::ScopedLock sl (lock);
+
+    if (! renderedImage.isValid())
+        return false;
+
+    dest = renderedImage;
+    renderedImage = {};
+    return true;
+}
+
+void WaveLayerCache::run()
+{
+    while (! threadShouldExit())
+    {
+        Layout layout;
+
+        {
+            const juce::ScopedLock sl (lock);
+            layout = requestedLayout;
+            hasRequest = false;
+        }
+
+        auto image = render (layout);
+
+        {
+            const juce::ScopedLock sl (lock);
+            renderedImage = image;
+
+            // a newer layout came in while rendering - go again straight away
+            if (hasRequest)
+                continue;
+        }
+
+        wait (-1);
+    }
+}
+
+juce::Image WaveLayerCache::render (const Layout& layout) const
+{
+    TP_TRACE_ZONE ("WaveLayerCache::render");
+    if (layout.width <= 0 || layout.height <= 0)
+        return {};
+
+    // software images can be drawn into from any thread
+    juce::Image image (juce::Image::ARGB, layout.width, layout.height, true, juce::SoftwareImageType());
+    juce::Graphics g (image);
+
+    juce::Rectangle<int> thumbnailBounds (0, 0, layout.width, layout.height);
+
+    g.setColour (juce::Colour::fromString("#36ae7c"));
+    g.fillRect (thumbnailBounds);
+
+    auto visibleLength = layout.visibleEnd - layout.visibleStart;
+    if (layout.peaks == nullptr || visibleLength <= 0)
+        return image;
+
+    auto numSamples = (double) layout.peaks->getNumSamples();
+    layout.peaks->drawChannels (g, thumbnailBounds, layout.visibleStart * numSamples, layout.visibleEnd * numSamples,
+                                juce::Colour::fromString("#F9D923"), juce::Colour::fromString("#FBE87A"));
+
+    auto purpleHue = juce::Colours::royalblue.getHue();
+    g.setColour (juce::Colour::fromHSV (purpleHue, .2f, 1.f, 0.4f));
+
+    // fragments are worked out as fractions of the tape, then mapped onto the visible part
+    auto drawFragment = [&] (double start, double end)
+    {
+        auto left = (start - layout.visibleStart) / visibleLength * layout.width;
+        auto right = (end - layout.visibleStart) / visibleLength * layout.width;
+
+        if (right > 0 && left < layout.width)
+            g.fillRect (juce::Rectangle<double> (left, 0, right - left, layout.height).toFloat());
+    };
+
+    auto fragmentStart = (double) layout.position;
+
+    for (int i = 0; i < layout.numFragments; i++)
+    {
+        drawFragment (fragmentStart, fragmentStart + layout.fragmentLength);
+
+        if (fragmentStart + layout.fragmentLength > 1.0)
+            drawFragment (0.0, fragmentStart + layout.fragmentLength - 1.0);
+
+        fragmentStart = std::fmod (fragmentStart + layout.spread / layout.numFragments, 1.0);
+    }
+
+    return image;
+}
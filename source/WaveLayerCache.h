@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+    WaveLayerCache.h
+    Created: 21 Oct 2026 10:12:05am
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PeakPyramid.h"
+
+//==============================================================================
+/**
+    Renders the waveform and the grain fragments of a WaveDisplay into an image
+    on a background thread.
+
+    The display asks for a new image whenever something the image depends on has
+    changed, and only has to blit the latest one while painting. Requests that
+    come in while an image is being rendered replace each other, so only the
+    newest one gets rendered next.
+*/
+class WaveLayerCache : private juce::Thread
+{
+public:
+    /** Everything the cached image depends on. */
+    struct Layout
+    {
+        int width = 0, height = 0;
+
+        PeakPyramid::Ptr peaks;
+
+        // the part of the tape that's visible, as fractions of its length
+        double visibleStart = 0, visibleEnd = 1;
+
+        float position = 0, spread = 0;
+        int numFragments = 0;
+        double fragmentLength = 0;      // as a fraction of the tape
+
+        bool operator== (const Layout& other) const noexcept
+        {
+            return width == other.width && height == other.height
+                && peaks == other.peaks
+                && visibleStart == other.visibleStart && visibleEnd == other.visibleEnd
+                && position == other.position && spread == other.spread
+                && numFragments == other.numFragments
+                && fragmentLength == other.fragmentLength;
+        }
+
+        bool operator!= (const Layout& other) const noexcept    { return ! operator== (other); }
+    };
+
+    WaveLayerCache();
+    ~WaveLayerCache() override;
+
+    /** Renders the layout in the background unless it's the one that was asked for last. */
+    void request (const Layout& layout);
+
+    /** Moves a newly rendered image into dest, returns false if there's nothing new. */
+    bool getLatestImage (juce::Image& dest);
+
+private:
+    void run() override;
+    juce::Image render (const Layout& layout) const;
+
+    juce::CriticalSection lock;
+    Layout requestedLayout;
+    bool hasRequest = false;
+    juce::Image renderedImage;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WaveLayerCache)
+};
@@ -33,7 +33,7 @@
 
 #pragma once
 
-#include <JuceHeader.h>
+#include <juce_audio_basics/juce_audio_basics.h>
 
 //==============================================================================
 class WavetableEnvelope
@@ -41,6 +41,8 @@ class WavetableEnvelope
 public:
     WavetableEnvelope ()
     {
+        // the table is allocated here so that reshaping it later never has to allocate
+        createWavetableEnv (0.0f);
     }
 
     void setFrequency (float frequency, float sampleRate)
@@ -70,12 +72,13 @@ public:
         return currentSample;
     }
     
-    void createWavetableEnv()
+    /** Recomputes the table - this only allocates the first time, later calls reuse its memory. */
+    void createWavetableEnv (float shape)
     {
-        wavetable.setSize (1, (int) tableSize + 1);
+        wavetable.setSize (1, (int) tableSize + 1, false, false, true);
         auto* samples = wavetable.getWritePointer (0);
 
-        float envShapeParam = envelopeShape * 9.0f + 0.9f;
+        float envShapeParam = shape * 9.0f + 0.9f;
 
         auto angleDelta = juce::MathConstants<double>::pi / (double) (tableSize - 1);
         auto currentAngle = 0.0;
@@ -99,14 +102,19 @@ public:
     {
         currentIndex = 0.0f;
     }
+
+    /** Jumps to a point in the envelope, 0 being the start and 1 the end. */
+    void setPhase (float phase)
+    {
+        auto newTableSize = (float) (wavetable.getNumSamples() - 1);
+        currentIndex = std::fmod (juce::jmax (0.0f, phase) * newTableSize, newTableSize);
+    }
     
-    juce::AudioSampleBuffer getWavetable (){
+    const juce::AudioSampleBuffer& getWavetable() const noexcept
+    {
         return wavetable;
     }
 
-    static float envelopeShape;
-
-
 private:
     juce::AudioSampleBuffer wavetable;
 
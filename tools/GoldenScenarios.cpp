@@ -0,0 +1,241 @@
+/*
+  ==============================================================================
+
+    GoldenScenarios.cpp
+    Created: 23 Oct 2026 10:21:47am
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#include "GoldenScenarios.h"
+
+#include <iostream>
+
+namespace GoldenScenarios
+{
+    namespace
+    {
+        /** A tape that sounds different everywhere, so a wrong position shows up in the output.
+            It's at 44.1 kHz, so the scenarios also cover the sample rate conversion. */
+        GrainTape::Ptr createTape (int seed)
+        {
+            const double sampleRate = 44100.0;
+            const int length = (int) (2.0 * sampleRate);
+
+            auto data = std::make_unique<juce::AudioBuffer<float>> (2, length + GrainTape::padding);
+            juce::Random random (seed);
+
+            for (int i = 0; i < data->getNumSamples(); ++i)
+            {
+                auto time = (i % length) / sampleRate;
+                auto frequency = 110.0 * (1.0 + std::floor (time * 8.0));
+                auto tone = std::sin (juce::MathConstants<double>::twoPi * frequency * time);
+
+                data->setSample (0, i, (float) (0.5 * tone) + 0.05f * (random.nextFloat() - 0.5f));
+                data->setSample (1, i, (float) (0.5 * tone * (1.0 - time * 0.25)) + 0.05f * (random.nextFloat() - 0.5f));
+            }
+
+            // analysed like a loaded file, so the normalise and similarity scenarios have something to work with
+            GrainTape::Ptr tape = new GrainTape ("Golden " + juce::String (seed), std::move (data), length, sampleRate);
+            tape->analyse (nullptr);
+            return tape;
+        }
+
+        /** A few overlapping notes, so voices start and stop at odd positions inside the blocks. */
+        juce::MidiMessageSequence createNotes()
+        {
+            juce::MidiMessageSequence sequence;
+            const int notes[] = { 60, 64, 67, 71, 48 };
+
+            for (int i = 0; i < 5; ++i)
+            {
+                auto start = 0.013 + i * 0.377;
+                sequence.addEvent (juce::MidiMessage::noteOn (1, notes[i], 0.5f + i * 0.1f), start);
+                sequence.addEvent (juce::MidiMessage::noteOff (1, notes[i]), start + 0.9);
+            }
+
+            sequence.updateMatchedPairs();
+            return sequence;
+        }
+
+        Scenario createScenario (const juce::String& name, float tolerance, std::function<void (GrainParameters&)> setUp)
+        {
+            Scenario scenario;
+            scenario.name = name;
+            scenario.tolerance = tolerance;
+
+            auto& job = scenario.job;
+            job.tapeData.push_back (createTape (1));
+            job.midiSequence = createNotes();
+            job.seed = 1234;
+            job.nonRealtime = false;
+            job.sampleRate = 48000.0;
+            job.blockSize = 480;
+            job.tailSeconds = 0.5;
+
+            setUp (job.parameters);
+            return scenario;
+        }
+
+        juce::File getReferenceFile (const juce::File& directory, const Scenario& scenario)
+        {
+            return directory.getChildFile (scenario.name + ".wav");
+        }
+
+        bool matches (const Scenario& scenario, const juce::String& filter)
+        {
+            return filter.isEmpty() || scenario.name.matchesWildcard (filter, true);
+        }
+    }
+
+    std::vector<Scenario> create()
+    {
+        std::vector<Scenario> scenarios;
+
+        // The tolerances follow how much floating point each scenario piles up. Plain playback only differs
+        // in the last bits between compilers. Fast transpositions, Hermite and the crossfade add up more
+        // rounding per sample. The flux modes only move where grains start, so they stay tight - a
+        // wrong step moves a whole grain, which no tolerance here would hide.
+        scenarios.push_back (createScenario ("position-mode", 2.0e-6f, [] (GrainParameters& p) { p.playMode = 0.0f; }));
+        scenarios.push_back (createScenario ("pitch-mode",    4.0e-6f, [] (GrainParameters& p) { p.playMode = 1.0f; }));
+
+        for (int mode = 1; mode <= 5; ++mode)
+        {
+            scenarios.push_back (createScenario ("flux-mode-" + juce::String (mode), 2.0e-6f, [mode] (GrainParameters& p)
+            {
+                p.fluxModeOn = true;
+                p.fluxModes[(size_t) (mode - 1)] = true;
+                p.fluxModeRange = 0.75f;
+                p.duration = 0.05;
+            }));
+        }
+
+        scenarios.push_back (createScenario ("transpose-down", 4.0e-6f, [] (GrainParameters& p) { p.transpose = -48; }));
+        scenarios.push_back (createScenario ("transpose-up",   5.0e-5f, [] (GrainParameters& p) { p.transpose = 48; }));
+        scenarios.push_back (createScenario ("spread-0",       2.0e-6f, [] (GrainParameters& p) { p.spread = 0.0f; }));
+        scenarios.push_back (createScenario ("spread-1",       2.0e-6f, [] (GrainParameters& p) { p.spread = 1.0f; }));
+
+        // a duration of zero gets clamped to the 40 sample minimum grain
+        scenarios.push_back (createScenario ("minimum-duration", 2.0e-6f, [] (GrainParameters& p) { p.duration = 0.0; }));
+
+        scenarios.push_back (createScenario ("tempo-sync", 1.0e-5f, [] (GrainParameters& p)
+        {
+            p.tempoSync = true;
+            p.syncDivision = 4;
+        }));
+
+        scenarios.push_back (createScenario ("envelope-shape", 4.0e-6f, [] (GrainParameters& p) { p.envelopeShape = 1.0f; }));
+
+        // the loudness gains are worked out in float from the tape, so they carry their own rounding
+        scenarios.push_back (createScenario ("normalise", 1.0e-5f, [] (GrainParameters& p) { p.normalise = true; }));
+
+        auto crossfade = createScenario ("tape-crossfade", 1.0e-5f, [] (GrainParameters& p) { p.tapeSlot = 0.5f; });
+        crossfade.job.tapeData.push_back (createTape (2));
+        scenarios.push_back (crossfade);
+
+        auto hermite = createScenario ("non-realtime", 2.0e-5f, [] (GrainParameters& p) { p.transpose = 7; });
+        hermite.job.nonRealtime = true;
+        scenarios.push_back (hermite);
+
+        return scenarios;
+    }
+
+    bool record (const juce::File& directory, const juce::String& filter)
+    {
+        bool ok = true;
+
+        for (auto& scenario : create())
+        {
+            if (! matches (scenario, filter))
+                continue;
+
+            juce::AudioBuffer<float> output;
+            auto result = OfflineRenderer::render (scenario.job, output);
+
+            // 32 bit float, so the reference is exactly what was rendered
+            if (result.wasOk())
+                result = OfflineRenderer::writeWavFile (getReferenceFile (directory, scenario), output, scenario.job.sampleRate, 32);
+
+            std::cout << scenario.name << ": " << (result.wasOk() ? "recorded" : result.getErrorMessage()) << std::endl;
+            ok = ok && result.wasOk();
+        }
+
+        return ok;
+    }
+
+    bool verify (const juce::File& directory, const juce::String& filter)
+    {
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        bool ok = true;
+
+        for (auto& scenario : create())
+        {
+            if (! matches (scenario, filter))
+                continue;
+
+            auto referenceFile = getReferenceFile (directory, scenario);
+            std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (referenceFile));
+
+            if (reader == nullptr)
+            {
+                std::cout << scenario.name << ": FAILED, no reference at " << referenceFile.getFullPathName() << std::endl;
+                ok = false;
+                continue;
+            }
+
+            juce::AudioBuffer<float> reference ((int) reader->numChannels, (int) reader->lengthInSamples);
+            reader->read (&reference, 0, reference.getNumSamples(), 0, true, true);
+
+            juce::AudioBuffer<float> output;
+            auto result = OfflineRenderer::render (scenario.job, output);
+
+            if (result.failed())
+            {
+                std::cout << scenario.name << ": FAILED, " << result.getErrorMessage() << std::endl;
+                ok = false;
+                continue;
+            }
+
+            if (output.getNumChannels() != reference.getNumChannels() || output.getNumSamples() != reference.getNumSamples())
+            {
+                std::cout << scenario.name << ": FAILED, rendered " << output.getNumChannels() << " x " << output.getNumSamples()
+                          << " samples but the reference has " << reference.getNumChannels() << " x " << reference.getNumSamples() << std::endl;
+                ok = false;
+                continue;
+            }
+
+            float maxDifference = 0.0f;
+            int firstDifference = -1;
+
+            for (int channel = 0; channel < output.getNumChannels(); ++channel)
+            {
+                auto* rendered = output.getReadPointer (channel);
+                auto* expected = reference.getReadPointer (channel);
+
+                for (int i = 0; i < output.getNumSamples(); ++i)
+                {
+                    auto difference = std::abs (rendered[i] - expected[i]);
+                    maxDifference = juce::jmax (maxDifference, difference);
+
+                    if (difference > scenario.tolerance && (firstDifference < 0 || i < firstDifference))
+                        firstDifference = i;
+                }
+            }
+
+            const bool passed = maxDifference <= scenario.tolerance;
+            std::cout << scenario.name << ": " << (passed ? "ok" : "FAILED") << ", largest difference " << maxDifference
+                      << " (tolerance " << scenario.tolerance << ")";
+
+            if (! passed)
+                std::cout << ", first at sample " << firstDifference;
+
+            std::cout << std::endl;
+            ok = ok && passed;
+        }
+
+        return ok;
+    }
+}
@@ -0,0 +1,44 @@
+/*
+  ==============================================================================
+
+    GoldenScenarios.h
+    Created: 23 Oct 2026 10:21:47am
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "OfflineRenderer.h"
+
+//==============================================================================
+/**
+    Fixed renders that every change to the grain engine has to reproduce.
+
+    Each scenario renders a generated tape with fixed notes, parameters and
+    seed, so it never depends on files outside the reference directory. Record
+    the reference audio once with a build that's known to sound right, then
+    verify later builds against it - every scenario has its own tolerance for
+    the largest sample difference it accepts.
+
+    The references live in tools/golden. The TapePerformerGoldenRecord target
+    writes them, and ctest runs the verify step.
+*/
+namespace GoldenScenarios
+{
+    struct Scenario
+    {
+        juce::String name;
+        RenderJob job;
+        float tolerance = 0.0f;     // the largest sample difference the scenario accepts, see create()
+    };
+
+    std::vector<Scenario> create();
+
+    /** Writes the reference audio of every scenario whose name matches filter (all of them if it's empty). */
+    bool record (const juce::File& directory, const juce::String& filter);
+
+    /** Renders the scenarios again and compares them with the reference audio, prints a line per scenario. */
+    bool verify (const juce::File& directory, const juce::String& filter);
+}
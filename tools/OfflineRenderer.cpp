@@ -0,0 +1,305 @@
+/*
+  ==============================================================================
+
+    OfflineRenderer.cpp
+    Created: 22 Oct 2026 4:12:09pm
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#include "OfflineRenderer.h"
+#include "TapeLoader.h"
+
+//==============================================================================
+juce::Result Automation::loadFromFile (const juce::File& file, Automation& result)
+{
+    juce::var json;
+    auto parsed = juce::JSON::parse (file.loadFileAsString(), json);
+
+    if (parsed.failed())
+        return juce::Result::fail (file.getFullPathName() + ": " + parsed.getErrorMessage());
+
+    auto* object = json.getDynamicObject();
+    if (object == nullptr)
+        return juce::Result::fail (file.getFullPathName() + ": expected an object of parameter IDs");
+
+    for (auto& property : object->getProperties())
+    {
+        std::vector<Point> points;
+
+        if (auto* array = property.value.getArray())
+            for (auto& point : *array)
+                if (point.isArray() && point.size() >= 2)
+                    points.push_back ({ (double) point[0], (float) point[1] });
+
+        std::sort (points.begin(), points.end(), [] (const Point& a, const Point& b) { return a.time < b.time; });
+
+        if (! points.empty())
+            result.lanes[property.name.toString()] = std::move (points);
+    }
+
+    return juce::Result::ok();
+}
+
+void Automation::apply (double time, GrainParameters& params) const
+{
+    for (auto& lane : lanes)
+    {
+        auto& points = lane.second;
+        auto next = std::upper_bound (points.begin(), points.end(), time, [] (double t, const Point& p) { return t < p.time; });
+
+        float value;
+        if (next == points.begin())
+            value = points.front().value;
+        else if (next == points.end())
+            value = points.back().value;
+        else
+        {
+            auto& previous = *(next - 1);
+            auto proportion = (time - previous.time) / (next->time - previous.time);
+            value = previous.value + (float) proportion * (next->value - previous.value);
+        }
+
+        params.setValue (lane.first, value);
+    }
+}
+
+//==============================================================================
+RenderJob RenderJob::fromVar (const juce::var& job, const juce::File& baseDirectory)
+{
+    RenderJob result;
+
+    auto getFile = [&] (const juce::var& path)
+    {
+        return path.toString().isNotEmpty() ? baseDirectory.getChildFile (path.toString()) : juce::File();
+    };
+
+    if (auto* tapes = job["tapes"].getArray())
+    {
+        for (auto& tape : *tapes)
+            result.tapes.add (getFile (tape));
+    }
+    else if (job.hasProperty ("tape"))
+    {
+        result.tapes.add (getFile (job["tape"]));
+    }
+
+    result.midiFile = getFile (job["midi"]);
+    result.presetFile = getFile (job["preset"]);
+    result.automationFile = getFile (job["automation"]);
+    result.outputFile = getFile (job["output"]);
+
+    if (job.hasProperty ("seed"))         result.seed = (juce::int64) job["seed"];
+    if (job.hasProperty ("sampleRate"))   result.sampleRate = (double) job["sampleRate"];
+    if (job.hasProperty ("blockSize"))    result.blockSize = (int) job["blockSize"];
+    if (job.hasProperty ("bpm"))          result.bpm = (double) job["bpm"];
+    if (job.hasProperty ("length"))       result.lengthSeconds = (double) job["length"];
+    if (job.hasProperty ("tail"))         result.tailSeconds = (double) job["tail"];
+
+    return result;
+}
+
+//==============================================================================
+namespace OfflineRenderer
+{
+    namespace
+    {
+        juce::Result loadMidi (const juce::File& file, juce::MidiMessageSequence& result)
+        {
+            juce::FileInputStream stream (file);
+            juce::MidiFile midiFile;
+
+            if (! stream.openedOk() || ! midiFile.readFrom (stream))
+                return juce::Result::fail ("couldn't read " + file.getFullPathName());
+
+            midiFile.convertTimestampTicksToSeconds();
+
+            for (int track = 0; track < midiFile.getNumTracks(); ++track)
+                result.addSequence (*midiFile.getTrack (track), 0.0);
+
+            result.sort();
+            return juce::Result::ok();
+        }
+    }
+
+    juce::Result loadPreset (const juce::File& file, GrainParameters& params)
+    {
+        auto xml = juce::XmlDocument::parse (file);
+
+        if (xml == nullptr)
+            return juce::Result::fail ("couldn't read " + file.getFullPathName());
+
+        // the same layout the plugin's APVTS writes in getStateInformation()
+        for (auto* param : xml->getChildWithTagNameIterator ("PARAM"))
+            params.setValue (param->getStringAttribute ("id"), (float) param->getDoubleAttribute ("value"));
+
+        return juce::Result::ok();
+    }
+
+    juce::Result render (const RenderJob& job, juce::AudioBuffer<float>& output)
+    {
+        if (job.sampleRate <= 0 || job.blockSize <= 0)
+            return juce::Result::fail ("the sample rate and block size have to be positive");
+
+        if (job.tapes.size() > GrainSound::numTapeSlots || (int) job.tapeData.size() > GrainSound::numTapeSlots)
+            return juce::Result::fail ("there are only " + juce::String (GrainSound::numTapeSlots) + " tape slots");
+
+        auto baseParams = job.parameters;
+        if (job.presetFile != juce::File())
+        {
+            auto result = loadPreset (job.presetFile, baseParams);
+            if (result.failed())
+                return result;
+        }
+
+        Automation automation;
+        if (job.automationFile != juce::File())
+        {
+            auto result = Automation::loadFromFile (job.automationFile, automation);
+            if (result.failed())
+                return result;
+        }
+
+        juce::MidiMessageSequence sequence;
+        double lengthSeconds = job.lengthSeconds;
+
+        if (job.midiFile != juce::File())
+        {
+            auto result = loadMidi (job.midiFile, sequence);
+            if (result.failed())
+                return result;
+
+            lengthSeconds = sequence.getEndTime();
+        }
+        else if (job.midiSequence.getNumEvents() > 0)
+        {
+            sequence = job.midiSequence;
+            sequence.sort();
+            lengthSeconds = sequence.getEndTime();
+        }
+        else
+        {
+            sequence.addEvent (juce::MidiMessage::noteOn (1, TapeEngine::midiNoteForNormalPitch, 0.8f), 0.0);
+            sequence.addEvent (juce::MidiMessage::noteOff (1, TapeEngine::midiNoteForNormalPitch), lengthSeconds);
+        }
+
+        TapeEngine engine;
+        engine.setNonRealtime (job.nonRealtime);
+        engine.setAdaptiveQuality (false);
+        engine.setRandomSeed (job.seed);
+        engine.prepare (job.sampleRate, job.blockSize);
+
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        for (int slot = 0; slot < job.tapes.size(); ++slot)
+        {
+            std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (job.tapes[slot]));
+            auto tape = reader != nullptr ? GrainTape::createFromReader (job.tapes[slot].getFileNameWithoutExtension(), *reader, TapeLoader::maxTapeLengthSeconds)
+                                          : nullptr;
+
+            if (tape == nullptr)
+                return juce::Result::fail ("couldn't read " + job.tapes[slot].getFullPathName());
+
+            tape->analyse (nullptr);
+            engine.setTape (slot, tape);
+        }
+
+        if (job.tapes.isEmpty())
+            for (size_t slot = 0; slot < job.tapeData.size(); ++slot)
+                engine.setTape ((int) slot, job.tapeData[slot]);
+
+        auto totalSamples = (int) std::ceil ((lengthSeconds + job.tailSeconds) * job.sampleRate);
+        output.setSize (2, juce::jmax (0, totalSamples));
+        output.clear();
+
+        juce::AudioBuffer<float> block (2, job.blockSize);
+        juce::MidiBuffer midi;
+        TransportInfo transport;
+        transport.bpm = job.bpm;
+        transport.isPlaying = true;
+
+        int nextEvent = 0;
+
+        // the engine's output is late by its latency, so that much more gets rendered and the start is dropped -
+        // the file lines up with the MIDI like a host's compensated bounce would
+        const auto latency = TapeEngine::getLatencySamples();
+        const auto numToRender = totalSamples + latency;
+
+        for (int start = 0; start < numToRender; start += job.blockSize)
+        {
+            auto numSamples = juce::jmin (job.blockSize, numToRender - start);
+            auto blockStartTime = start / job.sampleRate;
+            auto blockEndTime = (start + numSamples) / job.sampleRate;
+
+            midi.clear();
+            for (; nextEvent < sequence.getNumEvents(); ++nextEvent)
+            {
+                auto& message = sequence.getEventPointer (nextEvent)->message;
+                if (message.getTimeStamp() >= blockEndTime)
+                    break;
+
+                if (! message.isMetaEvent())
+                {
+                    auto offset = juce::jlimit (0, numSamples - 1, (int) ((message.getTimeStamp() - blockStartTime) * job.sampleRate));
+                    midi.addEvent (message, offset);
+                }
+            }
+
+            auto params = baseParams;
+            automation.apply (blockStartTime, params);
+
+            block.setSize (2, numSamples, false, false, true);
+            engine.process (block, nullptr, midi, params, transport);
+
+            auto skip = juce::jlimit (0, numSamples, latency - start);
+
+            for (int channel = 0; channel < output.getNumChannels() && skip < numSamples; ++channel)
+                output.copyFrom (channel, start + skip - latency, block, channel, skip, numSamples - skip);
+
+            transport.ppqPosition += numSamples / job.sampleRate * job.bpm / 60.0;
+        }
+
+        engine.release();
+        return juce::Result::ok();
+    }
+
+    juce::Result renderToFile (const RenderJob& job)
+    {
+        if (job.outputFile == juce::File())
+            return juce::Result::fail ("no output file");
+
+        juce::AudioBuffer<float> output;
+        auto result = render (job, output);
+
+        if (result.failed())
+            return result;
+
+        return writeWavFile (job.outputFile, output, job.sampleRate);
+    }
+
+    juce::Result writeWavFile (const juce::File& file, const juce::AudioBuffer<float>& audio, double sampleRate, int bitsPerSample)
+    {
+        file.deleteFile();
+        file.getParentDirectory().createDirectory();
+
+        auto stream = std::make_unique<juce::FileOutputStream> (file);
+        if (! stream->openedOk())
+            return juce::Result::fail ("couldn't write " + file.getFullPathName());
+
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer (wav.createWriterFor (stream.get(), sampleRate, (unsigned int) audio.getNumChannels(), bitsPerSample, {}, 0));
+
+        if (writer == nullptr)
+            return juce::Result::fail ("couldn't write " + file.getFullPathName());
+
+        // the writer owns the stream now
+        stream.release();
+
+        if (! writer->writeFromAudioSampleBuffer (audio, 0, audio.getNumSamples()))
+            return juce::Result::fail ("couldn't write " + file.getFullPathName());
+
+        return juce::Result::ok();
+    }
+}
@@ -0,0 +1,83 @@
+/*
+  ==============================================================================
+
+    OfflineRenderer.h
+    Created: 22 Oct 2026 4:12:09pm
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "TapeEngine.h"
+
+//==============================================================================
+/**
+    Parameter changes over time, read from a JSON file that maps parameter IDs
+    to [seconds, value] points, e.g. { "position": [[0, 0.1], [30, 0.9]] }.
+    Values are in the same units as the plugin's parameters and get linearly
+    interpolated between the points.
+*/
+struct Automation
+{
+    struct Point
+    {
+        double time;
+        float value;
+    };
+
+    static juce::Result loadFromFile (const juce::File& file, Automation& result);
+
+    /** Writes every automated value at that time into params. */
+    void apply (double time, GrainParameters& params) const;
+
+    std::map<juce::String, std::vector<Point>> lanes;
+};
+
+//==============================================================================
+/** Everything one offline render needs. Relative paths are resolved by whoever builds the job. */
+struct RenderJob
+{
+    juce::Array<juce::File> tapes;          // one per tape slot, in slot order
+    juce::File midiFile;                    // without one a single note at the root is held for lengthSeconds
+    juce::File presetFile;                  // the plugin's saved state as XML
+    juce::File automationFile;
+    juce::File outputFile;
+
+    // the same things given directly, for jobs that are built in code - the files take precedence
+    std::vector<GrainTape::Ptr> tapeData;
+    juce::MidiMessageSequence midiSequence;     // timestamps in seconds
+    GrainParameters parameters;                 // the preset and the automation are applied on top
+
+    juce::int64 seed = 0;
+    bool nonRealtime = true;                    // false renders with the same quality the plugin plays live
+    double sampleRate = 48000.0;
+    int blockSize = 512;
+    double bpm = 120.0;
+    double lengthSeconds = 10.0;            // only used without a MIDI file
+    double tailSeconds = 2.0;               // rendered after the last MIDI event
+
+    /** Reads a job from one entry of a jobs file. */
+    static RenderJob fromVar (const juce::var& job, const juce::File& baseDirectory);
+};
+
+//==============================================================================
+/**
+    Renders jobs through a TapeEngine as fast as the CPU allows.
+
+    Every render gets its own engine, so jobs can run on as many threads as
+    there are cores. The engine runs in non-realtime mode, which gives the
+    voices the highest quality interpolation.
+*/
+namespace OfflineRenderer
+{
+    /** Reads a saved plugin state and applies every parameter in it to params. */
+    juce::Result loadPreset (const juce::File& file, GrainParameters& params);
+
+    juce::Result render (const RenderJob& job, juce::AudioBuffer<float>& output);
+    juce::Result renderToFile (const RenderJob& job);
+
+    juce::Result writeWavFile (const juce::File& file, const juce::AudioBuffer<float>& audio, double sampleRate, int bitsPerSample = 24);
+}
@@ -0,0 +1,595 @@
+/*
+  ==============================================================================
+
+    RealtimeChecker.cpp
+    Created: 22 Oct 2026 10:04:51am
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+// the fortified headers give open() and read() inline bodies of their own, which the replacements below would clash with
+#undef _FORTIFY_SOURCE
+
+#include "RealtimeChecker.h"
+
+#include <cstdarg>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+
+#if JUCE_LINUX
+ #include <dlfcn.h>
+ #include <fcntl.h>
+ #include <pthread.h>
+ #include <time.h>
+ #include <unistd.h>
+#endif
+
+#ifndef TAPEPERFORMER_RT_HARD_FAIL
+ #define TAPEPERFORMER_RT_HARD_FAIL 0
+#endif
+
+namespace RealtimeChecker
+{
+    namespace
+    {
+        // plain thread_locals, so reading them never allocates
+        thread_local int realtimeDepth = 0;
+        thread_local bool isReporting = false;
+
+        std::atomic<bool> strictLocks { false };
+        std::atomic<int> numViolations { 0 };
+
+        struct Violation
+        {
+            ViolationType type;
+            juce::String scenario;
+            juce::String backtrace;
+            int count = 0;
+        };
+
+        // only touched while isReporting is set, so nothing in here is checked itself
+        std::mutex violationLock;
+        std::vector<Violation> violations;
+        juce::String currentScenario;
+
+        bool shouldCheck() noexcept
+        {
+            return realtimeDepth > 0 && ! isReporting;
+        }
+
+        void reportViolation (ViolationType type)
+        {
+            isReporting = true;
+            ++numViolations;
+
+            // everything allocated in here has to be freed again before isReporting is cleared
+            {
+                auto backtrace = juce::SystemStats::getStackBacktrace();
+
+               #if TAPEPERFORMER_RT_HARD_FAIL
+                std::cerr << "real-time violation: " << getName (type) << std::endl
+                          << backtrace << std::endl;
+                std::abort();
+               #else
+                std::lock_guard<std::mutex> sl (violationLock);
+
+                auto existing = std::find_if (violations.begin(), violations.end(), [&] (const Violation& v)
+                {
+                    return v.type == type && v.scenario == currentScenario && v.backtrace == backtrace;
+                });
+
+                if (existing != violations.end())
+                    ++existing->count;
+                else
+                    violations.push_back ({ type, currentScenario, backtrace, 1 });
+               #endif
+            }
+
+            isReporting = false;
+        }
+    }
+
+    juce::String getName (ViolationType type)
+    {
+        switch (type)
+        {
+            case ViolationType::allocation:     return "allocation";
+            case ViolationType::deallocation:   return "deallocation";
+            case ViolationType::contendedLock:  return "contended lock";
+            case ViolationType::lock:           return "lock";
+            case ViolationType::wait:           return "wait";
+            case ViolationType::sleep:          return "sleep";
+            case ViolationType::fileAccess:     return "file access";
+            default:                            break;
+        }
+
+        return {};
+    }
+
+    ScopedRealtime::ScopedRealtime()    { ++realtimeDepth; }
+    ScopedRealtime::~ScopedRealtime()   { --realtimeDepth; }
+
+    bool isSupported()
+    {
+       #if JUCE_LINUX
+        return true;
+       #else
+        return false;
+       #endif
+    }
+
+    void setStrictLocks (bool shouldBeStrict)
+    {
+        strictLocks = shouldBeStrict;
+    }
+
+    void setScenario (const juce::String& name)
+    {
+        jassert (realtimeDepth == 0);
+
+        std::lock_guard<std::mutex> sl (violationLock);
+        currentScenario = name;
+    }
+
+    int getNumViolations()
+    {
+        return numViolations.load();
+    }
+
+    int getNumViolations (const juce::String& scenario)
+    {
+        std::lock_guard<std::mutex> sl (violationLock);
+
+        int total = 0;
+        for (auto& violation : violations)
+            if (violation.scenario == scenario)
+                total += violation.count;
+
+        return total;
+    }
+
+    juce::String createReport()
+    {
+        std::lock_guard<std::mutex> sl (violationLock);
+
+        juce::String report;
+        for (auto& violation : violations)
+        {
+            report << getName (violation.type) << " in \"" << violation.scenario << "\", "
+                   << violation.count << (violation.count == 1 ? " time" : " times") << juce::newLine
+                   << violation.backtrace << juce::newLine;
+        }
+
+        return report;
+    }
+}
+
+//==============================================================================
+#if JUCE_LINUX
+
+using namespace RealtimeChecker;
+
+extern "C"
+{
+    void* __libc_malloc (size_t);
+    void* __libc_calloc (size_t, size_t);
+    void* __libc_realloc (void*, size_t);
+    void __libc_free (void*);
+}
+
+namespace
+{
+    /** Looks up the real function the first time it's needed. dlsym() only
+        calls calloc, which doesn't need looking up, so this can't recurse.
+
+        The version only exists on some architectures - pthread_cond_wait is
+        only versioned GLIBC_2.3.2 on x86, elsewhere the default one is right.
+    */
+    template <typename FunctionType>
+    FunctionType getNext (std::atomic<FunctionType>& function, const char* name, const char* version = nullptr)
+    {
+        auto result = function.load (std::memory_order_acquire);
+
+        if (result == nullptr)
+        {
+            auto* symbol = version != nullptr ? dlvsym (RTLD_NEXT, name, version) : nullptr;
+
+            if (symbol == nullptr)
+                symbol = dlsym (RTLD_NEXT, name);
+
+            result = reinterpret_cast<FunctionType> (symbol);
+            function.store (result, std::memory_order_release);
+        }
+
+        return result;
+    }
+
+    using PosixMemalignFunction = int (*) (void**, size_t, size_t);
+    using AlignedAllocFunction = void* (*) (size_t, size_t);
+    using MutexFunction = int (*) (pthread_mutex_t*);
+    using WaitFunction = int (*) (pthread_cond_t*, pthread_mutex_t*);
+    using TimedWaitFunction = int (*) (pthread_cond_t*, pthread_mutex_t*, const struct timespec*);
+    using NanosleepFunction = int (*) (const struct timespec*, struct timespec*);
+    using ClockNanosleepFunction = int (*) (clockid_t, int, const struct timespec*, struct timespec*);
+    using UsleepFunction = int (*) (useconds_t);
+    using SleepFunction = unsigned int (*) (unsigned int);
+    using OpenFunction = int (*) (const char*, int, ...);
+    using OpenAtFunction = int (*) (int, const char*, int, ...);
+    using FortifiedOpenFunction = int (*) (const char*, int);
+    using CreatFunction = int (*) (const char*, mode_t);
+    using ReadFunction = ssize_t (*) (int, void*, size_t);
+    using FortifiedReadFunction = ssize_t (*) (int, void*, size_t, size_t);
+    using WriteFunction = ssize_t (*) (int, const void*, size_t);
+    using PreadFunction = ssize_t (*) (int, void*, size_t, off_t);
+    using PwriteFunction = ssize_t (*) (int, const void*, size_t, off_t);
+    using Pread64Function = ssize_t (*) (int, void*, size_t, off64_t);
+    using Pwrite64Function = ssize_t (*) (int, const void*, size_t, off64_t);
+    using DescriptorFunction = int (*) (int);
+    using FopenFunction = FILE* (*) (const char*, const char*);
+    using FreadFunction = size_t (*) (void*, size_t, size_t, FILE*);
+    using FwriteFunction = size_t (*) (const void*, size_t, size_t, FILE*);
+    using StreamFunction = int (*) (FILE*);
+
+    std::atomic<PosixMemalignFunction> realPosixMemalign { nullptr };
+    std::atomic<AlignedAllocFunction> realAlignedAlloc { nullptr };
+    std::atomic<MutexFunction> realMutexLock { nullptr }, realMutexTryLock { nullptr };
+    std::atomic<WaitFunction> realCondWait { nullptr };
+    std::atomic<TimedWaitFunction> realCondTimedWait { nullptr };
+    std::atomic<NanosleepFunction> realNanosleep { nullptr };
+    std::atomic<ClockNanosleepFunction> realClockNanosleep { nullptr };
+    std::atomic<UsleepFunction> realUsleep { nullptr };
+    std::atomic<SleepFunction> realSleep { nullptr };
+    std::atomic<OpenFunction> realOpen { nullptr }, realOpen64 { nullptr };
+    std::atomic<OpenAtFunction> realOpenAt { nullptr }, realOpenAt64 { nullptr };
+    std::atomic<FortifiedOpenFunction> realFortifiedOpen { nullptr }, realFortifiedOpen64 { nullptr };
+    std::atomic<CreatFunction> realCreat { nullptr }, realCreat64 { nullptr };
+    std::atomic<ReadFunction> realRead { nullptr };
+    std::atomic<FortifiedReadFunction> realFortifiedRead { nullptr };
+    std::atomic<WriteFunction> realWrite { nullptr };
+    std::atomic<PreadFunction> realPread { nullptr };
+    std::atomic<PwriteFunction> realPwrite { nullptr };
+    std::atomic<Pread64Function> realPread64 { nullptr };
+    std::atomic<Pwrite64Function> realPwrite64 { nullptr };
+    std::atomic<DescriptorFunction> realClose { nullptr }, realFsync { nullptr }, realFdatasync { nullptr };
+    std::atomic<FopenFunction> realFopen { nullptr }, realFopen64 { nullptr };
+    std::atomic<FreadFunction> realFread { nullptr };
+    std::atomic<FwriteFunction> realFwrite { nullptr };
+    std::atomic<StreamFunction> realFflush { nullptr }, realFclose { nullptr };
+
+    void check (ViolationType type)
+    {
+        if (shouldCheck())
+            reportViolation (type);
+    }
+
+    /** open() only has a mode when it creates a file. */
+    mode_t getMode (int flags, va_list args)
+    {
+       #ifdef O_TMPFILE
+        const bool hasMode = (flags & O_CREAT) != 0 || (flags & O_TMPFILE) == O_TMPFILE;
+       #else
+        const bool hasMode = (flags & O_CREAT) != 0;
+       #endif
+
+        return hasMode ? (mode_t) va_arg (args, int) : 0;
+    }
+
+    /** Everything is looked up before main() - dlsym() can allocate, so doing it on a real-time thread would report itself. */
+    struct Resolver
+    {
+        Resolver()
+        {
+            getNext (realPosixMemalign, "posix_memalign");
+            getNext (realAlignedAlloc, "aligned_alloc");
+            getNext (realMutexLock, "pthread_mutex_lock");
+            getNext (realMutexTryLock, "pthread_mutex_trylock");
+            getNext (realCondWait, "pthread_cond_wait", "GLIBC_2.3.2");
+            getNext (realCondTimedWait, "pthread_cond_timedwait", "GLIBC_2.3.2");
+            getNext (realNanosleep, "nanosleep");
+            getNext (realClockNanosleep, "clock_nanosleep");
+            getNext (realUsleep, "usleep");
+            getNext (realSleep, "sleep");
+            getNext (realOpen, "open");
+            getNext (realOpen64, "open64");
+            getNext (realOpenAt, "openat");
+            getNext (realOpenAt64, "openat64");
+            getNext (realFortifiedOpen, "__open_2");
+            getNext (realFortifiedOpen64, "__open64_2");
+            getNext (realCreat, "creat");
+            getNext (realCreat64, "creat64");
+            getNext (realRead, "read");
+            getNext (realFortifiedRead, "__read_chk");
+            getNext (realWrite, "write");
+            getNext (realPread, "pread");
+            getNext (realPwrite, "pwrite");
+            getNext (realPread64, "pread64");
+            getNext (realPwrite64, "pwrite64");
+            getNext (realClose, "close");
+            getNext (realFsync, "fsync");
+            getNext (realFdatasync, "fdatasync");
+            getNext (realFopen, "fopen");
+            getNext (realFopen64, "fopen64");
+            getNext (realFread, "fread");
+            getNext (realFwrite, "fwrite");
+            getNext (realFflush, "fflush");
+            getNext (realFclose, "fclose");
+        }
+    };
+
+    Resolver resolver;
+}
+
+extern "C"
+{
+    void* malloc (size_t size)
+    {
+        check (ViolationType::allocation);
+        return __libc_malloc (size);
+    }
+
+    void* calloc (size_t numElements, size_t elementSize)
+    {
+        check (ViolationType::allocation);
+        return __libc_calloc (numElements, elementSize);
+    }
+
+    void* realloc (void* block, size_t size)
+    {
+        check (ViolationType::allocation);
+        return __libc_realloc (block, size);
+    }
+
+    // over-aligned operator new comes through these instead of malloc
+    int posix_memalign (void** block, size_t alignment, size_t size)
+    {
+        check (ViolationType::allocation);
+        return getNext (realPosixMemalign, "posix_memalign") (block, alignment, size);
+    }
+
+    void* aligned_alloc (size_t alignment, size_t size)
+    {
+        check (ViolationType::allocation);
+        return getNext (realAlignedAlloc, "aligned_alloc") (alignment, size);
+    }
+
+    void free (void* block)
+    {
+        if (block != nullptr)
+            check (ViolationType::deallocation);
+
+        __libc_free (block);
+    }
+
+    int pthread_mutex_lock (pthread_mutex_t* mutex)
+    {
+        if (shouldCheck())
+        {
+            if (strictLocks)
+            {
+                reportViolation (ViolationType::lock);
+            }
+            else
+            {
+                // an uncontended lock never blocks, so it only counts when someone else holds it
+                auto result = getNext (realMutexTryLock, "pthread_mutex_trylock") (mutex);
+                if (result != EBUSY)
+                    return result;
+
+                reportViolation (ViolationType::contendedLock);
+            }
+        }
+
+        return getNext (realMutexLock, "pthread_mutex_lock") (mutex);
+    }
+
+    int pthread_cond_wait (pthread_cond_t* condition, pthread_mutex_t* mutex)
+    {
+        check (ViolationType::wait);
+        return getNext (realCondWait, "pthread_cond_wait", "GLIBC_2.3.2") (condition, mutex);
+    }
+
+    int pthread_cond_timedwait (pthread_cond_t* condition, pthread_mutex_t* mutex, const struct timespec* time)
+    {
+        check (ViolationType::wait);
+        return getNext (realCondTimedWait, "pthread_cond_timedwait", "GLIBC_2.3.2") (condition, mutex, time);
+    }
+
+    int nanosleep (const struct timespec* duration, struct timespec* remaining)
+    {
+        check (ViolationType::sleep);
+        return getNext (realNanosleep, "nanosleep") (duration, remaining);
+    }
+
+    int clock_nanosleep (clockid_t clock, int flags, const struct timespec* time, struct timespec* remaining)
+    {
+        check (ViolationType::sleep);
+        return getNext (realClockNanosleep, "clock_nanosleep") (clock, flags, time, remaining);
+    }
+
+    int usleep (useconds_t microseconds)
+    {
+        check (ViolationType::sleep);
+        return getNext (realUsleep, "usleep") (microseconds);
+    }
+
+    unsigned int sleep (unsigned int seconds)
+    {
+        check (ViolationType::sleep);
+        return getNext (realSleep, "sleep") (seconds);
+    }
+
+    // every call that touches a file descriptor can wait for the disk - or for a pipe or a socket
+    int open (const char* path, int flags, ...)
+    {
+        check (ViolationType::fileAccess);
+
+        va_list args;
+        va_start (args, flags);
+        auto mode = getMode (flags, args);
+        va_end (args);
+
+        return getNext (realOpen, "open") (path, flags, mode);
+    }
+
+    int open64 (const char* path, int flags, ...)
+    {
+        check (ViolationType::fileAccess);
+
+        va_list args;
+        va_start (args, flags);
+        auto mode = getMode (flags, args);
+        va_end (args);
+
+        return getNext (realOpen64, "open64") (path, flags, mode);
+    }
+
+    int openat (int directory, const char* path, int flags, ...)
+    {
+        check (ViolationType::fileAccess);
+
+        va_list args;
+        va_start (args, flags);
+        auto mode = getMode (flags, args);
+        va_end (args);
+
+        return getNext (realOpenAt, "openat") (directory, path, flags, mode);
+    }
+
+    int openat64 (int directory, const char* path, int flags, ...)
+    {
+        check (ViolationType::fileAccess);
+
+        va_list args;
+        va_start (args, flags);
+        auto mode = getMode (flags, args);
+        va_end (args);
+
+        return getNext (realOpenAt64, "openat64") (directory, path, flags, mode);
+    }
+
+    // code built with _FORTIFY_SOURCE calls these instead of open() and read()
+    int __open_2 (const char* path, int flags)
+    {
+        check (ViolationType::fileAccess);
+        return getNext (realFortifiedOpen, "__open_2") (path, flags);
+    }
+
+    int __open64_2 (const char* path, int flags)
+    {
+        check (ViolationType::fileAccess);
+        return getNext (realFortifiedOpen64, "__open64_2") (path, flags);
+    }
+
+    ssize_t __read_chk (int descriptor, void* data, size_t numBytes, size_t bufferSize)
+    {
+        check (ViolationType::fileAccess);
+        return getNext (realFortifiedRead, "__read_chk") (descriptor, data, numBytes, bufferSize);
+    }
+
+    int creat (const char* path, mode_t mode)
+    {
+        check (ViolationType::fileAccess);
+        return getNext (realCreat, "creat") (path, mode);
+    }
+
+    int creat64 (const char* path, mode_t mode)
+    {
+        check (ViolationType::fileAccess);
+        return getNext (realCreat64, "creat64") (path, mode);
+    }
+
+    ssize_t read (int descriptor, void* data, size_t numBytes)
+    {
+        check (ViolationType::fileAccess);
+        return getNext (realRead, "read") (descriptor, data, numBytes);
+    }
+
+    ssize_t write (int descriptor, const void* data, size_t numBytes)
+    {
+        check (ViolationType::fileAccess);
+        return getNext (realWrite, "write") (descriptor, data, numBytes);
+    }
+
+    ssize_t pread (int descriptor, void* data, size_t numBytes, off_t offset)
+    {
+        check (ViolationType::fileAccess);
+        return getNext (realPread, "pread") (descriptor, data, numBytes, offset);
+    }
+
+    ssize_t pwrite (int descriptor, const void* data, size_t numBytes, off_t offset)
+    {
+        check (ViolationType::fileAccess);
+        return getNext (realPwrite, "pwrite") (descriptor, data, numBytes, offset);
+    }
+
+    ssize_t pread64 (int descriptor, void* data, size_t numBytes, off64_t offset)
+    {
+        check (ViolationType::fileAccess);
+        return getNext (realPread64, "pread64") (descriptor, data, numBytes, offset);
+    }
+
+    ssize_t pwrite64 (int descriptor, const void* data, size_t numBytes, off64_t offset)
+    {
+        check (ViolationType::fileAccess);
+        return getNext (realPwrite64, "pwrite64") (descriptor, data, numBytes, offset);
+    }
+
+    int close (int descriptor)
+    {
+        check (ViolationType::fileAccess);
+        return getNext (realClose, "close") (descriptor);
+    }
+
+    int fsync (int descriptor)
+    {
+        check (ViolationType::fileAccess);
+        return getNext (realFsync, "fsync") (descriptor);
+    }
+
+    int fdatasync (int descriptor)
+    {
+        check (ViolationType::fileAccess);
+        return getNext (realFdatasync, "fdatasync") (descriptor);
+    }
+
+    // stdio calls read() and write() inside glibc, where the replacements above don't reach
+    FILE* fopen (const char* path, const char* mode)
+    {
+        check (ViolationType::fileAccess);
+        return getNext (realFopen, "fopen") (path, mode);
+    }
+
+    FILE* fopen64 (const char* path, const char* mode)
+    {
+        check (ViolationType::fileAccess);
+        return getNext (realFopen64, "fopen64") (path, mode);
+    }
+
+    size_t fread (void* data, size_t size, size_t count, FILE* stream)
+    {
+        check (ViolationType::fileAccess);
+        return getNext (realFread, "fread") (data, size, count, stream);
+    }
+
+    size_t fwrite (const void* data, size_t size, size_t count, FILE* stream)
+    {
+        check (ViolationType::fileAccess);
+        return getNext (realFwrite, "fwrite") (data, size, count, stream);
+    }
+
+    int fflush (FILE* stream)
+    {
+        check (ViolationType::fileAccess);
+        return getNext (realFflush, "fflush") (stream);
+    }
+
+    int fclose (FILE* stream)
+    {
+        check (ViolationType::fileAccess);
+        return getNext (realFclose, "fclose") (stream);
+    }
+}
+
+#endif
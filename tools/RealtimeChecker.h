@@ -0,0 +1,71 @@
+/*
+  ==============================================================================
+
+    RealtimeChecker.h
+    Created: 22 Oct 2026 10:04:51am
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+//==============================================================================
+/**
+    Catches the calls that can block a real-time thread: allocating or freeing
+    memory, taking a lock that somebody else holds, waiting on a condition,
+    sleeping and file I/O.
+
+    A thread only gets checked while a ScopedRealtime is alive on it - the
+    harness wraps every call into the engine's process() and the plugin's
+    processBlock() with one. Every
+    violation is recorded with the stack trace that led to it. When the tool is
+    built with TAPEPERFORMER_RT_HARD_FAIL the first violation aborts instead.
+
+    The calls are intercepted by replacing malloc & co., the pthread functions
+    and the file functions (open, read, write, fsync, fopen & co.) in the
+    executable, which only works with glibc - on other
+    platforms isSupported() returns false and nothing gets checked.
+*/
+namespace RealtimeChecker
+{
+    enum class ViolationType
+    {
+        allocation,
+        deallocation,
+        contendedLock,
+        lock,
+        wait,
+        sleep,
+        fileAccess
+    };
+
+    juce::String getName (ViolationType type);
+
+    /** Marks the calling thread as real-time until it goes out of scope. */
+    struct ScopedRealtime
+    {
+        ScopedRealtime();
+        ~ScopedRealtime();
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedRealtime)
+    };
+
+    bool isSupported();
+
+    /** By default only locks that would block are violations - with strict locks
+        every lock taken on a real-time thread is one, even an uncontended one.
+    */
+    void setStrictLocks (bool shouldBeStrict);
+
+    /** The scenario that new violations get attributed to - call this from a thread that isn't real-time. */
+    void setScenario (const juce::String& name);
+
+    int getNumViolations();
+    int getNumViolations (const juce::String& scenario);
+
+    /** Every distinct violation with how often it happened, its scenario and its stack trace. */
+    juce::String createReport();
+}
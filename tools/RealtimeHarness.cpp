@@ -0,0 +1,451 @@
+/*
+  ==============================================================================
+
+    RealtimeHarness.cpp
+    Created: 22 Oct 2026 11:37:26am
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#include "PluginProcessor.h"
+#include "RealtimeChecker.h"
+
+#include <iostream>
+#include <thread>
+
+//==============================================================================
+/**
+    Drives the engine the way a host and a performer would - random parameter
+    changes, tapes and banks being loaded from another thread, and storms of
+    notes - while RealtimeChecker watches every process() call for anything
+    that could block the audio thread. The last scenario does the same through
+    the plugin, with its parameters automated the way a host does it.
+*/
+namespace
+{
+    GrainTape::Ptr createNoiseTape (juce::Random& random, double seconds, double sampleRate)
+    {
+        auto length = juce::jmax (1, (int) (seconds * sampleRate));
+        auto data = std::make_unique<juce::AudioBuffer<float>> (2, length + GrainTape::padding);
+
+        for (int channel = 0; channel < 2; ++channel)
+            for (int i = 0; i < data->getNumSamples(); ++i)
+                data->setSample (channel, i, random.nextFloat() * 2.0f - 1.0f);
+
+        GrainTape::Ptr tape = new GrainTape ("Noise", std::move (data), length, sampleRate);
+        tape->analyse (nullptr);
+        return tape;
+    }
+
+    TapeBank createBank (juce::Random& random, double sampleRate)
+    {
+        TapeBank bank;
+        bank.name = "Noise Bank";
+
+        for (int i = 0; i < 8; ++i)
+        {
+            TapeBank::Zone zone;
+            zone.tape = createNoiseTape (random, 0.1 + random.nextDouble() * 0.5, sampleRate);
+            zone.rootNote = 36 + (i / 2) * 12;
+            zone.velocityLayer = i % 2;
+            bank.zones.push_back (zone);
+        }
+
+        bank.assignZones();
+        return bank;
+    }
+
+    //==============================================================================
+    class Harness
+    {
+    public:
+        Harness (int seed, int blocks)
+            : random (seed), numBlocks (blocks)
+        {
+            engine.prepare (sampleRate, maxBlockSize);
+            engine.setTelemetryEnabled (true);
+
+            for (int slot = 0; slot < GrainSound::numTapeSlots; ++slot)
+                engine.setTape (slot, createNoiseTape (random, 2.0, sampleRate));
+
+            engine.setBank (createBank (random, sampleRate));
+
+            buffer.setSize (2, maxBlockSize);
+            liveInput.setSize (2, maxBlockSize);
+            midi.ensureSize (4096);
+        }
+
+        ~Harness()
+        {
+            engine.release();
+        }
+
+        /** Every block gets new values for all the parameters. */
+        void runParameterSweep()
+        {
+            for (int block = 0; block < numBlocks; ++block)
+            {
+                if (block % 32 == 0)
+                    addChord();
+
+                params.playMode = (float) random.nextInt (2);
+                params.numKeys = random.nextInt (4);
+                params.position = random.nextDouble();
+                params.duration = random.nextDouble();
+                params.spread = random.nextFloat();
+                params.gain = random.nextFloat();
+                params.envelopeShape = random.nextFloat();
+                params.transpose = random.nextInt ({ -48, 49 });
+
+                params.fluxModeOn = random.nextBool();
+                for (auto& mode : params.fluxModes)
+                    mode = random.nextBool();
+                params.fluxModeRange = random.nextFloat();
+
+                params.tempoSync = random.nextBool();
+                params.syncDivision = random.nextInt (6);
+                transport.isPlaying = random.nextBool();
+                transport.bpm = 40.0 + random.nextDouble() * 200.0;
+
+                params.liveInput = random.nextInt (4) == 0;
+                params.freeze = random.nextBool();
+                params.overdub = random.nextBool();
+                params.resample = random.nextInt (8) != 0;
+
+                params.tapeSlot = random.nextFloat() * (float) (GrainSound::numTapeSlots - 1);
+                params.bankMode = random.nextBool();
+
+                params.timeStretch = random.nextBool();
+                params.stretchSpeed = (random.nextFloat() * 2.0f - 1.0f) * GrainParameters::maxStretchSpeed;
+                params.oversampling = random.nextInt (3);
+                params.normalise = random.nextBool();
+
+                for (auto& rate : params.lfoRates)
+                    rate = random.nextFloat() * 20.0f;
+                for (auto& shape : params.lfoShapes)
+                    shape = random.nextInt (ModulationMatrix::numShapes);
+                params.randomRate = random.nextFloat() * 20.0f;
+
+                for (auto& route : params.modulationRoutes)
+                    route = { random.nextInt (ModulationMatrix::numSources), random.nextInt (ModulationMatrix::numDestinations), random.nextFloat() * 2.0f - 1.0f };
+
+                renderBlock();
+            }
+        }
+
+        /** Tapes and banks get swapped in from another thread while the engine keeps playing. */
+        void runTapeLoads()
+        {
+            std::atomic<bool> finished { false };
+
+            std::thread loader ([this, &finished]
+            {
+                juce::Random loaderRandom (random.nextInt());
+
+                while (! finished)
+                {
+                    if (loaderRandom.nextInt (4) == 0)
+                        engine.setBank (createBank (loaderRandom, sampleRate));
+                    else
+                        engine.setTape (loaderRandom.nextInt (GrainSound::numTapeSlots),
+                                        createNoiseTape (loaderRandom, 0.5 + loaderRandom.nextDouble() * 2.0, sampleRate));
+
+                    if (auto take = engine.getFinishedTake())
+                        engine.setTape (0, take);
+
+                    std::this_thread::sleep_for (std::chrono::milliseconds (1 + loaderRandom.nextInt (5)));
+                }
+            });
+
+            params = {};
+
+            for (int block = 0; block < numBlocks; ++block)
+            {
+                if (block % 16 == 0)
+                    addChord();
+
+                // short takes, so the recorder keeps finishing them
+                params.resample = (block / 64) % 2 == 0;
+                params.bankMode = (block / 48) % 2 == 0;
+                params.tapeSlot = (float) (block % 200) / 200.0f * (float) (GrainSound::numTapeSlots - 1);
+
+                renderBlock();
+            }
+
+            finished = true;
+            loader.join();
+        }
+
+        /** Lots of MIDI at random offsets, on every channel. */
+        void runNoteStorm()
+        {
+            params = {};
+
+            for (int block = 0; block < numBlocks; ++block)
+            {
+                params.bankMode = (block / 100) % 2 == 0;
+                auto numSamples = chooseBlockSize();
+
+                for (int i = random.nextInt (65); --i >= 0;)
+                {
+                    auto channel = 1 + random.nextInt (16);
+                    auto position = random.nextInt (numSamples);
+
+                    switch (random.nextInt (8))
+                    {
+                        case 0:  midi.addEvent (juce::MidiMessage::noteOff (channel, random.nextInt (128)), position); break;
+                        case 1:  midi.addEvent (juce::MidiMessage::pitchWheel (channel, random.nextInt (16384)), position); break;
+                        case 2:  midi.addEvent (juce::MidiMessage::controllerEvent (channel, random.nextInt (128), random.nextInt (128)), position); break;
+                        case 3:  if (random.nextInt (32) == 0) midi.addEvent (juce::MidiMessage::allNotesOff (channel), position); break;
+                        default: midi.addEvent (juce::MidiMessage::noteOn (channel, random.nextInt (128), (juce::uint8) random.nextInt (128)), position); break;
+                    }
+                }
+
+                renderBlock (numSamples);
+            }
+        }
+
+    private:
+        int chooseBlockSize()
+        {
+            // hosts don't always stick to one block size
+            return 1 + random.nextInt (maxBlockSize);
+        }
+
+        void addChord()
+        {
+            for (int i = 0; i < TapeEngine::defaultNumVoices; ++i)
+                midi.addEvent (juce::MidiMessage::noteOn (1, 36 + random.nextInt (60), 0.2f + random.nextFloat() * 0.8f), 0);
+        }
+
+        void renderBlock()
+        {
+            renderBlock (chooseBlockSize());
+        }
+
+        void renderBlock (int numSamples)
+        {
+            buffer.setSize (2, numSamples, false, false, true);
+            liveInput.setSize (2, numSamples, false, false, true);
+
+            for (int channel = 0; channel < 2; ++channel)
+                for (int i = 0; i < numSamples; ++i)
+                    liveInput.setSample (channel, i, random.nextFloat() * 0.5f - 0.25f);
+
+            {
+                RealtimeChecker::ScopedRealtime realtime;
+                engine.process (buffer, &liveInput, midi, params, transport);
+            }
+
+            midi.clear();
+            transport.ppqPosition += numSamples / sampleRate * transport.bpm / 60.0;
+        }
+
+        static constexpr double sampleRate = 48000.0;
+        static constexpr int maxBlockSize = 1024;
+
+        juce::Random random;
+        const int numBlocks;
+
+        TapeEngine engine;
+        juce::AudioBuffer<float> buffer, liveInput;
+        juce::MidiBuffer midi;
+        GrainParameters params;
+        TransportInfo transport;
+    };
+
+    //==============================================================================
+    /** The whole plugin: parameters set from the audio thread between blocks, like host automation, and
+        tapes and banks loaded through the plugin's own loader while it plays. Needs a message thread.
+    */
+    class PluginHarness
+    {
+    public:
+        PluginHarness (int seed, int blocks)
+            : random (seed), numBlocks (blocks),
+              parameters (processor.apvts.processor.getParameters())
+        {
+            processor.setRateAndBufferSizeDetails (sampleRate, maxBlockSize);
+            processor.prepareToPlay (sampleRate, maxBlockSize);
+
+            buffer.setSize (juce::jmax (processor.getTotalNumInputChannels(), processor.getTotalNumOutputChannels()), maxBlockSize);
+            midi.ensureSize (4096);
+
+            // tapes named after their root notes, so the folder loads as a bank
+            tapeFolder.createDirectory();
+
+            for (auto note : { "C2", "C3", "C4", "C5" })
+                writeNoiseTape (tapeFolder.getChildFile (juce::String (note) + ".wav"));
+        }
+
+        ~PluginHarness()
+        {
+            processor.releaseResources();
+            tapeFolder.deleteRecursively();
+        }
+
+        void runAutomation()
+        {
+            for (int block = 0; block < numBlocks; ++block)
+            {
+                if (block % 200 == 0)
+                    loadTapes();
+
+                if (block % 32 == 0)
+                    for (int i = 0; i < TapeEngine::defaultNumVoices; ++i)
+                        midi.addEvent (juce::MidiMessage::noteOn (1, 36 + random.nextInt (60), 0.2f + random.nextFloat() * 0.8f), 0);
+
+                auto numSamples = 1 + random.nextInt (maxBlockSize);
+                buffer.setSize (buffer.getNumChannels(), numSamples, false, false, true);
+
+                for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+                    for (int i = 0; i < numSamples; ++i)
+                        buffer.setSample (channel, i, random.nextFloat() * 0.5f - 0.25f);
+
+                {
+                    RealtimeChecker::ScopedRealtime realtime;
+
+                    // a host sends the automation on the audio thread, right before the block it belongs to
+                    for (int i = random.nextInt (8); --i >= 0;)
+                        parameters[random.nextInt (parameters.size())]->setValueNotifyingHost (random.nextFloat());
+
+                    processor.processBlock (buffer, midi);
+                }
+
+                midi.clear();
+            }
+        }
+
+    private:
+        void writeNoiseTape (const juce::File& file)
+        {
+            juce::AudioBuffer<float> noise (2, (int) (sampleRate * (0.2 + random.nextDouble())));
+
+            for (int channel = 0; channel < noise.getNumChannels(); ++channel)
+                for (int i = 0; i < noise.getNumSamples(); ++i)
+                    noise.setSample (channel, i, random.nextFloat() * 2.0f - 1.0f);
+
+            auto stream = std::make_unique<juce::FileOutputStream> (file);
+            juce::WavAudioFormat wav;
+
+            if (std::unique_ptr<juce::AudioFormatWriter> writer { wav.createWriterFor (stream.get(), sampleRate, 2, 24, {}, 0) })
+            {
+                stream.release();
+                writer->writeFromAudioSampleBuffer (noise, 0, noise.getNumSamples());
+            }
+        }
+
+        /** Loads go through the message thread, the way the editor starts them. */
+        void loadTapes()
+        {
+            auto files = tapeFolder.findChildFiles (juce::File::findFiles, false, "*.wav");
+            auto folder = tapeFolder.getFullPathName();
+
+            juce::MessageManager::callAsync ([this, files, folder, slot = random.nextInt (GrainSound::numTapeSlots)]
+            {
+                processor.swapInResampledTake();
+                processor.setLoadSlot (slot);
+
+                for (auto& file : files)
+                    processor.loadFile (file.getFullPathName());
+
+                processor.loadFolder (folder);
+            });
+        }
+
+        static constexpr double sampleRate = 48000.0;
+        static constexpr int maxBlockSize = 1024;
+
+        juce::Random random;
+        const int numBlocks;
+
+        const juce::File tapeFolder { juce::File::getSpecialLocation (juce::File::tempDirectory)
+                                        .getNonexistentChildFile ("TapePerformerRealtimeHarness", {}, false) };
+        TapePerformerAudioProcessor processor;
+        const juce::Array<juce::AudioProcessorParameter*>& parameters;
+
+        juce::AudioBuffer<float> buffer;
+        juce::MidiBuffer midi;
+    };
+
+    /** Runs on its own thread, while this one delivers the loaded tapes like a message thread does. */
+    void runPluginAutomation (int seed, int numBlocks)
+    {
+        juce::ScopedJuceInitialiser_GUI messageThread;
+
+        {
+            PluginHarness harness (seed, numBlocks);
+
+            std::thread audioThread ([&harness]
+            {
+                harness.runAutomation();
+                juce::MessageManager::getInstance()->stopDispatchLoop();
+            });
+
+            juce::MessageManager::getInstance()->runDispatchLoop();
+            audioThread.join();
+        }
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    int numBlocks = 4000, seed = 1;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        juce::String arg (argv[i]);
+
+        if (arg == "--blocks" && i + 1 < argc)
+            numBlocks = juce::jmax (1, juce::String (argv[++i]).getIntValue());
+        else if (arg == "--seed" && i + 1 < argc)
+            seed = juce::String (argv[++i]).getIntValue();
+        else if (arg == "--strict-locks")
+            RealtimeChecker::setStrictLocks (true);
+        else
+        {
+            std::cerr << "usage: TapePerformerRealtimeHarness [--blocks <n>] [--seed <n>] [--strict-locks]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (! RealtimeChecker::isSupported())
+    {
+        std::cerr << "the real-time checks need glibc, nothing would be caught on this platform" << std::endl;
+        return 1;
+    }
+
+    struct Scenario
+    {
+        const char* name;
+        void (Harness::*run)();
+    };
+
+    const Scenario scenarios[] = { { "parameter sweep", &Harness::runParameterSweep },
+                                   { "tape loads",      &Harness::runTapeLoads },
+                                   { "note storm",      &Harness::runNoteStorm } };
+
+    for (auto& scenario : scenarios)
+    {
+        RealtimeChecker::setScenario (scenario.name);
+
+        {
+            Harness harness (seed, numBlocks);
+            (harness.*scenario.run)();
+        }
+
+        std::cout << scenario.name << ": " << RealtimeChecker::getNumViolations (scenario.name) << " violations" << std::endl;
+    }
+
+    RealtimeChecker::setScenario ("plugin automation");
+    runPluginAutomation (seed, numBlocks);
+    std::cout << "plugin automation: " << RealtimeChecker::getNumViolations ("plugin automation") << " violations" << std::endl;
+
+    if (RealtimeChecker::getNumViolations() == 0)
+        return 0;
+
+    std::cout << std::endl << RealtimeChecker::createReport() << std::endl;
+    return 1;
+}
@@ -0,0 +1,164 @@
+/*
+  ==============================================================================
+
+    RenderMain.cpp
+    Created: 22 Oct 2026 4:12:09pm
+    Author:  Abdullah Ismailogullari
+
+  ==============================================================================
+*/
+
+#include "OfflineRenderer.h"
+#include "GoldenScenarios.h"
+#include "TraceZones.h"
+
+#include <iostream>
+
+namespace
+{
+    void printUsage()
+    {
+        std::cerr << "usage: TapePerformerRender --tape <file> [--tape <file>...] [--midi <file.mid>] [--preset <state.xml>]" << std::endl
+                  << "                           [--automation <file.json>] [--seed <n>] [--sample-rate <hz>] [--block-size <n>]" << std::endl
+                  << "                           [--bpm <n>] [--length <seconds>] [--tail <seconds>] --output <file.wav>" << std::endl
+                  << "       TapePerformerRender --jobs <jobs.json> [--threads <n>] [--trace <file.json>]" << std::endl
+                  << "       TapePerformerRender --golden-record <dir> | --golden-verify <dir> [--scenario <wildcard>]" << std::endl
+                  << std::endl
+                  << "A jobs file is an array of objects with the same keys: tape or tapes, midi, preset, automation," << std::endl
+                  << "seed, sampleRate, blockSize, bpm, length, tail and output. Paths are relative to the jobs file." << std::endl
+                  << std::endl
+                  << "--golden-record writes the reference audio of the built-in scenarios, --golden-verify renders them" << std::endl
+                  << "again and fails if any of them differs from its reference by more than its tolerance." << std::endl
+                  << std::endl
+                  << "--trace saves the trace zones of the render as Chrome trace JSON, for a build with TAPEPERFORMER_TRACING." << std::endl;
+    }
+
+    struct GoldenOptions
+    {
+        juce::File recordDirectory, verifyDirectory;
+        juce::String filter;
+    };
+
+    bool parseJob (const juce::StringArray& args, RenderJob& job, juce::File& jobsFile, int& numThreads,
+                   GoldenOptions& golden, juce::File& traceFile)
+    {
+        auto cwd = juce::File::getCurrentWorkingDirectory();
+
+        for (int i = 0; i < args.size(); ++i)
+        {
+            auto& arg = args[i];
+
+            if (i + 1 >= args.size())
+                return false;
+
+            auto value = args[++i];
+
+            if      (arg == "--tape")           job.tapes.add (cwd.getChildFile (value));
+            else if (arg == "--midi")           job.midiFile = cwd.getChildFile (value);
+            else if (arg == "--preset")         job.presetFile = cwd.getChildFile (value);
+            else if (arg == "--automation")     job.automationFile = cwd.getChildFile (value);
+            else if (arg == "--output")         job.outputFile = cwd.getChildFile (value);
+            else if (arg == "--seed")           job.seed = value.getLargeIntValue();
+            else if (arg == "--sample-rate")    job.sampleRate = value.getDoubleValue();
+            else if (arg == "--block-size")     job.blockSize = value.getIntValue();
+            else if (arg == "--bpm")            job.bpm = value.getDoubleValue();
+            else if (arg == "--length")         job.lengthSeconds = value.getDoubleValue();
+            else if (arg == "--tail")           job.tailSeconds = value.getDoubleValue();
+            else if (arg == "--jobs")           jobsFile = cwd.getChildFile (value);
+            else if (arg == "--threads")        numThreads = juce::jmax (1, value.getIntValue());
+            else if (arg == "--golden-record")  golden.recordDirectory = cwd.getChildFile (value);
+            else if (arg == "--golden-verify")  golden.verifyDirectory = cwd.getChildFile (value);
+            else if (arg == "--scenario")       golden.filter = value;
+            else if (arg == "--trace")          traceFile = cwd.getChildFile (value);
+            else                                return false;
+        }
+
+        return true;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add (argv[i]);
+
+    RenderJob commandLineJob;
+    juce::File jobsFile;
+    int numThreads = juce::SystemStats::getNumCpus();
+    GoldenOptions golden;
+    juce::File traceFile;
+
+    if (args.isEmpty() || ! parseJob (args, commandLineJob, jobsFile, numThreads, golden, traceFile))
+    {
+        printUsage();
+        return 1;
+    }
+
+    if (golden.recordDirectory != juce::File())
+        return GoldenScenarios::record (golden.recordDirectory, golden.filter) ? 0 : 1;
+
+    if (golden.verifyDirectory != juce::File())
+        return GoldenScenarios::verify (golden.verifyDirectory, golden.filter) ? 0 : 1;
+
+    std::vector<RenderJob> jobs;
+
+    if (jobsFile != juce::File())
+    {
+        auto json = juce::JSON::parse (jobsFile);
+
+        if (auto* array = json.getArray())
+            for (auto& job : *array)
+                jobs.push_back (RenderJob::fromVar (job, jobsFile.getParentDirectory()));
+
+        if (jobs.empty())
+        {
+            std::cerr << "no jobs in " << jobsFile.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+    else
+    {
+        jobs.push_back (commandLineJob);
+    }
+
+    // one engine per job, so the jobs never share anything but the pool
+    juce::ThreadPool pool (juce::jmin (numThreads, (int) jobs.size()));
+    juce::CriticalSection printLock;
+    std::atomic<int> numFailed { 0 };
+
+    for (auto& job : jobs)
+    {
+        pool.addJob ([&job, &printLock, &numFailed]
+        {
+            auto startTime = juce::Time::getMillisecondCounterHiRes();
+            auto result = OfflineRenderer::renderToFile (job);
+            auto seconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+
+            const juce::ScopedLock sl (printLock);
+
+            if (result.failed())
+            {
+                ++numFailed;
+                std::cerr << job.outputFile.getFileName() << ": " << result.getErrorMessage() << std::endl;
+                return;
+            }
+
+            std::cout << job.outputFile.getFullPathName() << " (" << juce::String (seconds, 2) << " s)" << std::endl;
+        });
+    }
+
+    while (pool.getNumJobs() > 0)
+        juce::Thread::sleep (20);
+
+    if (traceFile != juce::File())
+    {
+        if (! Tracing::isEnabled())
+            std::cerr << "--trace needs a build with TAPEPERFORMER_TRACING switched on" << std::endl;
+        else if (! Tracing::writeChromeTrace (traceFile))
+            std::cerr << "couldn't write " << traceFile.getFullPathName() << std::endl;
+    }
+
+    return numFailed == 0 ? 0 : 1;
+}